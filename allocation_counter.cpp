@@ -0,0 +1,27 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "allocation_counter.h"
+
+/* Any executable that links the engine library gets these instead of the standard ones.
+The count is a relaxed atomic increment, which is negligible next to the malloc itself.
+'new[]' and the nothrow versions call these by default, so they're counted as well. */
+static std::atomic<unsigned long long int> allocation_count(0);
+
+void* operator new(std::size_t size){
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept{
+    std::free(ptr);
+}
+
+unsigned long long int allocationCount(){
+    return allocation_count.load(std::memory_order_relaxed);
+}
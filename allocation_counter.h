@@ -0,0 +1,8 @@
+#ifndef GAME_OF_LIFE_ALLOCATION_COUNTER_H
+#define GAME_OF_LIFE_ALLOCATION_COUNTER_H
+
+/* Counts the heap allocations of the whole program (of all the threads), by replacing the global 'operator new' (see allocation_counter.cpp).
+Used by 'gol-bench' and by the profiler, to tell how many allocations a generation (or a phase) makes. */
+unsigned long long int allocationCount();
+
+#endif
@@ -45,12 +45,13 @@ short int AutomatonMenuScreen::run(){
     int rectangle_index;
     sf::IntRect hovered_rectangle_bounds;
     sf::Text* hovered_menu_option;
+    bool is_hover_stale = true;
 
+    frame_scheduler.requestRedraw(); // The screen before us drew something else
     while (true) {
-        handleHover(hovering, rectangle_index, nullptr, hovered_menu_option, hovered_rectangle_bounds);
-
         sf::Event evnt;
-        while (window.pollEvent(evnt)){
+        while (frame_scheduler.pollEvent(window, evnt)){
+            is_hover_stale = true;
             switch (evnt.type){
                 case sf::Event::Closed:
                     return -1;
@@ -72,8 +73,8 @@ short int AutomatonMenuScreen::run(){
                     hovered_menu_option->setFillColor(option_not_chosen_color); // Reset color of chosen menu option
 
                     if (rectangle_index != 1){ // Not custom rulestring
-                        born_digits = automaton_name_to_born_and_survive_sets.at(automaton_name).first;
-                        survive_digits = automaton_name_to_born_and_survive_sets.at(automaton_name).second;
+                        const auto& born_and_survive_sets = automaton_name_to_born_and_survive_sets.at(automaton_name);
+                        rule = Rule(born_and_survive_sets.first, born_and_survive_sets.second);
                         return PATTERN_MENU_SCREEN;
                     }
                     else return RULESTRING_MENU_SCREEN;
@@ -87,6 +88,13 @@ short int AutomatonMenuScreen::run(){
             }
         }
 
+        // Nothing here changes but by an event, and the hover too can only change after one (the mouse moved, or we scrolled under it)
+        if (is_hover_stale){
+            is_hover_stale = false;
+            if (handleHover(hovering, rectangle_index, nullptr, hovered_menu_option, hovered_rectangle_bounds)) frame_scheduler.requestRedraw();
+        }
+        if (!frame_scheduler.startFrame()) continue;
+
         window.clear();
 
         drawText();
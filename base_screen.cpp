@@ -9,12 +9,10 @@ sf::Cursor BaseScreen::cursor;
 sf::Vector2f BaseScreen::left_top_view_pos(0.f,0.f);
 // 1st and 2nd arguments are left-top coordinate of the rectangle. 3rd and 4th arguments are its width and height respectively.
 sf::View BaseScreen::view(sf::FloatRect(0, 0, window.getSize().x, window.getSize().y));
+FrameScheduler BaseScreen::frame_scheduler;
 
-std::set<short int> BaseScreen::born_digits;
-std::set<short int> BaseScreen::survive_digits;
-std::unordered_set<sf::Vector2i, pair_hash, pair_equal> BaseScreen::grid;
-
-sf::Clock BaseScreen::code_timer;
+Rule BaseScreen::rule;
+std::unique_ptr<Engine> BaseScreen::grid = createEngine(DEFAULT_ENGINE);
 
 // Grid's width and height are set to a huge number, determined by MULTIPLE
 BaseScreen::BaseScreen(): important_color(sf::Color::Magenta), grid_width(window.getSize().x * MULTIPLE), grid_height(window.getSize().y * MULTIPLE) {
@@ -49,20 +47,3 @@ void BaseScreen::resize(const sf::Event& evnt, int height){
     view.reset(sf::FloatRect(left_top_view_pos.x, left_top_view_pos.y, window.getSize().x, window.getSize().y));
     window.setView(view);
 }
-
-// For logging. when called with 'reset=true', it resets and starts counting.
-// When called with 'reset=false', it prints time passed (in ms) since *reset*.
-// If we call without ever resetting, it counts since construction of the clock object.
-void BaseScreen::printLogTime(bool reset){
-    if (reset) code_timer.restart();
-    else std::cout << code_timer.getElapsedTime().asMilliseconds() << std::endl;
-}
-
-// Same as above, only it returns the elapsed time instead of printing it.
-long long int BaseScreen::getLogTime(bool reset){
-    if (reset){
-        code_timer.restart();
-        return 0;
-    }
-    else return code_timer.getElapsedTime().asMilliseconds();
-}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef GAME_OF_LIFE_BIT_UTILS_H
+#define GAME_OF_LIFE_BIT_UTILS_H
+
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// C++17 doesn't have <bit> yet, so we wrap the compiler builtins ourselves.
+
+inline int popcount64(uint64_t word){
+#ifdef _MSC_VER
+    return (int)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// Index of the lowest set bit. 'word' must not be 0.
+inline int countTrailingZeros64(uint64_t word){
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Amount of zeros above the highest set bit. 'word' must not be 0.
+inline int countLeadingZeros64(uint64_t word){
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return 63 - (int)index;
+#else
+    return __builtin_clzll(word);
+#endif
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef GAME_OF_LIFE_CELL_H
+#define GAME_OF_LIFE_CELL_H
+
+#include <cstdint>
+
+#define BITMAP_TILE_SIZE 64 // Must be equal to the amount of bits in a row word
+
+/* The engine doesn't know anything about SFML (so it can run on display-less machines),
+so it has its own coordinate type instead of 'sf::Vector2i'. */
+struct Cell{
+    int x, y;
+};
+
+// Inclusive bounds of a set of cells. When the set is empty, 'right < left'.
+struct BoundingBox{
+    int left, top, right, bottom;
+
+    int width() const { return right - left + 1; }
+    int height() const { return bottom - top + 1; }
+};
+
+/* A 64x64 square of cells, whose top-left cell is (64 * tile_x, 64 * tile_y). Bit 'i' of 'rows[j]' is the cell in column 'i' and row 'j' of the square.
+It's the layout of the tiled engine and of checkpoint files, so it's copied between them as it is. */
+struct BitmapTile{
+    int32_t tile_x, tile_y;
+    uint64_t rows[BITMAP_TILE_SIZE];
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include "checkpoint.h"
+#include "bit_utils.h"
+#include "mapped_file.h"
+#include "profiler.h"
+
+#define MAX_TILE_COORDINATE (1 << 25) // Tiles beyond it have cells outside of 'int' coordinates
+
+static_assert(sizeof(CheckpointHeader) % 8 == 0 && sizeof(BitmapTile) % 8 == 0, "The tiles of a mapped checkpoint must be 8-byte aligned");
+
+checkpoint_status saveCheckpoint(const std::string& file_path, const Engine& engine, const Rule& rule, const CheckpointViewport& viewport){
+    PROFILE_SCOPE("saveCheckpoint");
+    std::string temp_path = file_path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary);
+    if (!file) return CHECKPOINT_FILE_ERROR;
+
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.header_size = sizeof(CheckpointHeader);
+    header.generation = engine.getGeneration();
+    header.population = engine.population();
+    header.born_mask = rule.getBornMask();
+    header.survive_mask = rule.getSurviveMask();
+    header.has_viewport = viewport.is_set;
+    header.view_left = viewport.left;
+    header.view_top = viewport.top;
+    header.view_zoom = viewport.zoom;
+
+    // The amount of tiles is known only once they're written, so the header is written again at the end
+    file.write((const char*)&header, sizeof(header));
+    engine.forEachTile([&file, &header](const BitmapTile& tile){
+        file.write((const char*)&tile, sizeof(tile));
+        header.tile_count++;
+    });
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    file.close();
+
+    std::error_code error;
+    if (!file || (std::filesystem::rename(temp_path, file_path, error), error)){
+        std::filesystem::remove(temp_path, error);
+        return CHECKPOINT_FILE_ERROR;
+    }
+
+    return CHECKPOINT_OK;
+}
+
+static std::set<short int> maskDigits(uint32_t mask){
+    std::set<short int> digits;
+    for (short int digit = 0; digit <= 8; digit++){
+        if (mask >> digit & 1) digits.insert(digit);
+    }
+
+    return digits;
+}
+
+checkpoint_status loadCheckpoint(const std::string& file_path, Engine& engine, Rule& rule, CheckpointViewport& viewport){
+    PROFILE_SCOPE("loadCheckpoint");
+    MappedFile file;
+    if (!file.open(file_path)) return CHECKPOINT_FILE_ERROR;
+
+    CheckpointHeader header;
+    if (file.size() < sizeof(header)) return CHECKPOINT_FORMAT_ERROR;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.byte_order != CHECKPOINT_BYTE_ORDER) return CHECKPOINT_FORMAT_ERROR;
+    if (header.version != CHECKPOINT_VERSION) return CHECKPOINT_VERSION_ERROR;
+
+    if (header.header_size < sizeof(header) || header.header_size % 8 != 0 || 0x1FF < (header.born_mask | header.survive_mask)) return CHECKPOINT_FORMAT_ERROR;
+    if (file.size() < header.header_size || (file.size() - header.header_size) / sizeof(BitmapTile) != header.tile_count || (file.size() - header.header_size) % sizeof(BitmapTile) != 0){
+        return CHECKPOINT_FORMAT_ERROR;
+    }
+
+    // The mapping is page-aligned, so the tiles are aligned as well, and they're used as they are
+    const BitmapTile* tiles = (const BitmapTile*)(file.data() + header.header_size);
+    uint64_t population = 0;
+    for (uint64_t i = 0; i < header.tile_count; i++){
+        if (tiles[i].tile_x < -MAX_TILE_COORDINATE || MAX_TILE_COORDINATE <= tiles[i].tile_x ||
+            tiles[i].tile_y < -MAX_TILE_COORDINATE || MAX_TILE_COORDINATE <= tiles[i].tile_y) return CHECKPOINT_FORMAT_ERROR;
+        for (const auto& row : tiles[i].rows) population += popcount64(row);
+    }
+    if (population != header.population) return CHECKPOINT_FORMAT_ERROR; // A truncated or corrupted file
+
+    rule = Rule(maskDigits(header.born_mask), maskDigits(header.survive_mask));
+    viewport = {header.has_viewport != 0, header.view_left, header.view_top, header.view_zoom};
+
+    engine.clear();
+    engine.setRule(rule);
+    engine.insertTiles(tiles, header.tile_count);
+    engine.skipGenerations(header.generation);
+
+    return CHECKPOINT_OK;
+}
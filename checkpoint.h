@@ -0,0 +1,45 @@
+#ifndef GAME_OF_LIFE_CHECKPOINT_H
+#define GAME_OF_LIFE_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include "engine.h"
+
+#define CHECKPOINT_MAGIC "GOLCKPT" // With the terminating '\0', it's the first 8 bytes of the file
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_BYTE_ORDER 0x01020304 // Written as a native integer, so a file from a machine of the other byte order is recognized
+
+enum checkpoint_status {CHECKPOINT_OK, CHECKPOINT_FILE_ERROR, CHECKPOINT_FORMAT_ERROR, CHECKPOINT_VERSION_ERROR};
+
+// What the screen showed when the checkpoint was saved, in the GUI's view coordinates. Headless runs save none.
+struct CheckpointViewport{
+    bool is_set;
+    double left, top, zoom;
+};
+
+/* The file starts with this header, and the tiles ('BitmapTile') follow it at 'header_size', one after another.
+Everything is in the native byte order, and every field is 8-byte aligned, so once the file is mapped the tiles are used right where they are -
+restoring is a copy of 512 bytes per tile into the engine, and not a parse.
+A later version may add fields at the end of the header (which is why the tiles start at 'header_size', and not right after this struct). */
+struct CheckpointHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t header_size;
+    uint64_t generation;
+    uint64_t population;
+    uint64_t tile_count;
+    uint32_t born_mask, survive_mask;
+    uint32_t has_viewport;
+    uint32_t reserved;
+    double view_left, view_top, view_zoom;
+};
+
+/* Saves the engine's live cells, its generation and rule, and the viewport.
+The file is written next to 'file_path' first, and moved over it only once it's complete, so a crash while saving leaves the last checkpoint intact. */
+checkpoint_status saveCheckpoint(const std::string& file_path, const Engine& engine, const Rule& rule, const CheckpointViewport& viewport);
+/* Replaces the engine's universe with the checkpoint's, and sets its rule and generation.
+'rule' and 'viewport' are set to the checkpoint's. On an error, the engine is left as it was. */
+checkpoint_status loadCheckpoint(const std::string& file_path, Engine& engine, Rule& rule, CheckpointViewport& viewport);
+
+#endif
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <vector>
+#include "cycle_detector.h"
+
+CycleDetector::CycleDetector(): next_entry(0) {
+    history.reserve(CYCLE_HISTORY_SIZE);
+}
+
+void CycleDetector::clear(){
+    history.clear();
+    next_entry = 0;
+}
+
+/* A recorded state matches if it has the same population, and the new one is that state moved by (dx, dy):
+then every coordinate moved by exactly (dx, dy), so the sums of the coordinates moved by 'population' times that,
+and the hash was multiplied by X^dx * Y^dy (see 'StateSignature').
+An empty universe isn't a cycle we report - the game has its own handling for it. */
+bool CycleDetector::record(unsigned long long int generation, const StateSignature& signature, CycleInfo& cycle){
+    bool found = false;
+    long long int population = signature.population;
+
+    // From the newest entry back, so the first match has the shortest period
+    for (size_t i = 0; i < history.size() && 0 < population && !found; i++){
+        const HistoryEntry& entry = history[(next_entry + history.size() - 1 - i) % history.size()];
+        if (entry.signature.population != signature.population) continue;
+
+        // The differences of the sums are small even when the sums themselves wrapped around
+        long long int sum_dx = (long long int)(signature.sum_x - entry.signature.sum_x);
+        long long int sum_dy = (long long int)(signature.sum_y - entry.signature.sum_y);
+        if (sum_dx % population != 0 || sum_dy % population != 0) continue;
+
+        long long int dx = sum_dx / population, dy = sum_dy / population;
+        if (signature.hash != hashMultiply(entry.signature.hash, hashMultiply(hashPowerX(dx), hashPowerY(dy)))) continue;
+
+        cycle = {generation, generation - entry.generation, dx, dy};
+        found = true;
+    }
+
+    if (history.size() < CYCLE_HISTORY_SIZE) history.push_back({generation, signature});
+    else history[next_entry] = {generation, signature};
+    next_entry = (next_entry + 1) % CYCLE_HISTORY_SIZE;
+
+    return found;
+}
+
+static std::vector<Cell> sortedCells(const Engine& engine){
+    std::vector<Cell> cells;
+    cells.reserve(engine.population());
+    engine.forEachCell([&cells](const Cell& cell){ cells.push_back(cell); });
+    std::sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b){ return a.y != b.y ? a.y < b.y : a.x < b.x; });
+
+    return cells;
+}
+
+/* Steps the engine a period, and checks that its cells are the ones it had, moved by (dx, dy).
+If they are, the state really repeats itself from now on (the rule is deterministic), whatever the signatures said. */
+static bool repeatsAfterPeriod(Engine& engine, const CycleInfo& cycle){
+    std::vector<Cell> cells = sortedCells(engine);
+    engine.advance(cycle.period);
+    std::vector<Cell> next_cells = sortedCells(engine);
+    if (cells.size() != next_cells.size()) return false;
+
+    for (size_t i = 0; i < cells.size(); i++){
+        if ((long long int)cells[i].x + cycle.dx != next_cells[i].x || (long long int)cells[i].y + cycle.dy != next_cells[i].y) return false;
+    }
+    return true;
+}
+
+cycle_skip_status fastForwardCycle(Engine& engine, const CycleInfo& cycle, unsigned long long int generations){
+    if (generations < 2 * cycle.period){ // At most one repetition, which the check would compute anyway
+        engine.advance(generations);
+        return CYCLE_SKIPPED;
+    }
+    if (!repeatsAfterPeriod(engine, cycle)) return CYCLE_NOT_REPEATING;
+    generations -= cycle.period;
+
+    unsigned long long int repetitions = generations / cycle.period;
+    long long int move_x = 0, move_y = 0;
+
+    if (repetitions != 0 && (cycle.dx != 0 || cycle.dy != 0)){
+        if ((unsigned long long int)INT_MAX / repetitions < (unsigned long long int)std::max(std::abs(cycle.dx), std::abs(cycle.dy))) return CYCLE_OUT_OF_BOUNDS;
+        move_x = cycle.dx * (long long int)repetitions;
+        move_y = cycle.dy * (long long int)repetitions;
+
+        BoundingBox box = engine.boundingBox();
+        if (box.left + move_x < INT_MIN || INT_MAX < box.right + move_x || box.top + move_y < INT_MIN || INT_MAX < box.bottom + move_y) return CYCLE_OUT_OF_BOUNDS;
+    }
+
+    engine.advance(generations % cycle.period);
+    if (move_x != 0 || move_y != 0) engine.translate(move_x, move_y);
+    engine.skipGenerations(repetitions * cycle.period);
+
+    return CYCLE_SKIPPED;
+}
@@ -0,0 +1,49 @@
+#ifndef GAME_OF_LIFE_CYCLE_DETECTOR_H
+#define GAME_OF_LIFE_CYCLE_DETECTOR_H
+
+#include <vector>
+#include "engine.h"
+#include "state_signature.h"
+
+#define CYCLE_HISTORY_SIZE 256 // How many recorded states we compare against, so it's also the longest period (in recorded states) we can find
+
+// A state that repeats itself, possibly moved: the state of 'generation' is the state of 'generation - period', moved by (dx, dy).
+struct CycleInfo{
+    unsigned long long int generation;
+    unsigned long long int period;
+    long long int dx, dy;
+};
+
+/* Finds the generation from which a pattern repeats itself - still lifes, oscillators (dx = dy = 0), and spaceships.
+It keeps a ring of the signatures of the last recorded generations, and compares every new one against them.
+Since the engines keep their signatures up to date as they step, recording a generation costs O('CYCLE_HISTORY_SIZE'), and not O(population).
+
+The generations don't have to be consecutive (the game records one every 2^k generations), but then the period we find
+is the distance between 2 recorded generations - so it's a multiple of the true period. */
+class CycleDetector{
+private:
+    struct HistoryEntry{
+        unsigned long long int generation;
+        StateSignature signature;
+    };
+    std::vector<HistoryEntry> history; // A ring buffer, where 'next_entry' is the oldest entry (once the ring is full)
+    size_t next_entry;
+
+public:
+    CycleDetector();
+
+    void clear();
+    // Returns true (and fills 'cycle') if the state repeats one of the recorded ones. The shortest period wins.
+    bool record(unsigned long long int generation, const StateSignature& signature, CycleInfo& cycle);
+};
+
+enum cycle_skip_status {CYCLE_SKIPPED, CYCLE_NOT_REPEATING, CYCLE_OUT_OF_BOUNDS};
+
+/* Advances the engine by 'generations' without computing the repetitions of its cycle:
+the state 'n * period + r' generations from now is the state 'r' generations from now, moved 'n' times by (dx, dy).
+The signatures match only with a (very) high probability, so before skipping we make sure: we step a period, and compare the cells.
+If the cycle doesn't repeat after all, or if the cells would move beyond the coordinates we can represent, nothing is skipped,
+and the engine may have advanced by up to a period - the caller advances the rest. */
+cycle_skip_status fastForwardCycle(Engine& engine, const CycleInfo& cycle, unsigned long long int generations);
+
+#endif
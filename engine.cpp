@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
+#include "engines.h"
+#include "bit_utils.h"
+#include "flat_cell_table.h"
+
+Engine::Engine(): generation(0) { }
+
+void Engine::setRule(const Rule& new_rule){
+    rule = new_rule;
+}
+
+void Engine::setThreadCount(int /*thread_count*/) { }
+
+unsigned long long int Engine::getGeneration() const{
+    return generation;
+}
+
+void Engine::insertCells(const std::vector<Cell>& cells){
+    for (const auto& cell : cells) insert(cell);
+}
+
+void Engine::insertQuadtree(const Quadtree& tree, int left, int top){
+    std::vector<Cell> cells;
+    forEachQuadtreeCell(tree, left, top, [&cells](const Cell& cell){ cells.push_back(cell); });
+    insertCells(cells);
+}
+
+bool Engine::insertsQuadtreeNodes() const{
+    return false;
+}
+
+void Engine::insertTiles(const BitmapTile* tiles, size_t count){
+    std::vector<Cell> cells;
+    for (size_t i = 0; i < count; i++){
+        for (int y = 0; y < BITMAP_TILE_SIZE; y++){
+            for (uint64_t row = tiles[i].rows[y]; row != 0; row &= row - 1){
+                cells.push_back({tiles[i].tile_x * BITMAP_TILE_SIZE + countTrailingZeros64(row), tiles[i].tile_y * BITMAP_TILE_SIZE + y});
+            }
+        }
+    }
+
+    insertCells(cells);
+}
+
+bool Engine::empty() const{
+    return population() == 0;
+}
+
+// Generic implementation, which checks every live cell.
+void Engine::forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const{
+    forEachCell([&rect, &func](const Cell& cell){
+        if (rect.left <= cell.x && cell.x <= rect.right && rect.top <= cell.y && cell.y <= rect.bottom) func(cell);
+    });
+}
+
+// Generic implementation, which simply scans all the live cells. Engines that keep their cells in some spatial structure can do better.
+BoundingBox Engine::boundingBox() const{
+    BoundingBox box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    forEachCell([&box](const Cell& cell){
+        box.left = std::min(box.left, cell.x);
+        box.top = std::min(box.top, cell.y);
+        box.right = std::max(box.right, cell.x);
+        box.bottom = std::max(box.bottom, cell.y);
+    });
+
+    return box;
+}
+
+void Engine::buildQuadtree(Quadtree& tree) const{
+    std::vector<Cell> cells;
+    cells.reserve(population());
+    forEachCell([&cells](const Cell& cell){ cells.push_back(cell); });
+
+    quadtreeFromCells(cells, tree);
+}
+
+// Generic implementation, which gathers the live cells by their tiles.
+void Engine::forEachTile(const std::function<void(const BitmapTile&)>& func) const{
+    std::unordered_map<uint64_t, BitmapTile> tiles;
+    forEachCell([&tiles](const Cell& cell){
+        int tile_x = cell.x >> 6, tile_y = cell.y >> 6; // Rounds towards minus infinity, see 'TiledEngine::insert()'
+        auto iter = tiles.find((uint64_t)(uint32_t)tile_x << 32 | (uint32_t)tile_y);
+        if (iter == tiles.end()) iter = tiles.emplace((uint64_t)(uint32_t)tile_x << 32 | (uint32_t)tile_y, BitmapTile{tile_x, tile_y, {}}).first;
+
+        iter->second.rows[cell.y & (BITMAP_TILE_SIZE - 1)] |= (uint64_t)1 << (cell.x & (BITMAP_TILE_SIZE - 1));
+    });
+
+    for (const auto& key_and_tile : tiles) func(key_and_tile.second);
+}
+
+/* Generic implementation. A square that is smaller than a tile is counted from the tile's rows (every tile has its own squares),
+and a bigger one adds up the populations of its tiles. */
+void Engine::forEachBlock(int level, const std::function<void(const Cell&, unsigned long long int)>& func) const{
+    int size = 1 << level;
+    if (size < BITMAP_TILE_SIZE){
+        int blocks_per_row = BITMAP_TILE_SIZE / size;
+        uint64_t mask = ((uint64_t)1 << size) - 1;
+        forEachTile([&func, size, blocks_per_row, mask](const BitmapTile& tile){
+            for (int block_y = 0; block_y < blocks_per_row; block_y++){
+                for (int block_x = 0; block_x < blocks_per_row; block_x++){
+                    unsigned long long int population = 0;
+                    for (int y = block_y * size; y < (block_y + 1) * size; y++) population += popcount64(tile.rows[y] >> (block_x * size) & mask);
+                    if (population != 0) func({tile.tile_x * blocks_per_row + block_x, tile.tile_y * blocks_per_row + block_y}, population);
+                }
+            }
+        });
+        return;
+    }
+
+    int shift = level - 6; // Tiles per block, as a power of 2 (a tile is 2^6 cells wide)
+    CellMap<unsigned long long int> blocks;
+    forEachTile([&blocks, shift](const BitmapTile& tile){
+        unsigned long long int population = 0;
+        for (int y = 0; y < BITMAP_TILE_SIZE; y++) population += popcount64(tile.rows[y]);
+        blocks[{tile.tile_x >> shift, tile.tile_y >> shift}] += population; // Rounds towards minus infinity, like the tiles themselves
+    });
+    blocks.forEach(func);
+}
+
+// Generic implementation, which scans all the live cells.
+StateSignature Engine::signature(){
+    StateSignature result = {};
+    forEachCell([&result](const Cell& cell){ addCellToSignature(result, cell.x, cell.y); });
+
+    return result;
+}
+
+void Engine::advance(unsigned long long int generations){
+    for (unsigned long long int i = 0; i < generations; i++) step();
+}
+
+bool Engine::isAtCoordinateLimit() const{
+    return false;
+}
+
+void Engine::translate(int dx, int dy){
+    std::vector<Cell> cells;
+    cells.reserve(population());
+    forEachCell([&cells](const Cell& cell){ cells.push_back(cell); });
+
+    unsigned long long int current_generation = generation; // 'clear()' resets it
+    clear();
+    for (const auto& cell : cells) insert({cell.x + dx, cell.y + dy});
+    generation = current_generation;
+}
+
+void Engine::skipGenerations(unsigned long long int generations){
+    generation += generations;
+}
+
+std::unique_ptr<Engine> createEngine(const std::string& name){
+    if (name == "sparse") return std::make_unique<SparseEngine>();
+    if (name == "tiled") return std::make_unique<TiledEngine>();
+    if (name == "hashlife") return std::make_unique<HashLifeEngine>();
+
+    return nullptr;
+}
+
+std::vector<std::string> engineNames(){
+    return {"sparse", "tiled", "hashlife"};
+}
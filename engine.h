@@ -0,0 +1,80 @@
+#ifndef GAME_OF_LIFE_ENGINE_H
+#define GAME_OF_LIFE_ENGINE_H
+
+#include <functional>
+#include <vector>
+#include "cell.h"
+#include "quadtree.h"
+#include "rule.h"
+#include "state_signature.h"
+
+/* Base (abstract) class for all simulation engines.
+An engine owns the universe (the set of live cells) and knows how to advance it by generations.
+It has no SFML dependency whatsoever, so it can be linked into headless tools (like 'gol-run'),
+and the screens only talk to it through this interface.
+The universe is unbounded - it's the screens' job to decide what part of it is visible. */
+class Engine{
+protected:
+    Rule rule;
+    unsigned long long int generation;
+
+public:
+    Engine();
+    virtual ~Engine() = default;
+
+    virtual void setRule(const Rule& new_rule);
+    // How many threads a step may use. Engines that don't parallelize their steps simply ignore it.
+    virtual void setThreadCount(int thread_count);
+    unsigned long long int getGeneration() const;
+
+    virtual void insert(const Cell& cell) = 0;
+    virtual void erase(const Cell& cell) = 0;
+    // Inserts many cells at once (like a pattern that was just loaded). Engines for which that's cheaper than one by one override it.
+    virtual void insertCells(const std::vector<Cell>& cells);
+    /* Inserts a pattern that comes as a quadtree (like a macrocell file), with its top-left corner at (left, top).
+    The generic implementation goes through its cells; engines that are quadtrees themselves can take the nodes as they are. */
+    virtual void insertQuadtree(const Quadtree& tree, int left, int top);
+    // Whether 'insertQuadtree()' takes the nodes as they are, so it's as fast as the tree is small (however many cells it has).
+    // If not, a caller that wants to show progress or to be able to stop halfway is better off inserting the cells itself, in batches.
+    virtual bool insertsQuadtreeNodes() const;
+    // Inserts the live cells of the tiles (like the ones of a checkpoint). The generic implementation goes through their cells.
+    virtual void insertTiles(const BitmapTile* tiles, size_t count);
+    virtual bool count(const Cell& cell) const = 0;
+    // Kills every cell, and resets the generation counter.
+    virtual void clear() = 0;
+    virtual unsigned long long int population() const = 0;
+    bool empty() const;
+
+    virtual void forEachCell(const std::function<void(const Cell&)>& func) const = 0;
+    /* Calls 'func' for every live cell inside 'rect' (its bounds are inclusive), in no particular order.
+    The generic implementation goes through all the live cells; engines with a spatial index (tiles, or a quadtree) override it,
+    so that it costs as much as the cells in the rectangle and the tiles (or nodes) it touches - not as the whole universe. */
+    virtual void forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const;
+    virtual BoundingBox boundingBox() const;
+    // The live cells as a quadtree (for writing a macrocell file, or for moving them into another engine), with the center of its root at (0,0).
+    virtual void buildQuadtree(Quadtree& tree) const;
+    // Calls 'func' for every 64x64 tile that has live cells, in no particular order.
+    virtual void forEachTile(const std::function<void(const BitmapTile&)>& func) const;
+    /* Calls 'func' for every square of 2^level x 2^level cells (aligned to multiples of its size) that has live cells, in no particular order,
+    with the square's coordinates (its top-left cell's, divided by 2^level) and its population. It's what a zoomed-out view draws.
+    The generic implementation counts the cells of the tiles; engines that know the populations of their squares (like HashLife) go straight to them. */
+    virtual void forEachBlock(int level, const std::function<void(const Cell&, unsigned long long int)>& func) const;
+    /* See 'StateSignature'. Engines keep it up to date as they step, so it's cheap enough to read after every generation -
+    but only from the first time it's asked for (which computes it from scratch), so that runs that never look at it don't pay for it. */
+    virtual StateSignature signature();
+
+    // Advances the universe to the next generation.
+    virtual void step() = 0;
+    // Advances the universe by 'generations' generations. Engines that can skip ahead faster than one 'step()' at a time override it.
+    virtual void advance(unsigned long long int generations);
+    /* Whether the last 'advance()' stopped short of its generations, since the live cells would have moved beyond the coordinates a 'Cell' holds.
+    Only an engine that jumps that far ahead (HashLife) stops like that; the others never get there in practice, so the generic implementation says no. */
+    virtual bool isAtCoordinateLimit() const;
+
+    /* For jumping over the repetitions of a cycle (see 'fastForwardCycle()'): moves every live cell by (dx, dy),
+    and adds generations to the counter without computing them. */
+    void translate(int dx, int dy);
+    void skipGenerations(unsigned long long int generations);
+};
+
+#endif
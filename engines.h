@@ -0,0 +1,21 @@
+#ifndef GAME_OF_LIFE_ENGINES_H
+#define GAME_OF_LIFE_ENGINES_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Base (abstract) class for all engines
+#include "engine.h"
+
+// All concrete engine classes
+#include "sparse_engine.h"
+#include "tiled_engine.h"
+#include "hashlife_engine.h"
+
+// Creates an engine by its name ("sparse", "tiled" or "hashlife"). Returns nullptr if there's no engine by that name.
+std::unique_ptr<Engine> createEngine(const std::string& name);
+// The names 'createEngine()' accepts.
+std::vector<std::string> engineNames();
+
+#endif
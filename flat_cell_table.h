@@ -0,0 +1,241 @@
+#ifndef GAME_OF_LIFE_FLAT_CELL_TABLE_H
+#define GAME_OF_LIFE_FLAT_CELL_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "cell.h"
+
+#define MIN_TABLE_CAPACITY 16
+#define MAX_PROBE_DISTANCE 255 // Distances are stored in a byte. A longer probe makes the table grow.
+#define TABLE_TILE_BITS 4 // Cells are hashed by tiles of 16x16, see 'homeSlot()'
+#define MAX_LISTED_CAPACITY ((size_t)1 << 32) // The filled slots of a bigger table aren't listed (their indices are 32-bit), so 'clear()' empties all of them
+
+/* Hash set and hash map of cells, used by 'SparseEngine' instead of std::unordered_set and std::unordered_map.
+The standard containers allocate a node per element, so every access is a pointer chase to somewhere random in the heap,
+and every generation costs a malloc and a free per cell. Here all the elements live in one contiguous array (open addressing),
+and 'clear()' keeps the array - so a table that is cleared and refilled every generation (like the neighbor counts in
+'SparseEngine::step()') stops allocating once it's big enough. It only empties the slots that were filled since the last time,
+so a table that was once much bigger (a soup that has died down) doesn't cost its old size on every generation.
+
+Collisions are resolved with Robin Hood hashing: an element is probed linearly from its home slot, and on insertion
+an element that is further from its home slot than the one sitting in a slot takes that slot (and the poorer element moves on).
+It keeps all the probe sequences short, so a lookup reads 1-2 cache lines even at a load factor of 7/8.
+'distances[i]' is the distance of the element in slot 'i' from its home slot plus 1, or 0 if the slot is empty. */
+
+// A cell as a single 64-bit key, which is cheaper to hash and compare than a pair.
+inline uint64_t packCell(const Cell& cell){
+    return (uint64_t)(uint32_t)cell.x << 32 | (uint32_t)cell.y;
+}
+inline Cell unpackCell(uint64_t key){
+    return {(int)(uint32_t)(key >> 32), (int)(uint32_t)key};
+}
+
+template <class Slot>
+class FlatCellTable{
+protected:
+    std::vector<Slot> slots;
+    std::vector<uint8_t> distances;
+    std::vector<uint32_t> filled_slots; // The slots that were empty at the last 'clear()' and have been filled since (some may have been erased again)
+    size_t element_count;
+    int shift; // 64 - log2(capacity), see 'homeSlot()'
+
+    /* Note to self: a cell's neighbors are looked up right after it, so neighboring cells should be in neighboring slots.
+    So only the tile of the cell is hashed - we fold its x onto its y, and take the *high* bits of a multiplication by 2^64/phi
+    (Fibonacci hashing), which depend on all the bits - and the offset of the cell in the tile is added to that.
+    A row of a tile is then 16 consecutive slots, so the 9 lookups around a cell touch 3 short runs instead of 9 random cache lines,
+    and iterating over a table (which is how the neighbors are generated) goes tile by tile too.
+    With the hash of the whole key, the sparse engine was ~30% slower on a soup of 10^6 cells, and about as fast on 10^4-10^5. */
+    size_t homeSlot(uint64_t key) const{
+        uint32_t x = (uint32_t)(key >> 32), y = (uint32_t)key;
+        uint64_t tile = (uint64_t)(x >> TABLE_TILE_BITS) << 32 | (y >> TABLE_TILE_BITS);
+        size_t offset = (y & ((1 << TABLE_TILE_BITS) - 1)) << TABLE_TILE_BITS | (x & ((1 << TABLE_TILE_BITS) - 1));
+
+        return ((size_t)(((tile ^ tile >> 32) * 0x9E3779B97F4A7C15ULL) >> shift) + offset) & (slots.size() - 1);
+    }
+
+    // Whether 'filled_slots' still has every filled slot. It stops growing at the capacity, which only a lot of erasing and reinserting reaches.
+    bool areFilledSlotsListed() const{
+        return filled_slots.size() < slots.size() && slots.size() <= MAX_LISTED_CAPACITY;
+    }
+
+    // Returns -1 if the key isn't in the table.
+    long long int findSlot(uint64_t key) const{
+        size_t mask = slots.size() - 1;
+        size_t i = homeSlot(key);
+
+        // Because of the Robin Hood invariant, once we reach a slot whose element is closer to its home than we are to ours, the key isn't there.
+        for (int distance = 1; distance <= distances[i]; distance++){
+            if (distances[i] == distance && slots[i].key == key) return i;
+            i = (i + 1) & mask;
+        }
+
+        return -1;
+    }
+
+    // Puts a key that isn't in the table yet, and returns the index it ended up in.
+    size_t place(Slot slot){
+        uint64_t key = slot.key;
+        size_t mask = slots.size() - 1;
+        size_t i = homeSlot(key);
+        long long int placed_index = -1;
+
+        for (uint8_t distance = 1; ; distance++){
+            if (distances[i] == 0){
+                slots[i] = std::move(slot);
+                distances[i] = distance;
+                element_count++;
+                if (areFilledSlotsListed()) filled_slots.push_back((uint32_t)i);
+
+                return placed_index == -1 ? i : (size_t)placed_index;
+            }
+            if (distances[i] < distance){
+                std::swap(slot, slots[i]);
+                std::swap(distance, distances[i]);
+                if (placed_index == -1) placed_index = i;
+            }
+
+            i = (i + 1) & mask;
+            if (distance == MAX_PROBE_DISTANCE){
+                // We're still holding a slot (ours, or one we've displaced), but the probe is too long: grow, and start over.
+                rehash(slots.size() * 2);
+                place(std::move(slot));
+
+                return findSlot(key);
+            }
+        }
+    }
+
+    void rehash(size_t capacity){
+        std::vector<Slot> old_slots(capacity);
+        std::vector<uint8_t> old_distances(capacity, 0);
+        old_slots.swap(slots);
+        old_distances.swap(distances);
+
+        shift = 64;
+        for (size_t c = capacity; 1 < c; c >>= 1) shift--;
+        element_count = 0;
+        filled_slots.clear();
+
+        for (size_t i = 0; i < old_slots.size(); i++){
+            if (old_distances[i]) place(std::move(old_slots[i]));
+        }
+    }
+
+    // Returns the index of the key, inserting it (with a default value) if it's not in the table.
+    size_t findOrInsert(uint64_t key, bool& inserted){
+        long long int index = findSlot(key);
+        inserted = index == -1;
+        if (!inserted) return index;
+
+        if (slots.size() * 7 < (element_count + 1) * 8) rehash(slots.size() * 2);
+        Slot slot = Slot();
+        slot.key = key;
+
+        return place(std::move(slot));
+    }
+
+public:
+    FlatCellTable(): slots(MIN_TABLE_CAPACITY), distances(MIN_TABLE_CAPACITY, 0), element_count(0), shift(64 - 4) { }
+
+    size_t size() const { return element_count; }
+    size_t capacity() const { return slots.size(); } // In slots
+    bool empty() const { return element_count == 0; }
+    bool count(const Cell& cell) const { return findSlot(packCell(cell)) != -1; }
+
+    // Empties the table but keeps its storage, so refilling it up to the same size doesn't allocate.
+    void clear(){
+        if (areFilledSlotsListed()){
+            for (uint32_t i : filled_slots) distances[i] = 0;
+        }
+        else std::fill(distances.begin(), distances.end(), 0);
+
+        filled_slots.clear();
+        element_count = 0;
+    }
+
+    void reserve(size_t element_amount){
+        size_t capacity = slots.size();
+        while (capacity * 7 < element_amount * 8) capacity *= 2;
+        if (capacity != slots.size()) rehash(capacity);
+    }
+
+    // Backward-shift deletion: the elements after the erased one move one slot back towards their home, so no tombstones are needed.
+    bool erase(const Cell& cell){
+        long long int index = findSlot(packCell(cell));
+        if (index == -1) return false;
+
+        size_t mask = slots.size() - 1;
+        size_t i = index, next = (i + 1) & mask;
+        while (1 < distances[next]){
+            slots[i] = std::move(slots[next]);
+            distances[i] = distances[next] - 1;
+            i = next;
+            next = (next + 1) & mask;
+        }
+
+        distances[i] = 0;
+        element_count--;
+        return true;
+    }
+};
+
+struct CellSetSlot{
+    uint64_t key;
+};
+
+template <class Value>
+struct CellMapSlot{
+    uint64_t key;
+    Value value;
+};
+
+class CellSet: public FlatCellTable<CellSetSlot>{
+public:
+    // Returns whether the cell was inserted (false if it was already in the set).
+    bool insert(const Cell& cell){
+        bool inserted;
+        findOrInsert(packCell(cell), inserted);
+
+        return inserted;
+    }
+
+    template <class Func>
+    void forEach(const Func& func) const{
+        for (size_t i = 0; i < slots.size(); i++){
+            if (distances[i]) func(unpackCell(slots[i].key));
+        }
+    }
+};
+
+template <class Value>
+class CellMap: public FlatCellTable<CellMapSlot<Value>>{
+public:
+    // Like std::unordered_map, a missing cell is inserted with a value-initialized value.
+    Value& operator[](const Cell& cell){
+        bool inserted;
+        return this->slots[this->findOrInsert(packCell(cell), inserted)].value;
+    }
+    // Returns nullptr if the cell isn't in the map.
+    const Value* find(const Cell& cell) const{
+        long long int index = this->findSlot(packCell(cell));
+        return index == -1 ? nullptr : &this->slots[index].value;
+    }
+
+    template <class Func>
+    void forEach(const Func& func) const{
+        for (size_t i = 0; i < this->slots.size(); i++){
+            if (this->distances[i]) func(unpackCell(this->slots[i].key), this->slots[i].value);
+        }
+    }
+    // Like the above, but 'func' may change the values (and only them).
+    template <class Func>
+    void forEach(const Func& func){
+        for (size_t i = 0; i < this->slots.size(); i++){
+            if (this->distances[i]) func(unpackCell(this->slots[i].key), this->slots[i].value);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "frame_scheduler.h"
+
+// The first frame of the program is drawn right away
+FrameScheduler::FrameScheduler(): is_redraw_needed(true), is_visible(true) { }
+
+bool FrameScheduler::pollEvent(sf::Window& window, sf::Event& evnt){
+    if (!window.pollEvent(evnt)) return false;
+
+    switch (evnt.type){
+        case sf::Event::LostFocus:
+            is_visible = false;
+            break;
+
+        case sf::Event::GainedFocus:
+            is_visible = true;
+            is_redraw_needed = true;
+            break;
+
+        // Some platforms tell us about a minimized window only by resizing it to nothing
+        case sf::Event::Resized:
+            is_visible = evnt.size.width != 0 && evnt.size.height != 0 && window.hasFocus();
+            is_redraw_needed = true;
+            break;
+
+        // The input the screens act on: it changes something on the screen almost every time, and it comes at a human's pace anyway
+        case sf::Event::KeyPressed:
+        case sf::Event::TextEntered:
+        case sf::Event::MouseButtonPressed:
+        case sf::Event::MouseButtonReleased:
+        case sf::Event::MouseWheelScrolled:
+            is_redraw_needed = true;
+            break;
+
+        // The mouse moving (or entering or leaving the window) comes dozens of times a second, and changes something only
+        // if it drags the view or moves the hover to another option - which the screen knows, and asks for a redraw itself
+        default:
+            break;
+    }
+
+    return true;
+}
+
+void FrameScheduler::requestRedraw(){
+    is_redraw_needed = true;
+}
+
+bool FrameScheduler::isVisible() const{
+    return is_visible;
+}
+
+/* A redraw that is asked for while the window isn't visible waits for it to be visible again (gaining focus asks for one anyway).
+Otherwise we keep the frames at least 1/'MAX_FRAME_RATE' seconds apart: if the last frame was drawn just now, we sleep the rest of that time. */
+bool FrameScheduler::startFrame(){
+    if (!is_visible){
+        sf::sleep(sf::milliseconds(UNFOCUSED_POLL_INTERVAL));
+        return false;
+    }
+
+    sf::Time frame_time = sf::microseconds(1000000 / MAX_FRAME_RATE);
+    sf::Time elapsed = frame_clock.getElapsedTime();
+    if (!is_redraw_needed){
+        sf::sleep(elapsed < frame_time ? frame_time - elapsed : frame_time);
+        return false;
+    }
+    if (elapsed < frame_time) sf::sleep(frame_time - elapsed);
+
+    frame_clock.restart();
+    is_redraw_needed = false;
+    return true;
+}
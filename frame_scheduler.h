@@ -0,0 +1,39 @@
+#ifndef GAME_OF_LIFE_FRAME_SCHEDULER_H
+#define GAME_OF_LIFE_FRAME_SCHEDULER_H
+
+#include <SFML/Graphics.hpp>
+
+#define MAX_FRAME_RATE 60 // Frames per second. Also how often an idle screen wakes up to check for events (and for new generations).
+#define UNFOCUSED_POLL_INTERVAL 100 // In milliseconds. How often a screen whose window is unfocused or minimized wakes up to check for events.
+
+/* Decides when the screens draw a frame. Nothing on a screen changes by itself, except for what the screen says it changed
+(a new generation, the progress of a load, a drag, a hover), so a frame is drawn only after an event (input, resize, focus) or a 'requestRedraw()',
+and at most 'MAX_FRAME_RATE' times per second. In between, the loop sleeps instead of spinning, so an idle screen doesn't take a core.
+
+While the window is unfocused or minimized, nothing is drawn at all (and the loop sleeps longer); the simulation, which runs on its own thread, doesn't care.
+A screen's loop goes like this:
+
+    while (frame_scheduler.pollEvent(window, evnt)) { handle the event }
+    if (something changed) frame_scheduler.requestRedraw();
+    if (!frame_scheduler.startFrame()) continue;
+    clear, draw and display */
+class FrameScheduler{
+private:
+    sf::Clock frame_clock; // Since the last frame started
+    bool is_redraw_needed;
+    bool is_visible; // The window has focus, and isn't minimized
+
+public:
+    FrameScheduler();
+
+    // Like 'sf::Window::pollEvent()'. Input, resizes and gaining focus ask for a redraw (but not the mouse moving),
+    // and the focus and resize events tell us whether the window is visible.
+    bool pollEvent(sf::Window& window, sf::Event& evnt);
+    void requestRedraw();
+    bool isVisible() const;
+
+    // Returns whether to draw a frame now. If not, it sleeps first (a frame's time, or longer if the window isn't visible), so the loop doesn't spin.
+    bool startFrame();
+};
+
+#endif
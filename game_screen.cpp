@@ -3,109 +3,224 @@
 
 GameScreen::GameScreen(): gen_text("", font, OPTION_CHARACTER_SIZE) {
     timestep = 325; // By default, we "sleep" for 325ms.
-    reserved_size = 500;
+    step_exponent = 0;
+    stop_on_cycle = true;
+    turbo = false;
+    target_rate_exponent = MAX_TARGET_RATE_EXPONENT + 1;
+    generations_per_second = 0;
 
     gen_text.setFillColor(sf::Color::Black);
     gen_text.setStyle(sf::Text::Bold);
 }
 
-// This function adds the Moore neighborhood of every cell (including itself) to the map.
-void GameScreen::addNeighbors(std::unordered_map<sf::Vector2i, short int, pair_hash, pair_equal>& m) const{
-    for (const auto& coordinate : grid){
+/* Moves the live cells (and the generation counter) into a new engine of the given type.
+It's done on the GUI thread, so the cells go in bulk rather than one by one: HashLife takes the nodes of the old engine's quadtree as they are,
+and the other engines get all the cells at once. We only switch between HashLife and the default engine, so the tree is of 'int' coordinates. */
+void GameScreen::switchEngine(const std::string& engine_name){
+    std::unique_ptr<Engine> new_grid = createEngine(engine_name);
+    new_grid->setRule(rule);
+    if (new_grid->insertsQuadtreeNodes()){
+        Quadtree tree;
+        grid->buildQuadtree(tree);
+        int corner = (int)-(1LL << (tree.level() - 1)); // The root's center is at (0,0)
+        new_grid->insertQuadtree(tree, corner, corner);
+    }
+    else{
+        std::vector<Cell> cells;
+        cells.reserve(grid->population());
+        grid->forEachCell([&cells](const Cell& cell){ cells.push_back(cell); });
+        new_grid->insertCells(cells);
+    }
+    new_grid->skipGenerations(grid->getGeneration());
 
-        for (int k = coordinate.y - 1; k <= coordinate.y + 1; k++){
-            for (int p = coordinate.x - 1; p <= coordinate.x + 1; p++){
-                // Bound checking, so we don't add a cell beyond bounds.
-                if (0 <= k && k <= grid_height / CELL_SIZE && 0 <= p && p <= grid_width / CELL_SIZE) m[{p, k}]++;
-            }
-        }
+    grid = std::move(new_grid);
+}
+
+/* Stepping 2^k generations at a time is exactly what HashLife is good at (it's practically free for regular patterns),
+but for a single generation at a time, the default engine is a lot faster on chaotic patterns.
+So we move the universe to HashLife when the step becomes bigger than 1, and back when it returns to 1. */
+void GameScreen::setStepExponent(short int exponent){
+    bool was_hashlife = 0 < step_exponent;
+    step_exponent = exponent;
+
+    if (was_hashlife != (0 < step_exponent)) switchEngine(0 < step_exponent ? "hashlife" : DEFAULT_ENGINE);
+}
+
+// 0 means no target - as many generations as fit in the frame budget.
+unsigned long long int GameScreen::targetRate() const{
+    if (MAX_TARGET_RATE_EXPONENT < target_rate_exponent) return 0;
+
+    unsigned long long int rate = 1;
+    for (int i = 0; i < target_rate_exponent; i++) rate *= 10;
+    return rate;
+}
+
+void GameScreen::setGenText(unsigned long long int gen){
+    std::string step_str = 0 < step_exponent ? " (step: 2^" + std::to_string(step_exponent) + ")" : "";
+    std::string rate_str = " | " + std::to_string((unsigned long long int)(generations_per_second + 0.5)) + " gens/s";
+    if (turbo) rate_str += targetRate() == 0 ? " (turbo)" : " (turbo: 10^" + std::to_string(target_rate_exponent) + ")";
+
+    gen_text.setString("gen: " + std::to_string(gen) + step_str + cycle_str + rate_str);
+}
+
+void GameScreen::reportCycle(const CycleInfo& cycle){
+    cycle_str = " (period " + std::to_string(cycle.period);
+    if (cycle.dx != 0 || cycle.dy != 0) cycle_str += ", moves (" + std::to_string(cycle.dx) + ", " + std::to_string(cycle.dy) + ")";
+    cycle_str += ")";
+
+    std::cout << "This pattern repeats itself every " << cycle.period << " generations from generation " << cycle.generation - cycle.period;
+    if (cycle.dx != 0 || cycle.dy != 0) std::cout << ", moving by (" << cycle.dx << ", " << cycle.dy << ") every period";
+    std::cout << "." << std::endl;
+    if (stop_on_cycle) std::cout << "The simulation has stopped. Press C to keep it running." << std::endl;
+}
+
+// Saves the universe, the rule and the view in 'CHECKPOINT_PATH'. The simulation must be stopped.
+void GameScreen::saveGame() const{
+    if (saveCheckpoint(CHECKPOINT_PATH, *grid, rule, {true, left_top_view_pos.x, left_top_view_pos.y, zoom}) == CHECKPOINT_OK){
+        std::cout << "The game was saved on the " << grid->getGeneration() << " generation. Press L to restore it." << std::endl;
     }
+    else std::cerr << "Could not write " << CHECKPOINT_PATH << std::endl;
 }
 
-// Apply rules based on chosen automaton's 'born' and 'survive' digits.
-void GameScreen::applyRules(const std::unordered_map<sf::Vector2i, short int, pair_hash, pair_equal>& m){
-    for (const auto& map_pair : m){
-        bool is_curr_cell_live = grid.count(map_pair.first);
-        if (!is_curr_cell_live && born_digits.count(map_pair.second) == 1){ // Cell is dead and can be born.
-            grid.insert(map_pair.first);
-        }
+/* Replaces the universe with the one in 'CHECKPOINT_PATH', and restores the rule and the view it was saved with.
+The simulation must be stopped; its generation counter continues from the checkpoint's once it starts again. */
+void GameScreen::restoreGame(){
+    CheckpointViewport viewport;
+    checkpoint_status status = loadCheckpoint(CHECKPOINT_PATH, *grid, rule, viewport);
+    if (status == CHECKPOINT_FILE_ERROR){
+        std::cout << "There is no saved game yet. Press K to save one." << std::endl;
+        return;
+    }
+    else if (status != CHECKPOINT_OK){
+        std::cerr << CHECKPOINT_PATH << " is not a checkpoint of this version" << std::endl;
+        return;
+    }
 
-        // We write 'map_pair.second - 1', because a *live* cell also counts itself in 'm', so we subtract 1.
-        if (is_curr_cell_live && survive_digits.count(map_pair.second - 1) == 0){ // Cell is live and can *not* survive.
-            grid.erase(map_pair.first);
-        }
+    if (viewport.is_set){
+        setViewport(viewport.left, viewport.top, viewport.zoom);
+        gen_text.setScale(zoom, zoom);
+        gen_text.setPosition(left_top_view_pos.x, left_top_view_pos.y);
     }
+    cycle_str.clear();
+    std::cout << "The game was restored on the " << grid->getGeneration() << " generation (rule " << rule.toString() << ")." << std::endl;
 }
 
-/* Update the grid to next generation. The algorithm is as follows:
-1) Take the set of lives cells (grid), and for every cell:
-Add itself and its neighbors to a map that maps coordinate to number of appearances.
-*Adding *itself* is crucial, for cells without neighbors, for example.
-2) Iterate over the map s.t. for every coordinate with 'k' appearances:
-If it's live and doesn't fulfill the 'survive' rule - delete it from grid.
-If it's dead and does fulfill the 'burn' rule - insert it to grid.
-*In previous versions, when we only had Game of Life, this is what we did:
-(I'm saving it because I really like this solution; and also because it's my project, and I can do whatever I want):
-"If a cell appears 3 times (has been added 3 times), add it to the new set.
-If a cell appears 4 times *and is live*, add it to the new set.
-The new set is the new generation. Swap it with grid.
-Explanation: in order for a cell to be live in next gen, it needs to be:
--Live with 2 neighbors or dead with 3 neighbors - in this case it will appear 3 times.
--Live with 3 neighbors - in this case it will be *live* and appear 4 times."
-
-Let's denote p = number of live cells. So:
-Time complexity: O(9p + 9p)=O(p). Space complexity: O(9p + 9p)=O(p).
-This is a lot more efficient than our previous algorithm, which was in time O(n^2) and space O(1).
-Although space was O(1) (because it's about *additional* space, and we did it in-place),
-we still had to rely on an O(n^2) matrix, so overall this algorithm is superior*.
-*With the caveat that a matrix is contiguous in memory, so under certain architecture with certain caches, it might be faster. */
-void GameScreen::updateGrid(){
-    // Maps a coordinate to amount of times it has been added.
-    std::unordered_map<sf::Vector2i, short int, pair_hash, pair_equal> coordinate_to_amount;
-    /* After a shitload of tests and plotting in Matlab, I've come to the conclusion that:
-    -reserving in advance 1.015 times the previous size improves performance.
-    -Tinkering with max_load_factor doesn't do a whole lot. */
-    coordinate_to_amount.reserve(reserved_size);
-
-    // Note for self: from testing, 'addNeighbors()' takes ~75% of function's runtime, while 'applyRules()' takes ~25%.
-    // The costly operation is accessing the map, not iterating over all the neighbors.
-    addNeighbors(coordinate_to_amount);
-    reserved_size = coordinate_to_amount.size() * 1.015;
-
-    applyRules(coordinate_to_amount);
+/* The simulation copies only the cells around the view, and we give it a new rectangle only once the region the render cache
+might be rebuilt for (see 'GridRenderCache') isn't inside the one it has, or is less than half as wide or as tall as it - so a small drag
+doesn't make it publish the generation again, the cache always finds the cells it needs in the snapshot, and the snapshot is never much bigger than them. */
+void GameScreen::updateSimulationView(Simulation& simulation, bool force){
+    sf::IntRect view_cells = viewCells();
+    int margin_x = view_cells.width * RENDER_CACHE_MARGIN, margin_y = view_cells.height * RENDER_CACHE_MARGIN;
+    int left = view_cells.left - margin_x, top = view_cells.top - margin_y;
+    int right = view_cells.left + view_cells.width - 1 + margin_x, bottom = view_cells.top + view_cells.height - 1 + margin_y;
+    if (!force){
+        bool is_inside = simulation_view_rect.left <= left && simulation_view_rect.top <= top && right <= simulation_view_rect.right && bottom <= simulation_view_rect.bottom;
+        // After zooming in, the rectangle it has would be much bigger than what we need
+        bool is_too_big = 2LL * (right - left + 1) < simulation_view_rect.width() || 2LL * (bottom - top + 1) < simulation_view_rect.height();
+        if (is_inside && !is_too_big) return;
+    }
+
+    margin_x = view_cells.width * SIMULATION_VIEW_MARGIN;
+    margin_y = view_cells.height * SIMULATION_VIEW_MARGIN;
+    simulation_view_rect = {view_cells.left - margin_x, view_cells.top - margin_y,
+                            view_cells.left + view_cells.width - 1 + margin_x, view_cells.top + view_cells.height - 1 + margin_y};
+    simulation.setViewRect(simulation_view_rect);
 }
 
 short int GameScreen::run(){
     bool clicking = false;
     sf::Vector2i old_pos;
-    sf::Clock timestep_clock, key_press_clock;
+    sf::Clock key_press_clock;
 
     unsigned long long gen = 0;
-    gen_text.setString("gen: 0");
+    cycle_str.clear();
+    generations_per_second = 0;
+    setGenText(gen);
     gen_text.setScale(zoom, zoom); // 'zoom' might have changed in previous screen, so we need to 'setScale()' first
     gen_text.setPosition(left_top_view_pos.x, left_top_view_pos.y);
+    grid->setRule(rule);
+
+    /* The generations are computed on a thread of their own (see 'Simulation'), and here we only draw the latest snapshot it published.
+    So dragging and zooming stay smooth even when a generation takes a while. Whenever we touch 'grid' itself, we stop the simulation first.
+    It's stopped by its destructor as well, when we leave this screen. */
+    Simulation simulation(grid);
+    simulation.setTimestep(timestep);
+    simulation.setStepSize(1ULL << step_exponent);
+    simulation.setStopOnCycle(stop_on_cycle);
+    simulation.setTurbo(turbo);
+    simulation.setTargetRate(targetRate());
+    simulation.setBlockLevel(std::max(0, blockLevel())); // Zoomed out, the simulation publishes squares of cells instead of cells
+    updateSimulationView(simulation, true);
+    simulation.start();
+    unsigned long long int drawn_snapshot_id = 0;
+    bool is_limit_reported = false;
+    frame_scheduler.requestRedraw();
 
     while (true){
         sf::Event evnt;
-        while (window.pollEvent(evnt)){
+        while (frame_scheduler.pollEvent(window, evnt)){
+            PROFILE_SCOPE("GameScreen::handleEvent");
             switch (evnt.type){
                 case sf::Event::Closed:
                     return -1;
 
                 case sf::Event::KeyPressed:
                     if (evnt.key.code == sf::Keyboard::Escape){
-                        std::cout << "You've stopped the game on the " << gen << " generation" << std::endl;
-                        grid.clear();
+                        simulation.stop();
+                        std::cout << "You've stopped the game on the " << simulation.getGeneration() << " generation" << std::endl;
+                        grid->clear();
+                        setStepExponent(0);
                         zoom = 1;
                         return PATTERN_MENU_SCREEN;
                     }
                     else if (evnt.key.code == sf::Keyboard::Enter){ // Resets game
-                        std::cout << "You've stopped the game on the " << gen << " generation" << std::endl;
-                        grid.clear();
+                        simulation.stop();
+                        std::cout << "You've stopped the game on the " << simulation.getGeneration() << " generation" << std::endl;
+                        grid->clear();
+                        setStepExponent(0);
                         return PATTERN_INPUT_SCREEN;
                     }
-                    else if (evnt.key.code == sf::Keyboard::X) timestep = std::max<short int>(25, timestep - 25); // Speed up
-                    else if (evnt.key.code == sf::Keyboard::Z) timestep = std::min<short int>(700, timestep + 25); // Speed down
+                    else if ((evnt.key.code == sf::Keyboard::X || evnt.key.code == sf::Keyboard::Z) && turbo){
+                        // In turbo mode the speed is the target rate, which goes 10x up or down
+                        if (evnt.key.code == sf::Keyboard::X) target_rate_exponent = std::min<short int>(MAX_TARGET_RATE_EXPONENT + 1, target_rate_exponent + 1);
+                        else target_rate_exponent = std::max<short int>(1, target_rate_exponent - 1);
+                        simulation.setTargetRate(targetRate());
+                        setGenText(gen);
+                    }
+                    else if (evnt.key.code == sf::Keyboard::X || evnt.key.code == sf::Keyboard::Z){
+                        if (evnt.key.code == sf::Keyboard::X) timestep = std::max<short int>(25, timestep - 25); // Speed up
+                        else timestep = std::min<short int>(700, timestep + 25); // Speed down
+                        simulation.setTimestep(timestep);
+                    }
+                    else if (evnt.key.code == sf::Keyboard::T){ // Toggles turbo mode
+                        turbo = !turbo;
+                        simulation.setTurbo(turbo);
+                        setGenText(gen);
+                    }
+                    else if (evnt.key.code == sf::Keyboard::Up || evnt.key.code == sf::Keyboard::Down){ // Doubles or halves the step
+                        simulation.stop(); // The step might move the universe to another engine
+                        if (evnt.key.code == sf::Keyboard::Up) setStepExponent(std::min<short int>(MAX_STEP_EXPONENT, step_exponent + 1));
+                        else setStepExponent(std::max<short int>(0, step_exponent - 1));
+                        simulation.setStepSize(1ULL << step_exponent);
+                        simulation.start();
+                        cycle_str.clear(); // With another step, the period we detect changes too
+                        setGenText(gen);
+                    }
+                    else if (evnt.key.code == sf::Keyboard::K || evnt.key.code == sf::Keyboard::L){ // Saves or restores the game
+                        simulation.stop();
+                        if (evnt.key.code == sf::Keyboard::K) saveGame();
+                        else restoreGame();
+                        simulation.setBlockLevel(std::max(0, blockLevel())); // The checkpoint's view might be zoomed differently
+                        simulation.start();
+                        setGenText(simulation.getGeneration());
+                    }
+                    else if (evnt.key.code == sf::Keyboard::C){ // Toggles stopping on a cycle
+                        stop_on_cycle = !stop_on_cycle;
+                        simulation.setStopOnCycle(stop_on_cycle);
+                        std::cout << (stop_on_cycle ? "The simulation will stop once the pattern repeats itself" :
+                                                      "The simulation will keep running when the pattern repeats itself") << std::endl;
+                        if (!stop_on_cycle && !cycle_str.empty()) simulation.start(); // It might have stopped already
+                    }
                     break;
 
                 case sf::Event::MouseButtonPressed:
@@ -128,6 +243,7 @@ short int GameScreen::run(){
                     sf::Vector2i new_pos = sf::Vector2i(evnt.mouseMove.x, evnt.mouseMove.y);
                     handleDrag(old_pos, new_pos);
                     gen_text.setPosition(left_top_view_pos.x, left_top_view_pos.y);
+                    frame_scheduler.requestRedraw();
                     break;
                 }
 
@@ -138,37 +254,56 @@ short int GameScreen::run(){
                 case sf::Event::MouseWheelScrolled:
                     handleZoom(evnt.mouseWheelScroll.delta);
                     gen_text.setScale(zoom, zoom);
+                    simulation.setBlockLevel(std::max(0, blockLevel()));
                     break;
             }
         }
 
         int delta_time = key_press_clock.restart().asMilliseconds();
-        if (window.hasFocus()){
-            checkForChangeViewWithKeys(delta_time);
+        if (window.hasFocus() && checkForChangeViewWithKeys(delta_time)){
             gen_text.setPosition(left_top_view_pos.x, left_top_view_pos.y);
+            frame_scheduler.requestRedraw();
         }
+        updateSimulationView(simulation); // After a drag, a zoom, a resize or a move with the keys
 
-        /* Using 'sleep' would lag other events like resizing or restarting the grid (since 'sleep' pauses the entire program for its duration).
-        A better solution is to use 'sf::clock', which lets us check for elapsed time.
-        When that elapsed time is bigger than our 'TIMESTEP' duration, we reset the clock and redraw the grid. */
-        if (sf::milliseconds(timestep) <= timestep_clock.getElapsedTime()){
-            timestep_clock.restart();
-            gen++;
-            gen_text.setString("gen: " + std::to_string(gen));
-
-            // Note to self: this is the most expensive function in an iteration, and the only one with runtime dependent on amount of live cells.
-            // It takes about 90% of an iteration's runtime.
-            updateGrid();
-            if (grid.empty()){ // If grid clears itself, we begin to get input again.
-                std::cout << "This pattern lived for " << gen << " generations." << std::endl;
-
-                return PATTERN_INPUT_SCREEN;
-            }
+        // Holding the snapshot keeps it alive (and unchanged) until we're done drawing it, even if a newer one is published meanwhile.
+        std::shared_ptr<const GridSnapshot> snapshot = simulation.latestSnapshot();
+        if (snapshot->in_cycle && cycle_str.empty()){
+            reportCycle(snapshot->cycle);
+            setGenText(gen);
+        }
+        if (snapshot->is_at_coordinate_limit && !is_limit_reported){
+            std::cout << "The pattern would move beyond the coordinates we can represent, so the simulation has stopped on the " << snapshot->generation << " generation." << std::endl;
         }
+        is_limit_reported = snapshot->is_at_coordinate_limit; // A restarted simulation (say, with another step) might get there again
+        if (snapshot->generation != gen || snapshot->generations_per_second != generations_per_second){
+            gen = snapshot->generation;
+            generations_per_second = snapshot->generations_per_second;
+            setGenText(gen);
+        }
+
+        if (snapshot->population == 0){ // If grid clears itself, we begin to get input again.
+            simulation.stop();
+            std::cout << "This pattern lived for " << gen << " generations." << std::endl;
+            setStepExponent(0);
 
+            return PATTERN_INPUT_SCREEN;
+        }
+
+        /* A new generation (or a new rate) comes in a new snapshot, so if we've drawn this one already, and nothing happened since, we skip the frame.
+        While the window isn't visible we don't draw at all, but we still look at the snapshots above, so a cycle or an extinction is noticed on time. */
+        if (snapshot->id != drawn_snapshot_id) frame_scheduler.requestRedraw();
+        if (!frame_scheduler.startFrame()) continue;
+        drawn_snapshot_id = snapshot->id;
+
+        // The frame is only the drawing: not the wait for its turn (see 'FrameScheduler'). 'drawGrid()' and 'display()' are timed on their own as well.
+        PROFILE_SCOPE("GameScreen::frame");
         window.clear(dead_cell_color);
-        drawGrid();
+        drawGrid(*snapshot);
         window.draw(gen_text);
-        window.display();
+        {
+            PROFILE_SCOPE("GameScreen::display");
+            window.display();
+        }
     }
 }
\ No newline at end of file
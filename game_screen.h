@@ -2,18 +2,35 @@
 #define GAME_OF_LIFE_GAME_SCREEN_H
 
 #include <SFML/Graphics.hpp>
-#include <unordered_map>
 #include "screens.h"
+#include "checkpoint.h"
+#include "simulation.h"
+
+#define MAX_STEP_EXPONENT 40
+#define CHECKPOINT_PATH "game.ckpt" // Where 'K' saves the game, and 'L' restores it from
+#define SIMULATION_VIEW_MARGIN 1 // The simulation copies the cells this many view sizes beyond each side of the view (a bit more than the render cache asks for)
+#define MAX_TARGET_RATE_EXPONENT 8 // In turbo mode the target rate goes up to 10^8 generations/sec, and above it there's no target
 
 class GameScreen: public GridScreen{
 private:
     short int timestep;
-    int reserved_size; // Stores previous size of the map allocated in 'updateGrid', so that we can 'reserve()' in the next call
+    short int step_exponent; // Every timestep we advance 2^'step_exponent' generations
+    bool turbo; // Whether we run as many generations as fit in a frame, instead of a step every timestep (toggled with 'T')
+    short int target_rate_exponent; // In turbo mode we aim for 10^'target_rate_exponent' generations/sec, or as many as we can above the max
+    double generations_per_second; // The rate shown next to the generation
+    bool stop_on_cycle; // Whether the simulation stops once the pattern repeats itself (toggled with 'C')
+    std::string cycle_str; // Describes the cycle the pattern is in, or empty if it isn't (yet)
     sf::Text gen_text;
+    BoundingBox simulation_view_rect; // The cells the simulation copies into its snapshots (see 'Simulation::setViewRect()')
 
-    void addNeighbors(std::unordered_map<sf::Vector2i, short int, pair_hash, pair_equal>& m) const;
-    static void applyRules(const std::unordered_map<sf::Vector2i, short int, pair_hash, pair_equal>& m);
-    void updateGrid();
+    static void switchEngine(const std::string& engine_name);
+    void setStepExponent(short int exponent);
+    unsigned long long int targetRate() const;
+    void setGenText(unsigned long long int gen);
+    void reportCycle(const CycleInfo& cycle);
+    void saveGame() const;
+    void restoreGame();
+    void updateSimulationView(Simulation& simulation, bool force = false);
 
 public:
     GameScreen();
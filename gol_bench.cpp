@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "allocation_counter.h"
+#include "engines.h"
+#include "profiler.h"
+#include "rle.h"
+#include "step_kernel_names.h"
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif !defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+/* Benchmark suite: runs every engine over a fixed corpus for a fixed amount of generations, and prints the results as JSON,
+so that runs on different commits can be diffed (and so that the claims in the comments about speedups can be checked).
+The corpus is every .rle file under the patterns directory, plus random soups of 10^4 up to 10^7 live cells (with a fixed seed).
+Usage: gol-bench [-d <patterns dir>] [-g <generations>] [-e <engine>]... [-m <max soup exponent>] [-b <seconds>] [-r <rulestring>] [-t <threads>] [-s <seed>]
+By default: the "patterns" directory, 100 generations, all the engines, soups up to 10^7 cells, Game of Life, all the cores and seed 1.
+A run that takes longer than the time budget (-b, 60 seconds by default) stops early; its "generations" field tells how many it did.
+
+For every run we report:
+-generations_per_sec.
+-cells_per_sec: live cells advanced per second (the population summed over the generations, divided by the time).
+-peak_rss_kb: the peak resident memory during the run. On Linux it's reset before every run; elsewhere it's the peak of the whole process so far.
+-allocations_per_generation: calls to 'operator new' during the run, divided by the generations. */
+
+struct BenchPattern{
+    std::string name;
+    std::vector<Cell> cells;
+};
+
+struct BenchResult{
+    unsigned long long int generations, initial_population, final_population;
+    double seconds, cells_per_sec, generations_per_sec, allocations_per_generation;
+    long long int peak_rss_kb;
+};
+
+static void printUsage(){
+    std::cerr << "usage: gol-bench [-d <patterns dir>] [-g <generations>] [-e <engine>]... [-m <max soup exponent>] [-b <seconds>]"
+                 " [-r <rulestring>] [-t <threads>] [-s <seed>]" << std::endl;
+}
+
+static void resetPeakRSS(){
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5"; // Resets the peak to the current resident memory
+#endif
+}
+
+// Returns -1 if it's not available.
+static long long int peakRSSKilobytes(){
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return counters.PeakWorkingSetSize / 1024;
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)){
+        if (line.rfind("VmHWM:", 0) == 0) return std::atoll(line.c_str() + 6);
+    }
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // In bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// A square soup with density 1/2, so it has about 'live_cells' live cells.
+static BenchPattern makeSoup(unsigned long long int live_cells, unsigned int seed){
+    int side = std::sqrt(2.0 * live_cells);
+    std::mt19937_64 random(seed);
+
+    BenchPattern soup = {"soup-1e" + std::to_string((int)std::log10(live_cells)), {}};
+    soup.cells.reserve(live_cells + live_cells / 16);
+    for (int y = 0; y < side; y++){
+        for (int x = 0; x < side; x += 64){
+            uint64_t bits = random();
+            for (int i = 0; i < 64 && x + i < side; i++){
+                if (bits >> i & 1) soup.cells.push_back({x + i, y});
+            }
+        }
+    }
+
+    return soup;
+}
+
+static BenchResult runBenchmark(const std::string& engine_name, const BenchPattern& pattern, const Rule& rule, int thread_count,
+                                unsigned long long int generations, double time_budget){
+    BenchResult result = {};
+    resetPeakRSS();
+
+    std::unique_ptr<Engine> engine = createEngine(engine_name);
+    engine->setRule(rule);
+    engine->setThreadCount(thread_count);
+    for (const auto& cell : pattern.cells) engine->insert(cell);
+    result.initial_population = engine->population();
+
+    unsigned long long int cells_advanced = 0;
+    unsigned long long int allocations_before = allocationCount();
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+
+    while (result.generations < generations){
+        cells_advanced += engine->population();
+        engine->step();
+        result.generations++;
+
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (time_budget < seconds) break;
+    }
+
+    result.allocations_per_generation = result.generations ? (double)(allocationCount() - allocations_before) / result.generations : 0;
+    result.peak_rss_kb = peakRSSKilobytes();
+    result.final_population = engine->population();
+    result.seconds = seconds;
+    result.generations_per_sec = seconds ? result.generations / seconds : 0;
+    result.cells_per_sec = seconds ? cells_advanced / seconds : 0;
+
+    return result;
+}
+
+int main(int argc, char* argv[]){
+    std::string patterns_dir = "patterns";
+    unsigned long long int generations = 100;
+    std::vector<std::string> engine_names;
+    int max_soup_exponent = 7;
+    double time_budget = 60;
+    Rule rule({3}, {2, 3});
+    std::string rulestring = "B3/S23";
+    int thread_count = std::thread::hardware_concurrency();
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 == argc){
+            printUsage();
+            return -1;
+        }
+
+        if (arg == "-d") patterns_dir = argv[++i];
+        else if (arg == "-g") generations = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-m") max_soup_exponent = std::atoi(argv[++i]);
+        else if (arg == "-b") time_budget = std::atof(argv[++i]);
+        else if (arg == "-t") thread_count = std::atoi(argv[++i]);
+        else if (arg == "-s") seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "-e"){
+            engine_names.push_back(argv[++i]);
+            if (!createEngine(engine_names.back())){
+                std::cerr << "unknown engine " << engine_names.back() << std::endl;
+                return -1;
+            }
+        }
+        else if (arg == "-r"){
+            rulestring = argv[++i];
+            if (!parseRulestring(rulestring, rule)){
+                std::cerr << "bad rulestring, terminating..." << std::endl;
+                return -1;
+            }
+        }
+        else{
+            printUsage();
+            return -1;
+        }
+    }
+    if (engine_names.empty()) engine_names = engineNames();
+
+    // Sorted, so that the order of the results is the same on every run.
+    std::vector<std::string> pattern_paths;
+    if (std::filesystem::is_directory(patterns_dir)){
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(patterns_dir)){
+            if (entry.is_regular_file() && entry.path().extension().string() == ".rle") pattern_paths.push_back(entry.path().string());
+        }
+    }
+    else std::cerr << "no " << patterns_dir << " directory, running only the soups" << std::endl;
+    std::sort(pattern_paths.begin(), pattern_paths.end());
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"generations\": " << generations << "," << std::endl;
+    std::cout << "  \"rule\": " << jsonString(rulestring) << "," << std::endl;
+    std::cout << "  \"threads\": " << thread_count << "," << std::endl;
+    std::cout << "  \"simd\": " << jsonString(simdLevelName(selectedSimdLevel())) << "," << std::endl;
+    std::cout << "  \"seed\": " << seed << "," << std::endl;
+    std::cout << "  \"results\": [";
+
+    bool is_first_result = true;
+    // The soups are generated one at a time (the biggest one takes a few hundred MB).
+    for (size_t i = 0; i < pattern_paths.size() + std::max(0, max_soup_exponent - 3); i++){
+        BenchPattern pattern;
+        if (i < pattern_paths.size()){
+            pattern.name = pattern_paths[i];
+            if (readRLE(pattern.name, pattern.cells) != RLE_OK){
+                std::cerr << "can't read " << pattern.name << ", skipping it" << std::endl;
+                continue;
+            }
+        }
+        else{
+            unsigned long long int live_cells = 1;
+            for (size_t j = 0; j < 4 + i - pattern_paths.size(); j++) live_cells *= 10;
+            pattern = makeSoup(live_cells, seed);
+        }
+
+        for (const auto& engine_name : engine_names){
+            std::cerr << engine_name << " on " << pattern.name << "..." << std::endl;
+            BenchResult result = runBenchmark(engine_name, pattern, rule, thread_count, generations, time_budget);
+
+            std::ostringstream line;
+            line << (is_first_result ? "" : ",") << std::endl << "    {\"engine\": " << jsonString(engine_name)
+                 << ", \"pattern\": " << jsonString(pattern.name)
+                 << ", \"initial_population\": " << result.initial_population
+                 << ", \"final_population\": " << result.final_population
+                 << ", \"generations\": " << result.generations
+                 << ", \"seconds\": " << result.seconds
+                 << ", \"generations_per_sec\": " << result.generations_per_sec
+                 << ", \"cells_per_sec\": " << result.cells_per_sec
+                 << ", \"peak_rss_kb\": " << result.peak_rss_kb
+                 << ", \"allocations_per_generation\": " << result.allocations_per_generation << "}";
+            std::cout << line.str() << std::flush;
+            is_first_result = false;
+        }
+    }
+
+    std::cout << std::endl << "  ]" << std::endl << "}" << std::endl;
+    return 0;
+}
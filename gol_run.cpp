@@ -0,0 +1,277 @@
+#include <iostream>
+#include <chrono>
+#include <climits>
+#include <string>
+#include <thread>
+#include "cycle_detector.h"
+#include "checkpoint.h"
+#include "engines.h"
+#include "macrocell.h"
+#include "rle.h"
+#include "step_kernel_names.h"
+
+/* Headless runner: loads an .rle or a .mc (macrocell) file, or a .ckpt checkpoint, advances it by N generations as fast as possible,
+and prints the population, the bounding box and the wall time.
+It doesn't touch SFML at all, so it runs on machines without a display.
+Usage: gol-run <pattern.rle|pattern.mc|run.ckpt> <generations> [-r <rulestring>] [-e <engine>] [-s <simd>] [-t <threads>] [-c <stop|skip>]
+               [-o <out.rle|out.mc|out.ckpt>] [-p <generations>]
+The rulestring is of the form "B3/S23", and defaults to the rule in the file's header, or to Game of Life if it has none.
+The engine is "tiled" (default), "sparse" or "hashlife".
+The SIMD kernel of the tiled engine is "scalar", "sse2", "avx2" or "avx512", and defaults to the best one the CPU supports.
+The amount of threads defaults to the amount of cores.
+With -c, the pattern is advanced one generation at a time, and checked for a cycle (see 'CycleDetector') after every generation.
+Once it's found, "stop" stops right there, and "skip" jumps over the repetitions of the cycle up to the requested generation.
+With -o, the final state is written to a file, in the format of its extension.
+A checkpoint keeps the generation and the rule as well, so a run that is loaded from one continues where it stopped (and runs N more generations).
+With -p as well, the checkpoint is also saved every that many generations, so a long run can be resumed after a crash. */
+
+static void printUsage(){
+    std::cerr << "usage: gol-run <pattern.rle|pattern.mc|run.ckpt> <generations> [-r <rulestring>] [-e <engine>] [-s <simd>] [-t <threads>] [-c <stop|skip>] "
+                 "[-o <out.rle|out.mc|out.ckpt>] [-p <generations>]" << std::endl;
+}
+
+static bool hasExtension(const std::string& file_path, const std::string& extension){
+    return extension.size() <= file_path.size() && file_path.compare(file_path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+static bool isMacrocellPath(const std::string& file_path){
+    return hasExtension(file_path, ".mc");
+}
+
+static bool isCheckpointPath(const std::string& file_path){
+    return hasExtension(file_path, ".ckpt");
+}
+
+int main(int argc, char* argv[]){
+    if (argc < 3){
+        printUsage();
+        return -1;
+    }
+
+    std::string file_path = argv[1];
+    unsigned long long int generations;
+    try {
+        generations = std::stoull(argv[2]);
+    } catch (std::exception& exc) {
+        printUsage();
+        return -1;
+    }
+
+    Rule rule({3}, {2, 3});
+    bool has_rule = false;
+    std::string engine_name = "tiled";
+    int thread_count = std::thread::hardware_concurrency();
+    std::string cycle_action; // Empty if we don't look for cycles
+    std::string output_path;
+    unsigned long long int checkpoint_period = 0; // 0 if we save the checkpoint only at the end
+    for (int i = 3; i < argc; i++){
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc){
+            if (!parseRulestring(argv[++i], rule)){
+                std::cerr << "bad rulestring, terminating..." << std::endl;
+                return -1;
+            }
+            has_rule = true;
+        }
+        else if (arg == "-e" && i + 1 < argc){
+            engine_name = argv[++i];
+        }
+        else if (arg == "-s" && i + 1 < argc){
+            simd_level level;
+            if (!parseSimdLevel(argv[++i], level)){
+                std::cerr << "unknown SIMD kernel " << argv[i] << std::endl;
+                return -1;
+            }
+            forceSimdLevel(level);
+        }
+        else if (arg == "-t" && i + 1 < argc){
+            thread_count = std::atoi(argv[++i]);
+        }
+        else if (arg == "-c" && i + 1 < argc && (std::string(argv[i + 1]) == "stop" || std::string(argv[i + 1]) == "skip")){
+            cycle_action = argv[++i];
+        }
+        else if (arg == "-o" && i + 1 < argc){
+            output_path = argv[++i];
+        }
+        else if (arg == "-p" && i + 1 < argc){
+            checkpoint_period = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else{
+            printUsage();
+            return -1;
+        }
+    }
+
+    if (checkpoint_period != 0 && !isCheckpointPath(output_path)){
+        std::cerr << "-p needs a checkpoint to write, with -o <out.ckpt>" << std::endl;
+        return -1;
+    }
+
+    RLEReader reader;
+    Quadtree tree;
+    MacrocellHeader macrocell_header;
+    std::string file_rule;
+    if (isCheckpointPath(file_path)){ } // The rule is in the checkpoint, and it's loaded only once there's an engine
+    else if (isMacrocellPath(file_path)){
+        mc_status status = readMacrocell(file_path, tree, macrocell_header);
+        if (status == MC_FILE_ERROR){
+            std::cerr << "Can't open " << file_path << std::endl;
+            return -1;
+        }
+        else if (status == MC_FORMAT_ERROR){
+            std::cerr << "bad macrocell file, terminating..." << std::endl;
+            return -1;
+        }
+        file_rule = macrocell_header.rule;
+    }
+    else{
+        rle_status status = reader.open(file_path);
+        if (status == RLE_FILE_ERROR){
+            std::cerr << "Can't open " << file_path << std::endl;
+            return -1;
+        }
+        else if (status == RLE_FORMAT_ERROR){
+            std::cerr << "bad RLE file, terminating..." << std::endl;
+            return -1;
+        }
+        file_rule = reader.getHeader().rule;
+    }
+
+    if (!has_rule && !file_rule.empty() && !parseRulestring(file_rule, rule)){
+        std::cerr << "unsupported rule " << file_rule << " in the file, use -r" << std::endl;
+        return -1;
+    }
+
+    std::unique_ptr<Engine> engine = createEngine(engine_name);
+    if (!engine){
+        std::cerr << "unknown engine " << engine_name << std::endl;
+        return -1;
+    }
+    engine->setRule(rule);
+    engine->setThreadCount(thread_count);
+    if (isCheckpointPath(file_path)){
+        CheckpointViewport viewport;
+        Rule checkpoint_rule;
+        checkpoint_status status = loadCheckpoint(file_path, *engine, checkpoint_rule, viewport);
+        if (status == CHECKPOINT_FILE_ERROR){
+            std::cerr << "Can't open " << file_path << std::endl;
+            return -1;
+        }
+        else if (status == CHECKPOINT_VERSION_ERROR){
+            std::cerr << "the checkpoint is of another version, terminating..." << std::endl;
+            return -1;
+        }
+        else if (status != CHECKPOINT_OK){
+            std::cerr << "bad checkpoint file, terminating..." << std::endl;
+            return -1;
+        }
+
+        if (has_rule) engine->setRule(rule);
+        else rule = checkpoint_rule;
+    }
+    else if (isMacrocellPath(file_path)){
+        // Golly puts the root's center at (0,0), and so do we
+        long long int left = -(1LL << (tree.level() - 1)), top = left;
+        trimQuadtree(tree, left, top);
+        long long int size = 1LL << std::min(tree.level(), QUADTREE_MAX_LEVEL + 1);
+        if (QUADTREE_MAX_LEVEL < tree.level() || left < INT_MIN || INT_MAX < left + size - 1 || top < INT_MIN || INT_MAX < top + size - 1){
+            std::cerr << "the pattern is too big, terminating..." << std::endl;
+            return -1;
+        }
+        engine->insertQuadtree(tree, left, top);
+    }
+    else if (reader.insertInto(*engine) != RLE_OK){
+        std::cerr << "bad RLE file, terminating..." << std::endl;
+        return -1;
+    }
+
+    // Saved with -p, so a long run can be resumed from its last checkpoint
+    bool checkpoint_failed = false;
+    auto saveCheckpointIfDue = [&](){
+        if (checkpoint_period == 0 || engine->getGeneration() % checkpoint_period != 0) return;
+        if (saveCheckpoint(output_path, *engine, rule, {false, 0, 0, 0}) != CHECKPOINT_OK && !checkpoint_failed){
+            std::cerr << "Can't write " << output_path << std::endl;
+            checkpoint_failed = true;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long int target_generation = engine->getGeneration() + generations;
+    bool found_cycle = false;
+    CycleInfo cycle;
+    if (cycle_action.empty()){
+        while (engine->getGeneration() < target_generation){
+            // Up to the next multiple of the period, so the checkpoints are at round generations
+            unsigned long long int batch = target_generation - engine->getGeneration();
+            if (checkpoint_period != 0) batch = std::min(batch, checkpoint_period - engine->getGeneration() % checkpoint_period);
+
+            engine->advance(batch);
+            if (engine->isAtCoordinateLimit()) break;
+            saveCheckpointIfDue();
+        }
+    }
+    else{
+        CycleDetector cycle_detector;
+        cycle_detector.record(engine->getGeneration(), engine->signature(), cycle);
+        while (engine->getGeneration() < target_generation && !found_cycle){
+            engine->step();
+            if (engine->isAtCoordinateLimit()) break;
+            found_cycle = cycle_detector.record(engine->getGeneration(), engine->signature(), cycle);
+            saveCheckpointIfDue();
+        }
+
+        if (found_cycle && cycle_action == "skip"){
+            cycle_skip_status status = fastForwardCycle(*engine, cycle, target_generation - engine->getGeneration());
+            if (status == CYCLE_NOT_REPEATING){
+                std::cerr << "the state only looked like an earlier one, so there's no cycle to skip" << std::endl;
+                found_cycle = false;
+            }
+            else if (status == CYCLE_OUT_OF_BOUNDS) std::cerr << "the pattern would move out of bounds, so the cycle isn't skipped" << std::endl;
+            engine->advance(target_generation - engine->getGeneration());
+        }
+    }
+    // The rest of the output (and the file) is of the generation we stopped at: the right state, only not the one asked for
+    bool is_at_coordinate_limit = engine->isAtCoordinateLimit();
+    if (is_at_coordinate_limit){
+        std::cerr << "the pattern would move beyond the coordinates we can represent, so it's stopped at generation " << engine->getGeneration() << std::endl;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if (found_cycle){
+        std::cout << "cycle: period " << cycle.period << ", displacement (" << cycle.dx << ", " << cycle.dy << "), from generation "
+                  << cycle.generation - cycle.period << std::endl;
+    }
+    else if (!cycle_action.empty()) std::cout << "cycle: none" << std::endl;
+
+    std::cout << "generation: " << engine->getGeneration() << std::endl;
+    std::cout << "population: " << engine->population() << std::endl;
+    if (!engine->empty()){
+        BoundingBox box = engine->boundingBox();
+        std::cout << "bounding box: (" << box.left << ", " << box.top << ") - (" << box.right << ", " << box.bottom << "), "
+                  << box.width() << "x" << box.height() << std::endl;
+    }
+    if (engine_name == "tiled") std::cout << "simd kernel: " << simdLevelName(selectedSimdLevel()) << std::endl;
+    std::cout << "wall time: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+    if (!output_path.empty()){
+        bool written;
+        if (isCheckpointPath(output_path)) written = saveCheckpoint(output_path, *engine, rule, {false, 0, 0, 0}) == CHECKPOINT_OK;
+        else if (isMacrocellPath(output_path)){
+            engine->buildQuadtree(tree);
+            written = writeMacrocell(output_path, tree, rule) == MC_OK;
+        }
+        else{
+            std::vector<Cell> cells;
+            cells.reserve(engine->population());
+            engine->forEachCell([&cells](const Cell& cell){ cells.push_back(cell); });
+            written = writeRLE(output_path, cells, rule) == RLE_OK;
+        }
+
+        if (!written){
+            std::cerr << "Can't write " << output_path << std::endl;
+            return -1;
+        }
+    }
+
+    return is_at_coordinate_limit ? -1 : 0;
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <iostream>
+#include "grid_density_cache.h"
+
+GridDensityCache::GridDensityCache(): is_valid(false), source_id(0), level(0), cell_size(0) { }
+
+void GridDensityCache::invalidate(){
+    is_valid = false;
+}
+
+// The squares of a view are the ones its corners fall in. '>>' rounds towards minus infinity, like the squares themselves.
+static sf::IntRect viewBlocks(const sf::IntRect& view_cells, int level){
+    int left = view_cells.left >> level, top = view_cells.top >> level;
+    int right = (view_cells.left + view_cells.width - 1) >> level, bottom = (view_cells.top + view_cells.height - 1) >> level;
+
+    return sf::IntRect(left, top, right - left + 1, bottom - top + 1);
+}
+
+bool GridDensityCache::shows(unsigned long long int id, const sf::IntRect& view_cells, int new_level, int new_cell_size, const sf::Color& new_cell_color) const{
+    if (!is_valid || id != source_id || new_level != level || new_cell_size != cell_size || new_cell_color != cell_color) return false;
+
+    sf::IntRect view_blocks = viewBlocks(view_cells, level);
+    return region.left <= view_blocks.left && view_blocks.left + view_blocks.width <= region.left + region.width &&
+           region.top <= view_blocks.top && view_blocks.top + view_blocks.height <= region.top + region.height;
+}
+
+void GridDensityCache::startRebuild(const sf::IntRect& view_cells, unsigned long long int new_source_id, int new_level, int new_cell_size,
+                                    const sf::Color& new_cell_color){
+    sf::IntRect view_blocks = viewBlocks(view_cells, new_level);
+    int margin_x = view_blocks.width * DENSITY_CACHE_MARGIN, margin_y = view_blocks.height * DENSITY_CACHE_MARGIN;
+    region = sf::IntRect(view_blocks.left - margin_x, view_blocks.top - margin_y, view_blocks.width + 2 * margin_x, view_blocks.height + 2 * margin_y);
+    source_id = new_source_id;
+    level = new_level;
+    cell_size = new_cell_size;
+    cell_color = new_cell_color;
+
+    populations.assign((size_t)region.width * region.height, 0);
+}
+
+void GridDensityCache::addBlock(const Cell& block, unsigned long long int population){
+    if (block.x < region.left || region.left + region.width <= block.x || block.y < region.top || region.top + region.height <= block.y) return;
+
+    populations[(size_t)(block.y - region.top) * region.width + (block.x - region.left)] += population;
+}
+
+/* An empty square is transparent, so the background (which is cleared to the dead cell color) shows through it,
+and a live one is the live cell color, as opaque as the square is full - at least 'DENSITY_MIN_SHADE'. */
+void GridDensityCache::finishRebuild(){
+    double cells_per_block = (double)(1ULL << level) * (1ULL << level);
+    pixels.resize(4 * populations.size());
+    for (size_t i = 0; i < populations.size(); i++){
+        double shade = populations[i] == 0 ? 0 : DENSITY_MIN_SHADE + (1 - DENSITY_MIN_SHADE) * std::min(1.0, populations[i] / cells_per_block);
+        pixels[4 * i] = cell_color.r;
+        pixels[4 * i + 1] = cell_color.g;
+        pixels[4 * i + 2] = cell_color.b;
+        pixels[4 * i + 3] = (sf::Uint8)(255 * shade);
+    }
+
+    if (texture.getSize() != sf::Vector2u(region.width, region.height) && !texture.create(region.width, region.height)){
+        std::cerr << "Could not create a " << region.width << "x" << region.height << " texture for the grid" << std::endl;
+        exit(-1);
+    }
+    texture.update(pixels.data());
+    texture.setSmooth(false); // Every square is a sharp square, not a blur
+
+    float block_size = (float)(1ULL << level) * cell_size;
+    sprite.setTexture(texture, true);
+    sprite.setPosition((float)region.left * block_size, (float)region.top * block_size);
+    sprite.setScale(block_size, block_size);
+    is_valid = true;
+}
+
+void GridDensityCache::draw(sf::RenderTarget& target) const{
+    target.draw(sprite);
+}
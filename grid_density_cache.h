@@ -0,0 +1,62 @@
+#ifndef GAME_OF_LIFE_GRID_DENSITY_CACHE_H
+#define GAME_OF_LIFE_GRID_DENSITY_CACHE_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "cell.h"
+#include "profiler.h"
+
+#define DENSITY_CACHE_MARGIN 0.25 // Like 'RENDER_CACHE_MARGIN'. It's smaller, since the whole texture is uploaded whenever the cells change.
+#define DENSITY_MIN_SHADE 0.35 // A square with a single live cell gets this much of the live cell color, so a lone glider doesn't vanish when zoomed out
+
+/* The grid as it's drawn when zoomed out: a texture with a texel per square of 2^level x 2^level cells (see 'Engine::forEachBlock()'),
+shaded from the dead cell color (no live cells) to the live cell color (all live) by the square's population.
+It's stretched over the squares with a single sprite, so a frame costs the same with a hundred live cells or with a hundred million.
+
+Like 'GridRenderCache', it covers a region a bit bigger than the view, and remembers which snapshot (or engine) it shows,
+so it's rebuilt only when the cells change or the view leaves the region. */
+class GridDensityCache{
+private:
+    sf::Texture texture;
+    sf::Sprite sprite;
+    std::vector<unsigned long long int> populations; // Of the region's squares, row by row
+    std::vector<sf::Uint8> pixels; // RGBA, of the same squares
+
+    bool is_valid;
+    sf::IntRect region; // In squares
+    unsigned long long int source_id; // Of the snapshot the cache shows, or 0 for the engine itself
+    int level;
+    int cell_size;
+    sf::Color cell_color;
+
+    void startRebuild(const sf::IntRect& view_cells, unsigned long long int new_source_id, int new_level, int new_cell_size, const sf::Color& new_cell_color);
+    void addBlock(const Cell& block, unsigned long long int population);
+    void finishRebuild();
+
+public:
+    GridDensityCache();
+
+    // Makes the next draw rebuild the cache (for when the cells it shows have changed some other way).
+    void invalidate();
+    // Whether the cache shows 'id' (0 for the engine) around 'view_cells', in squares of 'new_level' and in this color.
+    bool shows(unsigned long long int id, const sf::IntRect& view_cells, int new_level, int new_cell_size, const sf::Color& new_cell_color) const;
+
+    /* Rebuilds the cache around 'view_cells' for the cells of 'id', in squares of 'new_level'.
+    'for_each_block' calls a function for every square of 'source_level' that has live cells, with its population (like 'Engine::forEachBlock()').
+    The source's squares may be smaller than ours (a level 0 square is a cell), and then they're added up. */
+    template <class ForEachBlock>
+    void rebuild(unsigned long long int id, const sf::IntRect& view_cells, int new_level, int source_level, const ForEachBlock& for_each_block,
+                 int new_cell_size, const sf::Color& new_cell_color){
+        PROFILE_SCOPE("GridDensityCache::rebuild");
+        startRebuild(view_cells, id, new_level, new_cell_size, new_cell_color);
+
+        int shift = new_level - source_level;
+        for_each_block([this, shift](const Cell& block, unsigned long long int population){ addBlock({block.x >> shift, block.y >> shift}, population); });
+
+        finishRebuild();
+    }
+
+    void draw(sf::RenderTarget& target) const;
+};
+
+#endif
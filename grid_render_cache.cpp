@@ -0,0 +1,142 @@
+#include <algorithm>
+#include "grid_render_cache.h"
+
+GridRenderCache::GridRenderCache(): cells_buffer(sf::PrimitiveType::Quads, sf::VertexBuffer::Dynamic), lines_buffer(sf::PrimitiveType::Lines, sf::VertexBuffer::Static),
+use_buffers(sf::VertexBuffer::isAvailable()), dirty_begin(0), dirty_end(0), cells_buffer_capacity(0),
+is_valid(false), source_id(0), cell_size(0) { }
+
+void GridRenderCache::invalidate(){
+    is_valid = false;
+}
+
+bool GridRenderCache::shows(unsigned long long int id, const sf::IntRect& view_cells, int new_cell_size,
+                            const sf::Color& new_cell_color, const sf::Color& new_line_color) const{
+    if (!is_valid || id != source_id || new_cell_size != cell_size || new_cell_color != cell_color || new_line_color != line_color) return false;
+
+    bool view_inside = region.left <= view_cells.left && view_cells.left + view_cells.width <= region.left + region.width &&
+                       region.top <= view_cells.top && view_cells.top + view_cells.height <= region.top + region.height;
+    bool view_too_small = RENDER_CACHE_MAX_SHRINK * view_cells.width < region.width || RENDER_CACHE_MAX_SHRINK * view_cells.height < region.height;
+    bool too_many_free_slots = RENDER_CACHE_MIN_COMPACTION <= free_slots.size() && cell_slots.size() < free_slots.size();
+
+    return view_inside && !view_too_small && !too_many_free_slots;
+}
+
+void GridRenderCache::setQuad(unsigned int slot, const Cell& cell, const sf::Color& color){
+    float left = (float)cell.x * cell_size, top = (float)cell.y * cell_size;
+    sf::Vertex* quad = &cell_vertices[4 * slot];
+    quad[0] = sf::Vertex(sf::Vector2f(left, top), color);
+    quad[1] = sf::Vertex(sf::Vector2f(left + cell_size, top), color);
+    quad[2] = sf::Vertex(sf::Vector2f(left + cell_size, top + cell_size), color);
+    quad[3] = sf::Vertex(sf::Vector2f(left, top + cell_size), color);
+}
+
+void GridRenderCache::markDirty(unsigned int slot){
+    if (dirty_begin == dirty_end){
+        dirty_begin = slot;
+        dirty_end = slot + 1;
+        return;
+    }
+    dirty_begin = std::min<size_t>(dirty_begin, slot);
+    dirty_end = std::max<size_t>(dirty_end, slot + 1);
+}
+
+void GridRenderCache::setCell(const Cell& cell, bool live){
+    if (cell.x < region.left || region.left + region.width <= cell.x || cell.y < region.top || region.top + region.height <= cell.y) return;
+    if (live == cell_slots.count(cell)) return;
+
+    if (live){
+        unsigned int slot;
+        if (!free_slots.empty()){
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        else{
+            slot = cell_vertices.size() / 4;
+            cell_vertices.resize(cell_vertices.size() + 4);
+        }
+
+        cell_slots[cell] = slot;
+        setQuad(slot, cell, cell_color);
+        markDirty(slot);
+    }
+    else{
+        unsigned int slot = cell_slots[cell];
+        cell_slots.erase(cell);
+
+        // A quad whose 4 corners are the same point covers no pixels
+        for (int i = 0; i < 4; i++) cell_vertices[4 * slot + i] = sf::Vertex(sf::Vector2f(0, 0), sf::Color::Transparent);
+        free_slots.push_back(slot);
+        markDirty(slot);
+    }
+}
+
+// The region is the view with a margin on each side, and the lines are those of the whole region, so both are good for as long as the view stays in it.
+void GridRenderCache::startRebuild(const sf::IntRect& view_cells, unsigned long long int new_source_id, int new_cell_size,
+                                   const sf::Color& new_cell_color, const sf::Color& new_line_color){
+    int margin_x = view_cells.width * RENDER_CACHE_MARGIN, margin_y = view_cells.height * RENDER_CACHE_MARGIN;
+    region = sf::IntRect(view_cells.left - margin_x, view_cells.top - margin_y, view_cells.width + 2 * margin_x, view_cells.height + 2 * margin_y);
+    source_id = new_source_id;
+    cell_size = new_cell_size;
+    cell_color = new_cell_color;
+    line_color = new_line_color;
+
+    cell_vertices.clear();
+    cell_slots.clear();
+    free_slots.clear();
+
+    line_vertices.clear();
+    int right = region.left + region.width, bottom = region.top + region.height;
+    for (int y = region.top; y <= bottom; y++){ // Horizontal lines
+        line_vertices.emplace_back(sf::Vector2f((float)region.left * cell_size, (float)y * cell_size), line_color);
+        line_vertices.emplace_back(sf::Vector2f((float)right * cell_size, (float)y * cell_size), line_color);
+    }
+    for (int x = region.left; x <= right; x++){ // Vertical lines
+        line_vertices.emplace_back(sf::Vector2f((float)x * cell_size, (float)region.top * cell_size), line_color);
+        line_vertices.emplace_back(sf::Vector2f((float)x * cell_size, (float)bottom * cell_size), line_color);
+    }
+    if (use_buffers) use_buffers = lines_buffer.create(line_vertices.size()) && lines_buffer.update(line_vertices.data());
+}
+
+void GridRenderCache::finishRebuild(){
+    is_valid = true;
+    dirty_begin = 0;
+    dirty_end = cell_vertices.size() / 4;
+}
+
+void GridRenderCache::patch(unsigned long long int id, const std::vector<Cell>& births, const std::vector<Cell>& deaths){
+    PROFILE_SCOPE("GridRenderCache::patch");
+    for (const auto& cell : deaths) setCell(cell, false);
+    for (const auto& cell : births) setCell(cell, true);
+    source_id = id;
+}
+
+/* The buffer is only ever made bigger by doubling, so the slots that are added over many generations cost an upload of the whole buffer only now and then.
+Otherwise only the range of slots that changed is uploaded. */
+void GridRenderCache::upload(){
+    if (!use_buffers || dirty_begin == dirty_end) return;
+
+    if (cells_buffer_capacity < cell_vertices.size()){
+        cells_buffer_capacity = std::max(cell_vertices.size(), 2 * cells_buffer_capacity);
+        if (!cells_buffer.create(cells_buffer_capacity)){
+            use_buffers = false;
+            return;
+        }
+        cells_buffer.update(cell_vertices.data(), cell_vertices.size(), 0);
+    }
+    else cells_buffer.update(cell_vertices.data() + 4 * dirty_begin, 4 * (dirty_end - dirty_begin), 4 * dirty_begin);
+
+    dirty_begin = dirty_end = 0;
+}
+
+void GridRenderCache::draw(sf::RenderTarget& target, bool with_lines){
+    upload();
+
+    if (use_buffers){
+        if (!cell_vertices.empty()) target.draw(cells_buffer, 0, cell_vertices.size());
+        if (with_lines) target.draw(lines_buffer, 0, line_vertices.size());
+    }
+    else{
+        target.draw(cell_vertices.data(), cell_vertices.size(), sf::PrimitiveType::Quads);
+        if (with_lines) target.draw(line_vertices.data(), line_vertices.size(), sf::PrimitiveType::Lines);
+    }
+}
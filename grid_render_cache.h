@@ -0,0 +1,76 @@
+#ifndef GAME_OF_LIFE_GRID_RENDER_CACHE_H
+#define GAME_OF_LIFE_GRID_RENDER_CACHE_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "cell.h"
+#include "flat_cell_table.h"
+#include "profiler.h"
+
+#define RENDER_CACHE_MARGIN 0.5 // The cached region reaches this fraction of the view's size beyond each side of the view, so a small move doesn't rebuild it
+#define RENDER_CACHE_MAX_SHRINK 3 // Once the view is this many times narrower (or shorter) than the region (after zooming in), the region is rebuilt around it
+#define RENDER_CACHE_MIN_COMPACTION 1024 // Free slots are compacted (by a rebuild) once there are at least this many, and more than live cells
+
+/* The quads of the live cells around the view, and the grid lines, kept in vertex buffers on the GPU from frame to frame.
+They're built once for a region a bit bigger than the view (from the live cells inside it, which the caller finds with its spatial index),
+and from then on they're only patched: a cell that is born takes a free slot (4 vertices), and a cell that dies gives its slot back,
+by collapsing its quad to a point. Only the range of slots that changed is uploaded. So a frame in which nothing changed costs 2 draw calls,
+and one that follows a generation costs as much as the generation changed - however big the screen is.
+
+The cache remembers which snapshot (or engine) it shows, so a caller knows whether it's up to date, whether a diff brings it up to date,
+or whether it has to be rebuilt. If the GPU has no vertex buffers, the same vertices are drawn from memory. */
+class GridRenderCache{
+private:
+    sf::VertexBuffer cells_buffer, lines_buffer;
+    bool use_buffers;
+    std::vector<sf::Vertex> cell_vertices; // 4 per slot
+    std::vector<sf::Vertex> line_vertices;
+    CellMap<unsigned int> cell_slots; // The live cells of the region, and the slot each one is drawn in
+    std::vector<unsigned int> free_slots;
+    size_t dirty_begin, dirty_end; // The slots that changed since the last upload
+    size_t cells_buffer_capacity; // In vertices
+
+    bool is_valid;
+    sf::IntRect region; // In cells
+    unsigned long long int source_id; // Of the snapshot the cache shows, or 0 for the engine itself
+    int cell_size;
+    sf::Color cell_color, line_color;
+
+    void setQuad(unsigned int slot, const Cell& cell, const sf::Color& color);
+    void markDirty(unsigned int slot);
+    void startRebuild(const sf::IntRect& view_cells, unsigned long long int new_source_id, int new_cell_size,
+                      const sf::Color& new_cell_color, const sf::Color& new_line_color);
+    void finishRebuild();
+    void upload();
+
+public:
+    GridRenderCache();
+
+    // Makes the next draw rebuild the cache (for when the cells it shows have changed some other way).
+    void invalidate();
+    // Whether the cache shows 'id' (0 for the engine) around 'view_cells', in these colors. If so, it can be drawn (or patched by the diff that follows 'id').
+    bool shows(unsigned long long int id, const sf::IntRect& view_cells, int new_cell_size, const sf::Color& new_cell_color, const sf::Color& new_line_color) const;
+
+    /* Rebuilds the cache around 'view_cells' for the cells of 'id'.
+    'for_each_live_in' calls a function for every live cell inside a rectangle (like 'Engine::forEachCellInRect()'), and we ask it for the region's. */
+    template <class ForEachLiveIn>
+    void rebuild(unsigned long long int id, const sf::IntRect& view_cells, const ForEachLiveIn& for_each_live_in,
+                 int new_cell_size, const sf::Color& new_cell_color, const sf::Color& new_line_color){
+        PROFILE_SCOPE("GridRenderCache::rebuild");
+        startRebuild(view_cells, id, new_cell_size, new_cell_color, new_line_color);
+
+        BoundingBox rect = {region.left, region.top, region.left + region.width - 1, region.top + region.height - 1};
+        for_each_live_in(rect, [this](const Cell& cell){ setCell(cell, true); });
+
+        finishRebuild();
+    }
+    // Brings the cache from the cells it shows to the cells of 'id', which differ from them by 'births' and 'deaths'.
+    void patch(unsigned long long int id, const std::vector<Cell>& births, const std::vector<Cell>& deaths);
+    // Adds or removes a single cell (when the engine the cache shows is edited). Cells outside the region are ignored.
+    void setCell(const Cell& cell, bool live);
+
+    // Uploads what changed, and draws the cells and then (unless the cells are too small for them to be of any use) the lines.
+    void draw(sf::RenderTarget& target, bool with_lines);
+};
+
+#endif
@@ -5,35 +5,43 @@ sf::Color GridScreen::live_cell_color(255, 0, 0); // Red
 sf::Color GridScreen::dead_cell_color(127, 127, 127); // Grey
 sf::Color GridScreen::outline_color(200, 200, 200); // Beige
 float GridScreen::zoom = 1;
+GridRenderCache GridScreen::render_cache;
+GridDensityCache GridScreen::density_cache;
 
 float GridScreen::distance(const sf::Vector2i& vec1, const sf::Vector2i& vec2){
     return sqrt(pow(vec2.x - vec1.x, 2) + pow(vec2.y - vec1.y, 2));
 }
 
-void GridScreen::checkForChangeViewWithKeys(const long long int& delta_time) const{
-    float delta_pos = SPEED * delta_time; // It's in absolute value, we'll add the sign later
+// Returns whether the view has moved (so it has to be drawn again).
+bool GridScreen::checkForChangeViewWithKeys(const long long int& delta_time) const{
+    // It's in absolute value, we'll add the sign later. Zoomed out, we move faster, so a view goes by in the same time.
+    float delta_pos = SPEED * delta_time * std::max(1.f, zoom);
+    sf::FloatRect bounds = viewBounds();
+    sf::Vector2f old_left_top_view_pos = left_top_view_pos;
 
     // We're not allowing the user to move the view beyond the grid's bounds.
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W) && 0 <= left_top_view_pos.y - delta_pos){
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W) && bounds.top <= left_top_view_pos.y - delta_pos){
         left_top_view_pos.y -= delta_pos;
         view.move(sf::Vector2f(0, -1 * delta_pos));
         window.setView(view);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A) && 0 <= left_top_view_pos.x - delta_pos){
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A) && bounds.left <= left_top_view_pos.x - delta_pos){
         left_top_view_pos.x -= delta_pos;
         view.move(sf::Vector2f(-1 * delta_pos, 0));
         window.setView(view);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S) && left_top_view_pos.y + view.getSize().y + delta_pos <= grid_height){
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S) && left_top_view_pos.y + view.getSize().y + delta_pos <= bounds.top + bounds.height){
         left_top_view_pos.y += delta_pos;
         view.move(sf::Vector2f(0, delta_pos));
         window.setView(view);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D) && left_top_view_pos.x + view.getSize().x + delta_pos <= grid_width){
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D) && left_top_view_pos.x + view.getSize().x + delta_pos <= bounds.left + bounds.width){
         left_top_view_pos.x += delta_pos;
         view.move(sf::Vector2f(delta_pos, 0));
         window.setView(view);
     }
+
+    return left_top_view_pos != old_left_top_view_pos;
 }
 
 // 'resize()' and 'handleZoom()' look similar, but we can't merge them, since then latter alters the 'left_top_view_pos',
@@ -52,8 +60,9 @@ void GridScreen::resize(const sf::Event& evnt) const{
     view.zoom(zoom);
 
     // We perform bound checking below, as to not show beyond the grid's bounds, when resizing close to the edge.
-    left_top_view_pos.x = std::min(left_top_view_pos.x, grid_width - view.getSize().x);
-    left_top_view_pos.y = std::min(left_top_view_pos.y, grid_height - view.getSize().y);
+    sf::FloatRect bounds = viewBounds();
+    left_top_view_pos.x = std::min(left_top_view_pos.x, bounds.left + bounds.width - view.getSize().x);
+    left_top_view_pos.y = std::min(left_top_view_pos.y, bounds.top + bounds.height - view.getSize().y);
 
     view.reset(sf::FloatRect(left_top_view_pos.x, left_top_view_pos.y, view.getSize().x, view.getSize().y));
     window.setView(view);
@@ -63,11 +72,12 @@ void GridScreen::resize(const sf::Event& evnt) const{
 // 'zoom()' and 'setSize()' *do not* change the center position, so only the bounds themselves change.
 void GridScreen::handleZoom(float delta) const{
     // 'zoom()' is by a factor. a number greater than 1 means zoom-out; a number smaller than 1 means zoom-in.
+    // Every notch multiplies (or divides) it by the same factor, so going from a glider to a pattern of millions of cells takes a few dozen notches, not thousands.
     if (0 < delta) { // Scroll up - zoom-in
-        zoom = std::max(0.5, zoom - 0.1); // By using 'max' with '0.5', we set it as an upper limit.
+        zoom = std::max<float>(MIN_ZOOM, zoom / ZOOM_FACTOR); // By using 'max' with 'MIN_ZOOM', we set it as an upper limit.
     }
     else if (delta < 0) { // Scroll down - zoom-out
-        zoom = std::min(2.0, zoom + 0.1); // By using 'min' with '2', we set it as a lower limit.
+        zoom = std::min<float>(MAX_ZOOM, zoom * ZOOM_FACTOR); // By using 'min' with 'MAX_ZOOM', we set it as a lower limit.
     }
 
     // We use 'setSize()' here to reset our view (by setting it to the default view's size).
@@ -81,10 +91,11 @@ void GridScreen::handleZoom(float delta) const{
     left_top_view_pos.y = view.getCenter().y - view.getSize().y / 2;
 
     // We perform bound checking below, as to not show beyond the grid's bounds, when zooming close to the edge.
-    if (left_top_view_pos.x < 0) left_top_view_pos.x = 0;
-    if (left_top_view_pos.y < 0) left_top_view_pos.y = 0;
-    left_top_view_pos.x = std::min(left_top_view_pos.x, grid_width - view.getSize().x);
-    left_top_view_pos.y = std::min(left_top_view_pos.y, grid_height - view.getSize().y);
+    sf::FloatRect bounds = viewBounds();
+    if (left_top_view_pos.x < bounds.left) left_top_view_pos.x = bounds.left;
+    if (left_top_view_pos.y < bounds.top) left_top_view_pos.y = bounds.top;
+    left_top_view_pos.x = std::min(left_top_view_pos.x, bounds.left + bounds.width - view.getSize().x);
+    left_top_view_pos.y = std::min(left_top_view_pos.y, bounds.top + bounds.height - view.getSize().y);
 
     view.reset(sf::FloatRect(left_top_view_pos.x, left_top_view_pos.y, view.getSize().x, view.getSize().y));
     window.setView(view);
@@ -99,10 +110,11 @@ void GridScreen::handleDrag(sf::Vector2i& old_pos, const sf::Vector2i& new_pos)
     sf::Vector2f delta_pos = old_view_pos - new_view_pos;
 
     // We don't want to allow the user to drag beyond the grid, so we bound-check
-    if (0 <= left_top_view_pos.x + delta_pos.x && left_top_view_pos.x + view.getSize().x + delta_pos.x <= grid_width){
+    sf::FloatRect bounds = viewBounds();
+    if (bounds.left <= left_top_view_pos.x + delta_pos.x && left_top_view_pos.x + view.getSize().x + delta_pos.x <= bounds.left + bounds.width){
         left_top_view_pos.x += delta_pos.x;
     }
-    if (0 <= left_top_view_pos.y + delta_pos.y && left_top_view_pos.y + view.getSize().y + delta_pos.y <= grid_height){
+    if (bounds.top <= left_top_view_pos.y + delta_pos.y && left_top_view_pos.y + view.getSize().y + delta_pos.y <= bounds.top + bounds.height){
         left_top_view_pos.y += delta_pos.y;
     }
     view.reset(sf::FloatRect(left_top_view_pos.x, left_top_view_pos.y, view.getSize().x, view.getSize().y));
@@ -111,47 +123,130 @@ void GridScreen::handleDrag(sf::Vector2i& old_pos, const sf::Vector2i& new_pos)
     old_pos = new_pos;
 }
 
-/* Draws the grid. We ONLY draw the visible view, not the entire grid;
-so the grid can be as big as we want (It's O(visible_cells), and not O(cells))
-
-We use vertexArray (instead of drawing rectangle shapes) for 2 reasons:
- 1) It rids us of the flickering lines' problem we've faced with the 'zoom()' function.
-Don't know how exactly, but don't care either
-2) TL;DR: it's faster (about 50% faster, but 'drawGrid()' is already very cheap so...)
-The GPU can handle a lot of geometric shapes in each 'draw()' call, so calling it multiple times with a *single* shape is wasteful.
-It's much better to store all of our shapes in a VertexArray (preprocessing), and then call 'draw()' once on the array.
-Also, we store only the live cells, and we don't need to draw dead cells.
-This is because we draw the background in dead_cell_color, so if we didn't draw anything there - it looks like a dead cell. */
-void GridScreen::drawGrid(){
-    sf::VertexArray live_quads_vertex_arr(sf::PrimitiveType::Quads); // Stores *only* the live cells
-    sf::VertexArray lines_vertex_arr(sf::PrimitiveType::Lines);
+// Moves the view to the given top-left corner and zoom (like the ones a checkpoint was saved with), within the same bounds as zooming and dragging.
+void GridScreen::setViewport(float left, float top, float new_zoom) const{
+    zoom = std::min<float>(MAX_ZOOM, std::max<float>(MIN_ZOOM, new_zoom));
+    view.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
+    view.zoom(zoom);
+
+    sf::FloatRect bounds = viewBounds();
+    left_top_view_pos.x = std::max(bounds.left, std::min(left, bounds.left + bounds.width - view.getSize().x));
+    left_top_view_pos.y = std::max(bounds.top, std::min(top, bounds.top + bounds.height - view.getSize().y));
+
+    view.reset(sf::FloatRect(left_top_view_pos.x, left_top_view_pos.y, view.getSize().x, view.getSize().y));
+    window.setView(view);
+}
+
+/* Where the view may go: the grid - or once zoomed out further than that, the grid scaled by the zoom around its center.
+So there's as much room to move around (in views) however far we zoom out, and a pattern much bigger than the grid can still be seen whole. */
+sf::FloatRect GridScreen::viewBounds() const{
+    float scale = std::max(1.f, zoom);
+    float width = grid_width * scale, height = grid_height * scale;
 
-    // We divide by 'CELL_SIZE' to transform view coordinates to grid ones. We add/subtract 1 to be on the safe side.
-    // It's important to use grid coordinates instead of view ones,
-    // so that the grid in the real 2d world always stays in the same place (only the view moves).
+    return sf::FloatRect(grid_width / 2.f - width / 2, grid_height / 2.f - height / 2, width, height);
+}
+
+/* The level of the squares (see 'Engine::forEachBlock()') the grid is drawn in, or -1 while the cells are big enough to be drawn one by one.
+A view has about as many squares as the screen has pixels, however far we zoom out. */
+int GridScreen::blockLevel(){
+    float cell_pixels = CELL_SIZE / zoom;
+    if (DENSITY_MAX_CELL_PIXELS <= cell_pixels) return -1;
+
+    int level = 0;
+    while ((1 << level) * cell_pixels < DENSITY_MIN_BLOCK_PIXELS) level++;
+    return level;
+}
+
+// The cells the view shows, with a cell to spare on every side.
+// It's important to use grid coordinates instead of view ones, so that the grid in the real 2d world always stays in the same place (only the view moves).
+sf::IntRect GridScreen::viewCells(){
     int top = left_top_view_pos.y / CELL_SIZE - 1, down = (left_top_view_pos.y + view.getSize().y) / CELL_SIZE + 1;
     int left = left_top_view_pos.x / CELL_SIZE - 1, right = (left_top_view_pos.x + view.getSize().x) / CELL_SIZE + 1;
 
-    for (int i = top; i < down ; i++){
-        // Creating the horizontal lines
-        lines_vertex_arr.append(sf::Vertex(sf::Vector2f(left * CELL_SIZE, i * CELL_SIZE), outline_color));
-        lines_vertex_arr.append(sf::Vertex(sf::Vector2f(right * CELL_SIZE, i * CELL_SIZE), outline_color));
-
-        for (int j = left; j < right; j++){
-            if (i == top){ // Creating the vertical lines (only on upper loop's first iteration)
-                lines_vertex_arr.append(sf::Vertex(sf::Vector2f(j * CELL_SIZE, top * CELL_SIZE), outline_color));
-                lines_vertex_arr.append(sf::Vertex(sf::Vector2f(j * CELL_SIZE, down * CELL_SIZE), outline_color));
-            }
-
-            if (grid.count({j,i})){ // If a cell is live - we include it and draw it
-                live_quads_vertex_arr.append(sf::Vertex(sf::Vector2f(j * CELL_SIZE, i * CELL_SIZE), live_cell_color));
-                live_quads_vertex_arr.append(sf::Vertex(sf::Vector2f((j + 1) * CELL_SIZE, i * CELL_SIZE), live_cell_color));
-                live_quads_vertex_arr.append(sf::Vertex(sf::Vector2f((j + 1) * CELL_SIZE, (i + 1) * CELL_SIZE), live_cell_color));
-                live_quads_vertex_arr.append(sf::Vertex(sf::Vector2f(j * CELL_SIZE, (i + 1) * CELL_SIZE), live_cell_color));
-            }
+    return sf::IntRect(left, top, right - left, down - top);
+}
+
+/* Draws the grid. We ONLY draw around the visible view, not the entire grid;
+so the grid can be as big as we want.
+
+We use vertices (instead of drawing rectangle shapes), since the GPU can handle a lot of geometric shapes in each 'draw()' call,
+so calling it multiple times with a *single* shape is wasteful. We store only the live cells, and we don't need to draw dead cells.
+This is because we draw the background in dead_cell_color, so if we didn't draw anything there - it looks like a dead cell.
+
+The vertices stay on the GPU between frames (see 'GridRenderCache'), so we don't build them anew every frame:
+the screens that edit the engine patch them cell by cell, and 'GameScreen' patches them by the births and deaths of every snapshot it draws.
+We go over the whole view only when it moves out of the region we've built, or when a snapshot doesn't follow the one we drew (or has no diff).
+
+Zoomed out, a quad per cell would be millions of quads for a few pixels, so we draw a texture of squares of cells instead (see 'GridDensityCache'),
+and the grid lines are hidden a bit before that, since they'd cover the cells. */
+void GridScreen::drawGrid(){
+    PROFILE_SCOPE("GridScreen::drawGrid");
+    sf::IntRect view_cells = viewCells();
+    int level = blockLevel();
+    if (level != -1){
+        if (!density_cache.shows(0, view_cells, level, CELL_SIZE, live_cell_color)){
+            density_cache.rebuild(0, view_cells, level, level, [level](const std::function<void(const Cell&, unsigned long long int)>& func){
+                grid->forEachBlock(level, func);
+            }, CELL_SIZE, live_cell_color);
+        }
+        density_cache.draw(window);
+        return;
+    }
+
+    if (!render_cache.shows(0, view_cells, CELL_SIZE, live_cell_color, outline_color)){
+        render_cache.rebuild(0, view_cells, [](const BoundingBox& rect, const std::function<void(const Cell&)>& func){ grid->forEachCellInRect(rect, func); },
+                             CELL_SIZE, live_cell_color, outline_color);
+    }
+
+    render_cache.draw(window, GRID_LINES_MIN_CELL_PIXELS <= CELL_SIZE / zoom);
+}
+
+/* The snapshot has only the cells in its rectangle, which the simulation found with the engine's spatial index (see 'Simulation::setViewRect()'),
+and that rectangle is at most twice as wide and as tall as the region the render cache asks for (see 'GameScreen::updateSimulationView()').
+So going over all of the snapshot's cells costs about as much as the cells in the rectangle, and we only filter out the ones around it.
+(Looking up every cell of the rectangle instead would cost by its area, whether the cells are there or not.) */
+template <class Func>
+static void forEachSnapshotCellInRect(const GridSnapshot& snapshot, const BoundingBox& rect, const Func& func){
+    const BoundingBox& snapshot_rect = snapshot.rect;
+    if (rect.left <= snapshot_rect.left && snapshot_rect.right <= rect.right && rect.top <= snapshot_rect.top && snapshot_rect.bottom <= rect.bottom){
+        snapshot.cells.forEach(func);
+        return;
+    }
+
+    snapshot.cells.forEach([&rect, &func](const Cell& cell){
+        if (rect.left <= cell.x && cell.x <= rect.right && rect.top <= cell.y && cell.y <= rect.bottom) func(cell);
+    });
+}
+
+/* The snapshot might be in squares of another level than the view's (or in cells, when the view wants squares) for a frame or two after a zoom,
+until the simulation publishes the new detail. Smaller squares are added up into ours, and bigger ones are drawn as they are. */
+void GridScreen::drawGrid(const GridSnapshot& snapshot){
+    PROFILE_SCOPE("GridScreen::drawGrid");
+    sf::IntRect view_cells = viewCells();
+    int level = std::max(blockLevel(), snapshot.block_level == 0 ? -1 : snapshot.block_level);
+    if (level != -1){
+        if (density_cache.shows(snapshot.id, view_cells, level, CELL_SIZE, live_cell_color)) { }
+        else if (snapshot.block_level == 0){
+            density_cache.rebuild(snapshot.id, view_cells, level, 0, [&snapshot](const auto& func){
+                snapshot.cells.forEach([&func](const Cell& cell){ func(cell, 1); });
+            }, CELL_SIZE, live_cell_color);
+        }
+        else{
+            density_cache.rebuild(snapshot.id, view_cells, level, snapshot.block_level, [&snapshot](const auto& func){ snapshot.blocks.forEach(func); },
+                                  CELL_SIZE, live_cell_color);
         }
+        density_cache.draw(window);
+        return;
     }
 
-    window.draw(live_quads_vertex_arr);
-    window.draw(lines_vertex_arr);
-}
\ No newline at end of file
+    if (render_cache.shows(snapshot.id, view_cells, CELL_SIZE, live_cell_color, outline_color)) { }
+    else if (snapshot.has_diff && render_cache.shows(snapshot.previous_id, view_cells, CELL_SIZE, live_cell_color, outline_color)){
+        render_cache.patch(snapshot.id, snapshot.births, snapshot.deaths);
+    }
+    else{
+        render_cache.rebuild(snapshot.id, view_cells, [&snapshot](const BoundingBox& rect, const auto& func){ forEachSnapshotCellInRect(snapshot, rect, func); },
+                             CELL_SIZE, live_cell_color, outline_color);
+    }
+
+    render_cache.draw(window, GRID_LINES_MIN_CELL_PIXELS <= CELL_SIZE / zoom);
+}
@@ -2,8 +2,17 @@
 #define GAME_OF_LIFE_GRID_SCREEN_H
 
 #include "screens.h"
+#include "grid_density_cache.h"
+#include "grid_render_cache.h"
+#include "simulation.h"
 
 #define SPEED 0.0006
+#define MIN_ZOOM 0.5 // Zoomed in the most: a cell is twice its size
+#define MAX_ZOOM 65536 // Zoomed out the most: a pixel is about 2000x2000 cells
+#define ZOOM_FACTOR 1.25 // Per notch of the mouse wheel
+#define GRID_LINES_MIN_CELL_PIXELS 8 // The grid lines are hidden once a cell is smaller than this on the screen
+#define DENSITY_MAX_CELL_PIXELS 4 // Once a cell is smaller than this on the screen, the grid is drawn as a texture of squares (see 'GridDensityCache')
+#define DENSITY_MIN_BLOCK_PIXELS 2 // The squares of that texture are the smallest ones that are at least this big on the screen
 
 class GridScreen: public BaseScreen{
 protected:
@@ -11,13 +20,23 @@ protected:
     static sf::Color dead_cell_color;
     static sf::Color outline_color;
     static float zoom;
+    // What the grid looked like the last time it was drawn (zoomed in and zoomed out). The screens that edit the engine patch them (or invalidate them) as they do.
+    static GridRenderCache render_cache;
+    static GridDensityCache density_cache;
 
     static float distance(const sf::Vector2i& vec1, const sf::Vector2i& vec2);
-    void checkForChangeViewWithKeys(const long long int& delta_time) const;
+    bool checkForChangeViewWithKeys(const long long int& delta_time) const;
     void resize(const sf::Event& evnt) const;
     void handleZoom(float delta) const;
     void handleDrag(sf::Vector2i& old_pos, const sf::Vector2i& new_pos) const;
+    void setViewport(float left, float top, float new_zoom) const;
+    static int blockLevel();
     static void drawGrid();
+    static void drawGrid(const GridSnapshot& snapshot);
+    static sf::IntRect viewCells();
+
+private:
+    sf::FloatRect viewBounds() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,689 @@
+#include <algorithm>
+#include <climits>
+#include "hashlife_engine.h"
+#include "profiler.h"
+
+#define NO_RESULT 0xFF
+#define DEAD_LEAF 0
+#define LIVE_LEAF 1
+
+HashLifeEngine::HashLifeEngine(): is_at_coordinate_limit(false) {
+    reset();
+}
+
+// Rebuilds the tables from scratch, with only the 2 leaves and an empty root.
+void HashLifeEngine::reset(){
+    nodes.clear();
+    node_table.clear();
+    empty_nodes.clear();
+    node_signatures.clear();
+
+    // The leaves are never looked up in 'node_table', since they have no children
+    nodes.push_back({0, 0, 0, 0, 0, 0, NO_RESULT, 0});
+    nodes.push_back({0, 0, 0, 0, 0, 0, NO_RESULT, 1});
+    empty_nodes.push_back(DEAD_LEAF);
+
+    root = emptyNode(3);
+}
+
+void HashLifeEngine::setRule(const Rule& new_rule){
+    Engine::setRule(new_rule);
+
+    // Every memoized result was computed under the previous rule
+    for (auto& node : nodes) node.result_exponent = NO_RESULT;
+}
+
+// Returns the canonical node with the given children, creating it only if it doesn't exist yet.
+// Note that a node is always created after its children, so children always have smaller indices than their parents.
+uint32_t HashLifeEngine::makeNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se){
+    HashLifeNodeKey key = {nw, ne, sw, se};
+    auto iter = node_table.find(key);
+    if (iter != node_table.end()) return iter->second;
+
+    uint64_t population = nodes[nw].population + nodes[ne].population + nodes[sw].population + nodes[se].population;
+    nodes.push_back({nw, ne, sw, se, 0, (uint8_t)(nodes[nw].level + 1), NO_RESULT, population});
+    node_table.emplace(key, nodes.size() - 1);
+
+    return nodes.size() - 1;
+}
+
+uint32_t HashLifeEngine::emptyNode(int level){
+    while ((int)empty_nodes.size() <= level){
+        uint32_t empty = empty_nodes.back();
+        empty_nodes.push_back(makeNode(empty, empty, empty, empty));
+    }
+
+    return empty_nodes[level];
+}
+
+// Returns a node one level up, with 'node' at its center (so the coordinates of the cells don't change).
+uint32_t HashLifeEngine::expand(uint32_t node){
+    HashLifeNode n = nodes[node]; // A copy, since 'makeNode()' might reallocate 'nodes'
+    uint32_t empty = emptyNode(n.level - 1);
+
+    return makeNode(makeNode(empty, empty, empty, n.nw), makeNode(empty, empty, n.ne, empty),
+                    makeNode(empty, n.sw, empty, empty), makeNode(n.se, empty, empty, empty));
+}
+
+// True if all the live cells of 'node' are inside its center quarter (which is also the square its result covers).
+bool HashLifeEngine::isPaddedForJump(uint32_t node) const{
+    const HashLifeNode& n = nodes[node];
+    if (n.level < 3) return false;
+
+    const HashLifeNode& nw = nodes[n.nw], & ne = nodes[n.ne], & sw = nodes[n.sw], & se = nodes[n.se];
+    return nodes[nw.nw].population + nodes[nw.ne].population + nodes[nw.sw].population +
+           nodes[ne.nw].population + nodes[ne.ne].population + nodes[ne.se].population +
+           nodes[sw.nw].population + nodes[sw.sw].population + nodes[sw.se].population +
+           nodes[se.ne].population + nodes[se.sw].population + nodes[se.se].population == 0;
+}
+
+// The node of level 'k-1' at the center of 'node'
+uint32_t HashLifeEngine::centeredSubnode(uint32_t node){
+    HashLifeNode n = nodes[node];
+    return makeNode(nodes[n.nw].se, nodes[n.ne].sw, nodes[n.sw].ne, nodes[n.se].nw);
+}
+
+// The node of level 'k' exactly between 2 horizontally adjacent nodes of level 'k'
+uint32_t HashLifeEngine::centeredHorizontal(uint32_t west, uint32_t east){
+    HashLifeNode w = nodes[west], e = nodes[east];
+    return makeNode(w.ne, e.nw, w.se, e.sw);
+}
+
+// The node of level 'k' exactly between 2 vertically adjacent nodes of level 'k'
+uint32_t HashLifeEngine::centeredVertical(uint32_t north, uint32_t south){
+    HashLifeNode n = nodes[north], s = nodes[south];
+    return makeNode(n.sw, n.se, s.nw, s.ne);
+}
+
+// Base case of the recursion: a 4x4 node (level 2), whose center 2x2 we advance by a single generation with the rule's block table.
+uint32_t HashLifeEngine::baseResult(uint32_t node){
+    const HashLifeNode& n = nodes[node];
+    const uint32_t children[4] = {n.nw, n.ne, n.sw, n.se};
+    uint16_t block = 0;
+    for (int i = 0; i < 4; i++){
+        const HashLifeNode& child = nodes[children[i]];
+        int shift = (i / 2) * 8 + (i % 2) * 2; // Bit of the child's top-left cell
+        block |= (child.nw == LIVE_LEAF) << shift | (child.ne == LIVE_LEAF) << (shift + 1) |
+                 (child.sw == LIVE_LEAF) << (shift + 4) | (child.se == LIVE_LEAF) << (shift + 5);
+    }
+
+    uint8_t next = rule.blockResult(block);
+    return makeNode(next & 1 ? LIVE_LEAF : DEAD_LEAF, next >> 1 & 1 ? LIVE_LEAF : DEAD_LEAF,
+                    next >> 2 & 1 ? LIVE_LEAF : DEAD_LEAF, next >> 3 & 1 ? LIVE_LEAF : DEAD_LEAF);
+}
+
+/* Returns the center of 'node' (a node of level 'k-1'), advanced by 2^min(exponent, k-2) generations.
+We split 'node' into 9 overlapping sub-squares of level 'k-1', and take each of their centers at some point in the future.
+Those 9 nodes of level 'k-2' are combined into 4 overlapping nodes of level 'k-1', and we take *their* centers at a later point.
+Combining these 4 gives us the center of 'node'.
+-If we go full speed (exponent >= k-2), both phases advance 2^(k-3) generations, which is 2^(k-2) in total.
+-Otherwise, the first phase doesn't advance at all (we simply take the centers), and the second one advances the whole 2^exponent.
+The result is memoized in the node, so the next time we meet this node (anywhere, in any generation), it's free. */
+uint32_t HashLifeEngine::result(uint32_t node, int exponent){
+    HashLifeNode n = nodes[node];
+    int effective_exponent = std::min(exponent, n.level - 2);
+    if (n.result_exponent == effective_exponent) return n.result;
+
+    uint32_t next;
+    if (n.population == 0){ // Without B0, nothing is ever born in an empty square
+        next = emptyNode(n.level - 1);
+    }
+    else if (n.level == 2){
+        next = baseResult(node);
+    }
+    else{
+        uint32_t sub[3][3] = {{n.nw, centeredHorizontal(n.nw, n.ne), n.ne},
+                              {centeredVertical(n.nw, n.sw), centeredSubnode(node), centeredVertical(n.ne, n.se)},
+                              {n.sw, centeredHorizontal(n.sw, n.se), n.se}};
+
+        bool full_speed = effective_exponent == n.level - 2;
+        for (auto& row : sub){
+            for (auto& sub_node : row) sub_node = full_speed ? result(sub_node, exponent) : centeredSubnode(sub_node);
+        }
+
+        next = makeNode(result(makeNode(sub[0][0], sub[0][1], sub[1][0], sub[1][1]), exponent),
+                        result(makeNode(sub[0][1], sub[0][2], sub[1][1], sub[1][2]), exponent),
+                        result(makeNode(sub[1][0], sub[1][1], sub[2][0], sub[2][1]), exponent),
+                        result(makeNode(sub[1][1], sub[1][2], sub[2][1], sub[2][2]), exponent));
+    }
+
+    nodes[node].result = next;
+    nodes[node].result_exponent = effective_exponent;
+    return next;
+}
+
+/* Advances the universe by exactly 2^exponent generations.
+Cells spread at most one cell per generation, so all the future cells are inside the result of the root,
+only if there's a margin of 2^exponent cells between the live cells and the edge of the result.
+Expanding once more after the live cells are in the center quarter leaves a margin of 2^(level-3), which is enough.
+Returns false, and leaves the universe as it was, if the root would have to grow beyond 'HASHLIFE_MAX_LEVEL',
+or if a live cell of the result is beyond the 'int' coordinates (nodes are immutable, so we simply keep the old root). */
+bool HashLifeEngine::jump(int exponent){
+    uint32_t grown = root;
+    while (nodes[grown].level < exponent + 2 || !isPaddedForJump(grown)){
+        if (HASHLIFE_MAX_LEVEL <= nodes[grown].level) return false;
+        grown = expand(grown);
+    }
+    if (HASHLIFE_MAX_LEVEL <= nodes[grown].level) return false;
+    grown = expand(grown);
+
+    uint32_t next = result(grown, exponent);
+    if (!hasCellCoordinates(next)) return false;
+
+    root = next;
+    generation += 1ULL << exponent;
+    return true;
+}
+
+// How many live cells of 'node' (whose top-left corner is at (left, top)) are inside 'rect'. Only the nodes that cross its edges are split.
+unsigned long long int HashLifeEngine::populationInRect(uint32_t node, long long int left, long long int top, const BoundingBox& rect) const{
+    const HashLifeNode& n = nodes[node];
+    if (n.population == 0) return 0;
+
+    long long int last = (1LL << n.level) - 1; // The offset of the node's last row and column
+    if (left + last < rect.left || rect.right < left || top + last < rect.top || rect.bottom < top) return 0;
+    if (rect.left <= left && left + last <= rect.right && rect.top <= top && top + last <= rect.bottom) return n.population;
+
+    long long int half = 1LL << (n.level - 1);
+    return populationInRect(n.nw, left, top, rect) + populationInRect(n.ne, left + half, top, rect) +
+           populationInRect(n.sw, left, top + half, rect) + populationInRect(n.se, left + half, top + half, rect);
+}
+
+// Whether every live cell of 'node', as a root (centered at (0,0)), has 'int' coordinates - which are its center node of level 32.
+// Its edges are on multiples of 2^31, so only a few nodes on every level above that cross them.
+bool HashLifeEngine::hasCellCoordinates(uint32_t node) const{
+    if (nodes[node].level <= 32) return true;
+
+    long long int half = 1LL << (nodes[node].level - 1);
+    return populationInRect(node, -half, -half, {INT_MIN, INT_MIN, INT_MAX, INT_MAX}) == nodes[node].population;
+}
+
+void HashLifeEngine::step(){
+    advance(1);
+}
+
+/* Any amount of generations is a sum of powers of 2, so we do a jump for each bit.
+If a jump would carry a live cell beyond the 'int' coordinates, we stop before it, and get as close as we can with the smaller jumps -
+so the universe is left at the last generation that still fits (unless the pattern leaves and comes back), rather than with wrapped coordinates. */
+void HashLifeEngine::advance(unsigned long long int generations){
+    PROFILE_SCOPE("HashLifeEngine::advance");
+    is_at_coordinate_limit = false;
+    for (int exponent = 0; exponent < 64; exponent++){
+        if (!(generations >> exponent & 1)) continue;
+
+        if (HASHLIFE_MAX_NODES < nodes.size()) collectGarbage();
+        if (jump(exponent)) continue;
+
+        is_at_coordinate_limit = true;
+        for (int smaller = exponent - 1; 0 <= smaller; smaller--){
+            if (HASHLIFE_MAX_NODES < nodes.size()) collectGarbage();
+            jump(smaller);
+        }
+        return;
+    }
+}
+
+bool HashLifeEngine::isAtCoordinateLimit() const{
+    return is_at_coordinate_limit;
+}
+
+// 'x' and 'y' are relative to the top-left corner of 'node'. Returns the new node (nodes are immutable, so we copy the path to the cell).
+uint32_t HashLifeEngine::setCell(uint32_t node, long long int x, long long int y, bool live){
+    HashLifeNode n = nodes[node];
+    if (n.level == 0) return live ? LIVE_LEAF : DEAD_LEAF;
+
+    long long int half = 1LL << (n.level - 1);
+    if (y < half){
+        if (x < half) n.nw = setCell(n.nw, x, y, live);
+        else n.ne = setCell(n.ne, x - half, y, live);
+    }
+    else{
+        if (x < half) n.sw = setCell(n.sw, x, y - half, live);
+        else n.se = setCell(n.se, x - half, y - half, live);
+    }
+
+    return makeNode(n.nw, n.ne, n.sw, n.se);
+}
+
+bool HashLifeEngine::getCell(uint32_t node, long long int x, long long int y) const{
+    while (nodes[node].level != 0){
+        const HashLifeNode& n = nodes[node];
+        if (n.population == 0) return false;
+
+        long long int half = 1LL << (n.level - 1);
+        if (y < half) node = x < half ? n.nw : n.ne;
+        else node = x < half ? n.sw : n.se;
+        if (half <= x) x -= half;
+        if (half <= y) y -= half;
+    }
+
+    return node == LIVE_LEAF;
+}
+
+void HashLifeEngine::insert(const Cell& cell){
+    // Growing the root until it contains the cell
+    while (true){
+        long long int half = 1LL << (nodes[root].level - 1);
+        if (-half <= cell.x && cell.x < half && -half <= cell.y && cell.y < half) break;
+        root = expand(root);
+    }
+
+    long long int half = 1LL << (nodes[root].level - 1);
+    root = setCell(root, cell.x + half, cell.y + half, true);
+}
+
+/* Builds the quadtree of the given cells from the bottom up, so every node on the way is made once -
+instead of copying the path to every single cell, like 'setCell()' does.
+'left' and 'top' are the coordinates of the node's top-left corner. The cells are reordered on the way, quadrant by quadrant. */
+uint32_t HashLifeEngine::buildNode(Cell* begin, Cell* end, int level, long long int left, long long int top){
+    if (begin == end) return emptyNode(level);
+    if (level == 0) return LIVE_LEAF;
+
+    long long int half = 1LL << (level - 1);
+    Cell* south = std::partition(begin, end, [top, half](const Cell& cell){ return cell.y < top + half; });
+    Cell* north_east = std::partition(begin, south, [left, half](const Cell& cell){ return cell.x < left + half; });
+    Cell* south_east = std::partition(south, end, [left, half](const Cell& cell){ return cell.x < left + half; });
+
+    uint32_t nw = buildNode(begin, north_east, level - 1, left, top);
+    uint32_t ne = buildNode(north_east, south, level - 1, left + half, top);
+    uint32_t sw = buildNode(south, south_east, level - 1, left, top + half);
+    uint32_t se = buildNode(south_east, end, level - 1, left + half, top + half);
+    return makeNode(nw, ne, sw, se);
+}
+
+// Returns the node whose live cells are the live cells of both nodes (which are of the same level).
+// Shared subtrees are merged once, thanks to 'memo' (which maps the 2 nodes to their union).
+uint32_t HashLifeEngine::unionNodes(uint32_t node1, uint32_t node2, std::unordered_map<uint64_t, uint32_t>& memo){
+    if (node1 == node2 || nodes[node2].population == 0) return node1;
+    if (nodes[node1].population == 0) return node2;
+    if (nodes[node1].level == 0) return LIVE_LEAF;
+
+    uint64_t key = (uint64_t)node1 << 32 | node2;
+    auto iter = memo.find(key);
+    if (iter != memo.end()) return iter->second;
+
+    HashLifeNode n1 = nodes[node1], n2 = nodes[node2]; // Copies, since 'makeNode()' might reallocate 'nodes'
+    uint32_t result = makeNode(unionNodes(n1.nw, n2.nw, memo), unionNodes(n1.ne, n2.ne, memo),
+                               unionNodes(n1.sw, n2.sw, memo), unionNodes(n1.se, n2.se, memo));
+    memo.emplace(key, result);
+
+    return result;
+}
+
+// The cells are built into a quadtree of their own, the size of the root, which is then merged into the root.
+void HashLifeEngine::insertCells(const std::vector<Cell>& cells){
+    if (cells.empty()) return;
+
+    BoundingBox box = {cells[0].x, cells[0].y, cells[0].x, cells[0].y};
+    for (const auto& cell : cells){
+        box.left = std::min(box.left, cell.x);
+        box.top = std::min(box.top, cell.y);
+        box.right = std::max(box.right, cell.x);
+        box.bottom = std::max(box.bottom, cell.y);
+    }
+
+    // Growing the root until it contains all the cells
+    while (true){
+        long long int half = 1LL << (nodes[root].level - 1);
+        if (-half <= box.left && box.right < half && -half <= box.top && box.bottom < half) break;
+        root = expand(root);
+    }
+
+    std::vector<Cell> sorted_cells(cells);
+    long long int half = 1LL << (nodes[root].level - 1);
+    uint32_t added = buildNode(sorted_cells.data(), sorted_cells.data() + sorted_cells.size(), nodes[root].level, -half, -half);
+
+    std::unordered_map<uint64_t, uint32_t> memo;
+    root = unionNodes(root, added, memo);
+}
+
+// Like 'setCell()', but puts a whole node (of a smaller level than 'target') at (x, y), which must be a multiple of its size. Its cells are added to the target's.
+uint32_t HashLifeEngine::plantNode(uint32_t target, uint32_t node, long long int x, long long int y, std::unordered_map<uint64_t, uint32_t>& memo){
+    HashLifeNode n = nodes[target];
+    if (n.level == nodes[node].level) return unionNodes(target, node, memo);
+
+    long long int half = 1LL << (n.level - 1);
+    if (y < half){
+        if (x < half) n.nw = plantNode(n.nw, node, x, y, memo);
+        else n.ne = plantNode(n.ne, node, x - half, y, memo);
+    }
+    else{
+        if (x < half) n.sw = plantNode(n.sw, node, x, y - half, memo);
+        else n.se = plantNode(n.se, node, x - half, y - half, memo);
+    }
+
+    return makeNode(n.nw, n.ne, n.sw, n.se);
+}
+
+// The node of the square at (x, y) of a quadtree leaf (see 'QuadtreeNode'), of size 2^level.
+uint32_t HashLifeEngine::leafNode(uint64_t cells, int x, int y, int level){
+    if (level == 0) return (cells >> (8 * y + x)) & 1 ? LIVE_LEAF : DEAD_LEAF;
+
+    int half = 1 << (level - 1);
+    return makeNode(leafNode(cells, x, y, level - 1), leafNode(cells, x + half, y, level - 1),
+                    leafNode(cells, x, y + half, level - 1), leafNode(cells, x + half, y + half, level - 1));
+}
+
+/* The tree's nodes become ours one by one, in order, so the children of every node are already converted when we get to it
+(and since we hash-cons them, the squares we already have aren't duplicated).
+Then the root is planted as a whole if it's aligned to its size in our tree; if it's aligned only to half of it (like Golly's centered roots),
+its 4 children are planted one by one. Otherwise there's no node of ours it fits in, so we go through its cells. */
+void HashLifeEngine::insertQuadtree(const Quadtree& tree, int left, int top){
+    PROFILE_SCOPE("HashLifeEngine::insertQuadtree");
+    if (tree.root == 0) return;
+
+    long long int size = 1LL << tree.level(), half = size / 2;
+    if ((left & (half - 1)) != 0 || (top & (half - 1)) != 0){
+        Engine::insertQuadtree(tree, left, top);
+        return;
+    }
+
+    // Growing the root until it contains the tree
+    while (true){
+        long long int root_half = 1LL << (nodes[root].level - 1);
+        if (-root_half <= left && left + size <= root_half && -root_half <= top && top + size <= root_half) break;
+        root = expand(root);
+    }
+
+    std::vector<uint32_t> converted(tree.root + 1, DEAD_LEAF);
+    for (size_t i = 1; i <= tree.root; i++){
+        const QuadtreeNode& node = tree.nodes[i];
+        if (node.level == QUADTREE_LEAF_LEVEL){
+            converted[i] = node.leaf == 0 ? emptyNode(QUADTREE_LEAF_LEVEL) : leafNode(node.leaf, 0, 0, QUADTREE_LEAF_LEVEL);
+            continue;
+        }
+
+        uint32_t empty = emptyNode(node.level - 1);
+        converted[i] = makeNode(node.nw ? converted[node.nw] : empty, node.ne ? converted[node.ne] : empty,
+                                node.sw ? converted[node.sw] : empty, node.se ? converted[node.se] : empty);
+    }
+
+    std::unordered_map<uint64_t, uint32_t> memo;
+    long long int root_half = 1LL << (nodes[root].level - 1);
+    long long int x = left + root_half, y = top + root_half;
+    HashLifeNode added = nodes[converted[tree.root]];
+    if ((left & (size - 1)) == 0 && (top & (size - 1)) == 0) root = plantNode(root, converted[tree.root], x, y, memo);
+    else{
+        root = plantNode(root, added.nw, x, y, memo);
+        root = plantNode(root, added.ne, x + half, y, memo);
+        root = plantNode(root, added.sw, x, y + half, memo);
+        root = plantNode(root, added.se, x + half, y + half, memo);
+    }
+}
+
+// When the tree isn't aligned, it goes through the generic version - but the callers that ask are the ones that align it.
+bool HashLifeEngine::insertsQuadtreeNodes() const{
+    return true;
+}
+
+void HashLifeEngine::erase(const Cell& cell){
+    long long int half = 1LL << (nodes[root].level - 1);
+    if (cell.x < -half || half <= cell.x || cell.y < -half || half <= cell.y) return;
+
+    root = setCell(root, cell.x + half, cell.y + half, false);
+}
+
+bool HashLifeEngine::count(const Cell& cell) const{
+    long long int half = 1LL << (nodes[root].level - 1);
+    if (cell.x < -half || half <= cell.x || cell.y < -half || half <= cell.y) return false;
+
+    return getCell(root, cell.x + half, cell.y + half);
+}
+
+void HashLifeEngine::clear(){
+    reset();
+    generation = 0;
+}
+
+unsigned long long int HashLifeEngine::population() const{
+    return nodes[root].population;
+}
+
+// The root may be bigger than the 'int' coordinates, but its live cells never are (see 'advance()'), so the casts here and below don't truncate anything.
+void HashLifeEngine::forEachCellInNode(uint32_t node, long long int left, long long int top, const std::function<void(const Cell&)>& func) const{
+    const HashLifeNode& n = nodes[node];
+    if (n.population == 0) return;
+    if (n.level == 0){
+        func({(int)left, (int)top});
+        return;
+    }
+
+    long long int half = 1LL << (n.level - 1);
+    forEachCellInNode(n.nw, left, top, func);
+    forEachCellInNode(n.ne, left + half, top, func);
+    forEachCellInNode(n.sw, left, top + half, func);
+    forEachCellInNode(n.se, left + half, top + half, func);
+}
+
+void HashLifeEngine::forEachCell(const std::function<void(const Cell&)>& func) const{
+    long long int half = 1LL << (nodes[root].level - 1);
+    forEachCellInNode(root, -half, -half, func);
+}
+
+void HashLifeEngine::forEachBlockInNode(uint32_t node, int level, long long int left, long long int top,
+                                        const std::function<void(const Cell&, unsigned long long int)>& func) const{
+    const HashLifeNode& n = nodes[node];
+    if (n.population == 0) return;
+    if (n.level == level){
+        func({(int)(left >> level), (int)(top >> level)}, n.population);
+        return;
+    }
+
+    long long int half = 1LL << (n.level - 1);
+    forEachBlockInNode(n.nw, level, left, top, func);
+    forEachBlockInNode(n.ne, level, left + half, top, func);
+    forEachBlockInNode(n.sw, level, left, top + half, func);
+    forEachBlockInNode(n.se, level, left + half, top + half, func);
+}
+
+/* The nodes of the requested level are exactly the squares, and they know their population - so we never go down to the cells,
+and a huge regular pattern costs as many calls as it has non-empty squares. The root's corner is a multiple of any smaller node's size.
+A root that is no smaller than a square isn't aligned to it, but its children are - so each of them is inside a single square, and we add them up. */
+void HashLifeEngine::forEachBlock(int level, const std::function<void(const Cell&, unsigned long long int)>& func) const{
+    const HashLifeNode& n = nodes[root];
+    long long int half = 1LL << (n.level - 1);
+    if (level < n.level){
+        forEachBlockInNode(root, level, -half, -half, func);
+        return;
+    }
+
+    std::vector<std::pair<Cell, unsigned long long int>> blocks;
+    uint32_t children[4] = {n.nw, n.ne, n.sw, n.se};
+    for (int i = 0; i < 4; i++){
+        if (nodes[children[i]].population == 0) continue;
+
+        Cell block = {(int)((i % 2 == 0 ? -half : 0) >> level), (int)((i < 2 ? -half : 0) >> level)};
+        auto iter = std::find_if(blocks.begin(), blocks.end(), [&block](const auto& other){ return other.first.x == block.x && other.first.y == block.y; });
+        if (iter == blocks.end()) blocks.push_back({block, nodes[children[i]].population});
+        else iter->second += nodes[children[i]].population;
+    }
+    for (const auto& block : blocks) func(block.first, block.second);
+}
+
+// A node that is outside the rectangle is skipped as a whole, and one that is inside it is gone through without checking its cells.
+void HashLifeEngine::forEachCellInRectInNode(uint32_t node, long long int left, long long int top, const BoundingBox& rect,
+                                             const std::function<void(const Cell&)>& func) const{
+    const HashLifeNode& n = nodes[node];
+    if (n.population == 0) return;
+
+    long long int last = (1LL << n.level) - 1; // The offset of the node's last row and column
+    if (left + last < rect.left || rect.right < left || top + last < rect.top || rect.bottom < top) return;
+    if (rect.left <= left && left + last <= rect.right && rect.top <= top && top + last <= rect.bottom){
+        forEachCellInNode(node, left, top, func);
+        return;
+    }
+
+    long long int half = 1LL << (n.level - 1);
+    forEachCellInRectInNode(n.nw, left, top, rect, func);
+    forEachCellInRectInNode(n.ne, left + half, top, rect, func);
+    forEachCellInRectInNode(n.sw, left, top + half, rect, func);
+    forEachCellInRectInNode(n.se, left + half, top + half, rect, func);
+}
+
+void HashLifeEngine::forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const{
+    long long int half = 1LL << (nodes[root].level - 1);
+    forEachCellInRectInNode(root, -half, -half, rect, func);
+}
+
+// The population and bounding box of a node, relative to its top-left corner (see 'summarizeQuadtree()'), memoized since the same node repeats.
+const QuadtreeNodeSummary& HashLifeEngine::nodeSummary(uint32_t node, std::unordered_map<uint32_t, QuadtreeNodeSummary>& memo) const{
+    auto iter = memo.find(node);
+    if (iter != memo.end()) return iter->second;
+
+    const HashLifeNode& n = nodes[node];
+    QuadtreeNodeSummary summary = {n.population, LLONG_MAX, LLONG_MAX, LLONG_MIN, LLONG_MIN};
+    if (n.level == 0) summary = {n.population, 0, 0, 0, 0};
+    else{
+        long long int half = 1LL << (n.level - 1);
+        const uint32_t children[4] = {n.nw, n.ne, n.sw, n.se};
+        for (int quadrant = 0; quadrant < 4; quadrant++){
+            if (nodes[children[quadrant]].population == 0) continue;
+
+            const QuadtreeNodeSummary& child = nodeSummary(children[quadrant], memo);
+            long long int x = quadrant % 2 * half, y = quadrant / 2 * half;
+            summary.left = std::min(summary.left, x + child.left);
+            summary.top = std::min(summary.top, y + child.top);
+            summary.right = std::max(summary.right, x + child.right);
+            summary.bottom = std::max(summary.bottom, y + child.bottom);
+        }
+    }
+
+    return memo.emplace(node, summary).first->second;
+}
+
+// Every distinct node is summarized once, so a huge regular pattern takes as long as it has nodes, and not as it has cells.
+BoundingBox HashLifeEngine::boundingBox() const{
+    if (nodes[root].population == 0) return {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+
+    std::unordered_map<uint32_t, QuadtreeNodeSummary> memo;
+    const QuadtreeNodeSummary& summary = nodeSummary(root, memo);
+    long long int half = 1LL << (nodes[root].level - 1);
+
+    return {(int)(summary.left - half), (int)(summary.top - half), (int)(summary.right - half), (int)(summary.bottom - half)};
+}
+
+// The cells of a level 3 node, as the bits of a quadtree leaf.
+uint64_t HashLifeEngine::leafCells(uint32_t node) const{
+    uint64_t cells = 0;
+    for (int y = 0; y < 8; y++){
+        for (int x = 0; x < 8; x++){
+            if (getCell(node, x, y)) cells |= 1ULL << (8 * y + x);
+        }
+    }
+
+    return cells;
+}
+
+uint32_t HashLifeEngine::quadtreeNode(uint32_t node, QuadtreeBuilder& builder, std::unordered_map<uint32_t, uint32_t>& memo) const{
+    const HashLifeNode& n = nodes[node];
+    if (n.population == 0) return 0;
+
+    auto iter = memo.find(node);
+    if (iter != memo.end()) return iter->second;
+
+    uint32_t result;
+    if (n.level == QUADTREE_LEAF_LEVEL) result = builder.makeLeaf(leafCells(node));
+    else result = builder.makeNode(n.level, quadtreeNode(n.nw, builder, memo), quadtreeNode(n.ne, builder, memo),
+                                   quadtreeNode(n.sw, builder, memo), quadtreeNode(n.se, builder, memo));
+    memo.emplace(node, result);
+
+    return result;
+}
+
+// Our nodes are already hash-consed, so every one of them becomes a single node of the tree. The root's top-left corner is at (-2^(level-1), -2^(level-1)).
+void HashLifeEngine::buildQuadtree(Quadtree& tree) const{
+    PROFILE_SCOPE("HashLifeEngine::buildQuadtree");
+    QuadtreeBuilder builder(tree);
+    std::unordered_map<uint32_t, uint32_t> memo;
+    tree.root = quadtreeNode(root, builder, memo);
+}
+
+/* Like the population, a node's signature is combined from its children's - so it's computed once per node, and not once per cell.
+Children always have smaller indices than their parents, so we go over the nodes created since the last call in order, and the children's are always there.
+A node's eastern children are 'size' cells to the right of it, and its southern ones 'size' cells down. */
+StateSignature HashLifeEngine::signature(){
+    for (size_t i = node_signatures.size(); i < nodes.size(); i++){
+        const HashLifeNode& n = nodes[i];
+        if (n.level == 0){
+            node_signatures.push_back({n.population, 0, 0}); // X^0 * Y^0 = 1 for the live leaf
+            continue;
+        }
+
+        // X^size for a size of 2^62 and up is the square of the one of half the size, and so on (the exponent doesn't fit in a 'long long int')
+        int child_level = n.level - 1;
+        uint64_t size = child_level < 64 ? (uint64_t)1 << child_level : 0;
+        uint64_t factor_x = hashPowerX(1LL << std::min(child_level, 61)), factor_y = hashPowerY(1LL << std::min(child_level, 61));
+        for (int level = 61; level < child_level; level++){
+            factor_x = hashMultiply(factor_x, factor_x);
+            factor_y = hashMultiply(factor_y, factor_y);
+        }
+
+        const HashLifeNodeSignature &nw = node_signatures[n.nw], &ne = node_signatures[n.ne], &sw = node_signatures[n.sw], &se = node_signatures[n.se];
+        uint64_t east_population = nodes[n.ne].population + nodes[n.se].population;
+        uint64_t south_population = nodes[n.sw].population + nodes[n.se].population;
+        uint64_t hash = hashAdd(hashAdd(nw.hash, hashMultiply(ne.hash, factor_x)), hashMultiply(hashAdd(sw.hash, hashMultiply(se.hash, factor_x)), factor_y));
+        HashLifeNodeSignature signature = {hash,
+                                           nw.sum_x + ne.sum_x + sw.sum_x + se.sum_x + east_population * size,
+                                           nw.sum_y + ne.sum_y + sw.sum_y + se.sum_y + south_population * size};
+        node_signatures.push_back(signature);
+    }
+
+    // The root's corner is at (-half, -half)
+    const HashLifeNodeSignature& root_signature = node_signatures[root];
+    long long int half = 1LL << (nodes[root].level - 1);
+    StateSignature result = {};
+    addSignature(result, {root_signature.hash, nodes[root].population, root_signature.sum_x, root_signature.sum_y}, -half, -half);
+
+    return result;
+}
+
+/* Drops every node that isn't reachable from the root (or from the empty nodes), and compacts the rest.
+Since children always have smaller indices than their parents, a single pass from the top marks everything reachable,
+and a single pass from the bottom rebuilds the nodes in an order that keeps that property.
+Memoized results that point to dropped nodes are simply forgotten.
+The signatures of the nodes that have one move with them (they're all before the nodes that don't, so they stay a prefix). */
+void HashLifeEngine::collectGarbage(){
+    std::vector<bool> reachable(nodes.size(), false);
+    reachable[DEAD_LEAF] = reachable[LIVE_LEAF] = true;
+    reachable[root] = true;
+    for (const auto& empty : empty_nodes) reachable[empty] = true;
+
+    for (size_t i = nodes.size() - 1; 2 <= i; i--){
+        if (!reachable[i]) continue;
+        reachable[nodes[i].nw] = reachable[nodes[i].ne] = reachable[nodes[i].sw] = reachable[nodes[i].se] = true;
+    }
+
+    std::vector<uint32_t> new_index(nodes.size(), 0);
+    std::vector<HashLifeNode> new_nodes;
+    std::vector<HashLifeNodeSignature> new_signatures;
+    for (size_t i = 0; i < nodes.size(); i++){
+        if (!reachable[i]) continue;
+        if (i < node_signatures.size()) new_signatures.push_back(node_signatures[i]);
+
+        HashLifeNode node = nodes[i];
+        if (2 <= i){
+            node.nw = new_index[node.nw];
+            node.ne = new_index[node.ne];
+            node.sw = new_index[node.sw];
+            node.se = new_index[node.se];
+        }
+        new_index[i] = new_nodes.size();
+        new_nodes.push_back(node);
+    }
+
+    // A second pass, since a result is created after its node, so it might have a bigger index
+    for (auto& node : new_nodes){
+        if (node.result_exponent == NO_RESULT) continue;
+
+        if (reachable[node.result]) node.result = new_index[node.result];
+        else node.result_exponent = NO_RESULT;
+    }
+
+    nodes.swap(new_nodes);
+    node_signatures.swap(new_signatures);
+    node_table.clear();
+    for (size_t i = 2; i < nodes.size(); i++) node_table.emplace(HashLifeNodeKey{nodes[i].nw, nodes[i].ne, nodes[i].sw, nodes[i].se}, i);
+
+    root = new_index[root];
+    for (auto& empty : empty_nodes) empty = new_index[empty];
+}
@@ -0,0 +1,118 @@
+#ifndef GAME_OF_LIFE_HASHLIFE_ENGINE_H
+#define GAME_OF_LIFE_HASHLIFE_ENGINE_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "engine.h"
+
+#define HASHLIFE_MAX_NODES (1 << 22) // When there are more nodes than this between jumps, we garbage-collect the unreachable ones
+#define HASHLIFE_MAX_LEVEL 62 // The root's corners, at +-2^(level-1), must fit in a 'long long int' (and its live cells in an 'int' anyway)
+
+/* A node of level 'k' is a square of 2^k x 2^k cells, made of 4 children of level 'k-1'.
+Level 0 nodes are single cells (there are exactly 2 of them - dead and live).
+Nodes are referenced by their index in 'HashLifeEngine::nodes', and they're immutable once created. */
+struct HashLifeNode{
+    uint32_t nw, ne, sw, se;
+    // The memoized RESULT of the node: its center square (a node of level 'k-1'), advanced by 2^'result_exponent' generations.
+    uint32_t result;
+    uint8_t level;
+    uint8_t result_exponent; // 'NO_RESULT' if the result wasn't computed yet
+    uint64_t population;
+};
+
+// A node's part of the signature (see 'StateSignature'), relative to its top-left corner. The population is the node's own.
+struct HashLifeNodeSignature{
+    uint64_t hash, sum_x, sum_y;
+};
+
+struct HashLifeNodeKey{
+    uint32_t nw, ne, sw, se;
+};
+class node_key_hash{
+public:
+    std::size_t operator() (const HashLifeNodeKey& key) const{
+        uint64_t hash = ((uint64_t)key.nw * 0x9E3779B97F4A7C15) ^ ((uint64_t)key.ne * 0xC2B2AE3D27D4EB4F) ^
+                        ((uint64_t)key.sw * 0x165667B19E3779F9) ^ ((uint64_t)key.se * 0x27D4EB2F165667C5);
+        return hash ^ (hash >> 29);
+    }
+};
+class node_key_equal{
+public:
+    bool operator() (const HashLifeNodeKey& key1, const HashLifeNodeKey& key2) const{
+        return key1.nw == key2.nw && key1.ne == key2.ne && key1.sw == key2.sw && key1.se == key2.se;
+    }
+};
+
+/* Gosper's HashLife. The universe is a quadtree, where identical sub-squares are the same node (hash-consing),
+so a highly regular pattern takes very little memory.
+Since nodes are immutable, the future of a node's center can be computed once and memoized in the node itself;
+and since the same nodes repeat in space *and* in time, the memoization lets us skip exponentially many generations.
+A node of level 'k' can be advanced by up to 2^(k-2) generations, so to jump 2^j generations we just grow the root to a large enough level.
+This engine works for every rule without B0 (a B0 rule would turn the infinite empty background on). */
+class HashLifeEngine: public Engine{
+private:
+    std::vector<HashLifeNode> nodes;
+    std::unordered_map<HashLifeNodeKey, uint32_t, node_key_hash, node_key_equal> node_table; // The hash-consing table
+    std::vector<uint32_t> empty_nodes; // 'empty_nodes[k]' is the empty node of level 'k'
+    uint32_t root; // The root is centered at (0,0), so it covers [-2^(level-1), 2^(level-1)) in both axes
+    // 'node_signatures[i]' is the signature of 'nodes[i]'. Only the nodes that existed on the last call to 'signature()' have one.
+    std::vector<HashLifeNodeSignature> node_signatures;
+    bool is_at_coordinate_limit;
+
+    void reset();
+    uint32_t makeNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+    uint32_t emptyNode(int level);
+    uint32_t expand(uint32_t node);
+    bool isPaddedForJump(uint32_t node) const;
+    uint32_t centeredSubnode(uint32_t node);
+    uint32_t centeredHorizontal(uint32_t west, uint32_t east);
+    uint32_t centeredVertical(uint32_t north, uint32_t south);
+    uint32_t baseResult(uint32_t node);
+    uint32_t result(uint32_t node, int exponent);
+    bool jump(int exponent);
+    unsigned long long int populationInRect(uint32_t node, long long int left, long long int top, const BoundingBox& rect) const;
+    bool hasCellCoordinates(uint32_t node) const;
+
+    uint32_t setCell(uint32_t node, long long int x, long long int y, bool live);
+    bool getCell(uint32_t node, long long int x, long long int y) const;
+    uint32_t buildNode(Cell* begin, Cell* end, int level, long long int left, long long int top);
+    uint32_t unionNodes(uint32_t node1, uint32_t node2, std::unordered_map<uint64_t, uint32_t>& memo);
+    uint32_t plantNode(uint32_t target, uint32_t node, long long int x, long long int y, std::unordered_map<uint64_t, uint32_t>& memo);
+    uint32_t leafNode(uint64_t cells, int x, int y, int level);
+    uint64_t leafCells(uint32_t node) const;
+    uint32_t quadtreeNode(uint32_t node, QuadtreeBuilder& builder, std::unordered_map<uint32_t, uint32_t>& memo) const;
+    void forEachCellInNode(uint32_t node, long long int left, long long int top, const std::function<void(const Cell&)>& func) const;
+    void forEachCellInRectInNode(uint32_t node, long long int left, long long int top, const BoundingBox& rect,
+                                 const std::function<void(const Cell&)>& func) const;
+    const QuadtreeNodeSummary& nodeSummary(uint32_t node, std::unordered_map<uint32_t, QuadtreeNodeSummary>& memo) const;
+    void forEachBlockInNode(uint32_t node, int level, long long int left, long long int top,
+                            const std::function<void(const Cell&, unsigned long long int)>& func) const;
+    void collectGarbage();
+
+public:
+    HashLifeEngine();
+
+    void setRule(const Rule& new_rule) override;
+
+    void insert(const Cell& cell) override;
+    void erase(const Cell& cell) override;
+    void insertCells(const std::vector<Cell>& cells) override;
+    void insertQuadtree(const Quadtree& tree, int left, int top) override;
+    bool insertsQuadtreeNodes() const override;
+    bool count(const Cell& cell) const override;
+    void clear() override;
+    unsigned long long int population() const override;
+    void forEachCell(const std::function<void(const Cell&)>& func) const override;
+    void forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const override;
+    BoundingBox boundingBox() const override;
+    void forEachBlock(int level, const std::function<void(const Cell&, unsigned long long int)>& func) const override;
+    void buildQuadtree(Quadtree& tree) const override;
+    StateSignature signature() override;
+
+    void step() override;
+    void advance(unsigned long long int generations) override;
+    bool isAtCoordinateLimit() const override;
+};
+
+#endif
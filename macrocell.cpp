@@ -0,0 +1,144 @@
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include "macrocell.h"
+#include "mapped_file.h"
+#include "profiler.h"
+
+// Parses a leaf line (like ".**$**$.*$") into its 64 bits.
+static bool parseLeaf(const char* begin, const char* end, uint64_t& cells){
+    int x = 0, y = 0;
+    cells = 0;
+
+    for (const char* p = begin; p < end; p++){
+        if (*p == '$'){
+            x = 0;
+            y++;
+        }
+        else if (*p == '.' || *p == '*'){
+            if (8 <= x || 8 <= y) return false;
+            if (*p == '*') cells |= 1ULL << (8 * y + x);
+            x++;
+        }
+        else return false;
+    }
+
+    return y <= 8;
+}
+
+// Parses a line of non-negative numbers, separated by spaces, into 'numbers'. There must be exactly as many as 'numbers' has room for.
+static bool parseNumbers(const char* begin, const char* end, unsigned long long int* numbers, int count){
+    const char* p = begin;
+    for (int i = 0; i < count; i++){
+        while (p < end && *p == ' ') p++;
+        if (p == end || !isdigit((unsigned char)*p)) return false;
+
+        numbers[i] = 0;
+        for (; p < end && isdigit((unsigned char)*p); p++){
+            numbers[i] = numbers[i] * 10 + (*p - '0');
+            if (0xFFFFFFFFULL < numbers[i]) return false;
+        }
+    }
+    while (p < end && *p == ' ') p++;
+
+    return p == end;
+}
+
+/* Every node must refer only to nodes before it, of one level less, so the tree we read is valid as it is -
+and the engines can take its nodes in order, knowing that the children of a node are always there before it. */
+mc_status readMacrocell(const std::string& file_path, Quadtree& tree, MacrocellHeader& header){
+    PROFILE_SCOPE("readMacrocell");
+    tree = Quadtree();
+    header = {"", {}};
+
+    MappedFile file;
+    if (!file.open(file_path)) return MC_FILE_ERROR;
+    const char* p = file.data();
+    const char* end = file.data() + file.size();
+
+    bool first_line = true;
+    while (p < end){
+        const char* line_end = (const char*)std::memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        const char* next_line = line_end + (line_end < end);
+        if (p < line_end && line_end[-1] == '\r') line_end--;
+
+        if (first_line){
+            if (line_end - p < (long)strlen(MACROCELL_MAGIC) || std::memcmp(p, MACROCELL_MAGIC, strlen(MACROCELL_MAGIC)) != 0) return MC_FORMAT_ERROR;
+            first_line = false;
+        }
+        else if (p == line_end) { } // Empty lines are allowed anywhere
+        else if (*p == '#'){
+            if (2 < line_end - p && p[1] == 'R' && p[2] == ' '){
+                header.rule = std::string(p + 3, line_end);
+                while (!header.rule.empty() && isspace((unsigned char)header.rule.back())) header.rule.pop_back();
+            }
+            else header.comment_lines.emplace_back(p, line_end);
+        }
+        else if (*p == '.' || *p == '*' || *p == '$'){
+            uint64_t cells;
+            if (!parseLeaf(p, line_end, cells)) return MC_FORMAT_ERROR;
+            tree.nodes.push_back({QUADTREE_LEAF_LEVEL, 0, 0, 0, 0, cells});
+        }
+        else{
+            unsigned long long int numbers[5];
+            if (!parseNumbers(p, line_end, numbers, 5)) return MC_FORMAT_ERROR;
+
+            int level = (int)numbers[0];
+            if (level <= QUADTREE_LEAF_LEVEL || 62 < level) return MC_FORMAT_ERROR; // Level 1 and 2 nodes are only used by multi-state rules
+            for (int i = 1; i < 5; i++){
+                if (tree.nodes.size() <= numbers[i]) return MC_FORMAT_ERROR;
+                if (numbers[i] != 0 && tree.nodes[numbers[i]].level != level - 1) return MC_FORMAT_ERROR;
+            }
+            tree.nodes.push_back({level, (uint32_t)numbers[1], (uint32_t)numbers[2], (uint32_t)numbers[3], (uint32_t)numbers[4], 0});
+        }
+
+        p = next_line;
+    }
+    if (first_line) return MC_FORMAT_ERROR;
+
+    tree.root = tree.nodes.size() - 1; // 0 if there are no nodes at all
+    return MC_OK;
+}
+
+static void writeLeaf(std::ofstream& file, uint64_t cells){
+    std::string line;
+    for (int y = 0; y < 8 && (cells >> (8 * y)) != 0; y++){
+        uint64_t row = (cells >> (8 * y)) & 0xFF;
+        for (int x = 0; row >> x != 0; x++) line.push_back((row >> x) & 1 ? '*' : '.');
+        line.push_back('$');
+    }
+    file << line << '\n';
+}
+
+mc_status writeMacrocell(const std::string& file_path, const Quadtree& tree, const Rule& rule){
+    PROFILE_SCOPE("writeMacrocell");
+    std::ofstream file(file_path);
+    if (!file) return MC_FILE_ERROR;
+
+    file << MACROCELL_MAGIC << " (game_of_life)\n";
+    file << "#R " << rule.toString() << "\n";
+
+    // Children are before their parents, so marking from the root downward takes a single pass
+    std::vector<bool> reachable(tree.nodes.size(), false);
+    reachable[tree.root] = tree.root != 0;
+    for (size_t i = tree.root; 0 < i; i--){
+        if (!reachable[i]) continue;
+        const QuadtreeNode& n = tree.nodes[i];
+        if (n.level != QUADTREE_LEAF_LEVEL) reachable[n.nw] = reachable[n.ne] = reachable[n.sw] = reachable[n.se] = true;
+    }
+    reachable[0] = false;
+
+    std::vector<uint32_t> line_number(tree.nodes.size(), 0);
+    uint32_t next_line_number = 1;
+    for (size_t i = 1; i <= tree.root; i++){
+        if (!reachable[i]) continue;
+        line_number[i] = next_line_number++;
+
+        const QuadtreeNode& n = tree.nodes[i];
+        if (n.level == QUADTREE_LEAF_LEVEL) writeLeaf(file, n.leaf);
+        else file << n.level << ' ' << line_number[n.nw] << ' ' << line_number[n.ne] << ' ' << line_number[n.sw] << ' ' << line_number[n.se] << '\n';
+    }
+
+    return file ? MC_OK : MC_FILE_ERROR;
+}
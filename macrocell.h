@@ -0,0 +1,30 @@
+#ifndef GAME_OF_LIFE_MACROCELL_H
+#define GAME_OF_LIFE_MACROCELL_H
+
+#include <string>
+#include <vector>
+#include "quadtree.h"
+#include "rule.h"
+
+#define MACROCELL_MAGIC "[M2]" // The first line of every macrocell file starts with it
+
+enum mc_status {MC_OK, MC_FILE_ERROR, MC_FORMAT_ERROR};
+
+// What a .mc file says about its pattern, besides the tree itself.
+struct MacrocellHeader{
+    std::string rule; // From the "#R" line. Empty if the file doesn't specify one.
+    std::vector<std::string> comment_lines; // The other '#' lines, as they are
+};
+
+/* Golly's macrocell format: the pattern's quadtree, one node per line, where a node refers to its children by their line number
+(counting only the node lines, from 1), and 0 is an empty child. A line like "5 1 0 3 2" is a node of level 5 with its nw, ne, sw, se children;
+and the 8x8 leaves are written as their rows, like ".**$**$.*$" - where '$' ends a row, and the dead cells at the end of a row
+(and the empty rows at the end of a leaf) are left out. The root is the last node, and Golly puts its center at (0,0).
+
+Identical squares are written once, so a big regular pattern is orders of magnitude smaller than as RLE.
+The file is read straight into a 'Quadtree', which the engine takes as it is (see 'Engine::insertQuadtree()'). */
+mc_status readMacrocell(const std::string& file_path, Quadtree& tree, MacrocellHeader& header);
+// Writes only the nodes that are reachable from the root (a trimmed tree has some that aren't), numbered anew.
+mc_status writeMacrocell(const std::string& file_path, const Quadtree& tree, const Rule& rule);
+
+#endif
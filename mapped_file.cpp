@@ -0,0 +1,97 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(): contents(nullptr), length(0), file_handle(INVALID_HANDLE_VALUE), mapping_handle(nullptr) { }
+#else
+MappedFile::MappedFile(): contents(nullptr), length(0), file_descriptor(-1) { }
+#endif
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& file_path){
+    close();
+
+    file_handle = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size)){
+        close();
+        return false;
+    }
+    length = (size_t)file_size.QuadPart;
+    if (length == 0) return true; // An empty file can't be mapped, but there's nothing to map anyway
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle){
+        close();
+        return false;
+    }
+    contents = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!contents){
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close(){
+    if (contents) UnmapViewOfFile(contents);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+
+    contents = nullptr;
+    length = 0;
+    mapping_handle = nullptr;
+    file_handle = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::open(const std::string& file_path){
+    close();
+
+    file_descriptor = ::open(file_path.c_str(), O_RDONLY);
+    if (file_descriptor == -1) return false;
+
+    struct stat file_status;
+    if (fstat(file_descriptor, &file_status) != 0 || !S_ISREG(file_status.st_mode)){
+        close();
+        return false;
+    }
+    length = (size_t)file_status.st_size;
+    if (length == 0) return true; // An empty file can't be mapped, but there's nothing to map anyway
+
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if (mapping == MAP_FAILED){
+        close();
+        return false;
+    }
+    contents = (const char*)mapping;
+    madvise(mapping, length, MADV_SEQUENTIAL); // Just a hint, so we don't care if it fails
+
+    return true;
+}
+
+void MappedFile::close(){
+    if (contents) munmap((void*)contents, length);
+    if (file_descriptor != -1) ::close(file_descriptor);
+
+    contents = nullptr;
+    length = 0;
+    file_descriptor = -1;
+}
+#endif
@@ -0,0 +1,36 @@
+#ifndef GAME_OF_LIFE_MAPPED_FILE_H
+#define GAME_OF_LIFE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/* A read-only memory mapping of a whole file. The OS pages the file in as we read it, so nothing is copied into our own buffers,
+and a file of hundreds of MBs costs no more memory than the pages we're currently touching.
+The mapping is released by the destructor, so it can't be copied. */
+class MappedFile{
+private:
+    const char* contents;
+    size_t length;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#else
+    int file_descriptor;
+#endif
+
+    void close();
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file can't be opened or mapped. An empty file is opened fine, with a size of 0.
+    bool open(const std::string& file_path);
+
+    const char* data() const { return contents; }
+    size_t size() const { return length; }
+};
+
+#endif
@@ -24,7 +24,7 @@ int MenuScreen::getTopAndBottomOfGlyphs(int baseline){
     return max_height;
 }
 
-MenuScreen::MenuScreen():
+MenuScreen::MenuScreen(): first_option_row(0),
 option_chosen_color(sf::Color::Red), option_not_chosen_color(sf::Color::White),
 menu_title("", font, TITLE_CHARACTER_SIZE),
 menu_title_rectangle_height(getTopAndBottomOfGlyphs(TITLE_CHARACTER_SIZE) + DISTANCE),
@@ -51,49 +51,56 @@ but it's worth it, in order to reduce code duplication and to encapsulate.
 When 'PatternMenuScreen' calls this function, 'pattern_menu_screen_container' tells whether the menu option is a directory name,
 and if it is, we return and not hover on it.
 2) Clarification: When hovering is false, 'hovered_menu_option' simply holds the option corresponding to the vertical cursor height
-When hovering becomes true, this variable holds the real option on which we hover */
-void MenuScreen::handleHover(bool& hovering, int& rectangle_index, std::vector <std::string>* pattern_menu_screen_container,
+When hovering becomes true, this variable holds the real option on which we hover
+3) 'rectangle_index' is the index of the option in 'menu_options' (and in 'pattern_menu_screen_container'), and not its row in the menu */
+bool MenuScreen::handleHover(bool& hovering, int& rectangle_index, std::vector <std::string>* pattern_menu_screen_container,
                              sf::Text*& hovered_menu_option, sf::IntRect& hovered_rectangle_bounds){
-    if (!window.hasFocus()) return;
+    if (!window.hasFocus()) return false;
 
     // Convert mouse position (if it's inside window) to menu option it hovers above
     sf::Vector2i pixel_pos = sf::Mouse::getPosition(window);
     sf::Vector2f view_pos = window.mapPixelToCoords(pixel_pos);
 
+    bool changed = false;
     if (hovering){
-        if (!hovered_rectangle_bounds.contains((sf::Vector2i)view_pos)){ // Un-hover
-            hovering = false;
-            hovered_menu_option->setFillColor(option_not_chosen_color);
+        if (hovered_rectangle_bounds.contains((sf::Vector2i)view_pos)) return false;
 
-            cursor.loadFromSystem(sf::Cursor::Arrow);
-            window.setMouseCursor(cursor);
-        }
+        // Un-hover - and the mouse might be on another option already, so we go on to check that
+        hovering = false;
+        hovered_menu_option->setFillColor(option_not_chosen_color);
+        changed = true;
+
+        cursor.loadFromSystem(sf::Cursor::Arrow);
+        window.setMouseCursor(cursor);
     }
-    else{
-        // Note that we shift in 'menu_title_rectangle_height' downward, to compensate for the title text.
-        bool inside_menu = 0 <= view_pos.x && view_pos.x < window.getSize().x &&
-                menu_title_rectangle_height <= view_pos.y && view_pos.y < menu_screen_total_height;
-        if (!inside_menu) return;
-        rectangle_index = (view_pos.y - menu_title_rectangle_height) / menu_option_rectangle_height;
-        // For PatternMenuScreen - we don't hover if we're on a directory name
-        if (pattern_menu_screen_container && (*pattern_menu_screen_container)[rectangle_index].empty()) return;
-
-        hovered_menu_option = &menu_options[rectangle_index];
-        int hovered_menu_option_left = hovered_menu_option->getGlobalBounds().left;
-        int hovered_menu_option_width = hovered_menu_option->getGlobalBounds().width;
-
-        if (hovered_menu_option_left <= view_pos.x && view_pos.x < hovered_menu_option_left + hovered_menu_option_width){ // Start hovering
-            hovering = true;
-            hovered_menu_option->setFillColor(option_chosen_color);
-            // We create our own rectangle, *as to use our own top and height* (and not GlobalBounds),
-            // as to create the illusion that the menu options are directly "stacked above each other"
-            hovered_rectangle_bounds = sf::IntRect(hovered_menu_option_left, menu_title_rectangle_height + rectangle_index * menu_option_rectangle_height,
-                                                   hovered_menu_option_width, menu_option_rectangle_height);
-
-            cursor.loadFromSystem(sf::Cursor::Hand);
-            window.setMouseCursor(cursor);
-        }
+
+    // Note that we shift in 'menu_title_rectangle_height' downward, to compensate for the title text.
+    bool inside_menu = 0 <= view_pos.x && view_pos.x < window.getSize().x &&
+            menu_title_rectangle_height <= view_pos.y && view_pos.y < menu_screen_total_height;
+    if (!inside_menu) return changed;
+    rectangle_index = (int)(view_pos.y - menu_title_rectangle_height) / menu_option_rectangle_height - first_option_row;
+    if (rectangle_index < 0 || (int)menu_options.size() <= rectangle_index) return changed; // A row that isn't in 'menu_options' isn't in the view either
+    // For PatternMenuScreen - we don't hover if we're on a directory name
+    if (pattern_menu_screen_container && (*pattern_menu_screen_container)[rectangle_index].empty()) return changed;
+
+    hovered_menu_option = &menu_options[rectangle_index];
+    int hovered_menu_option_left = hovered_menu_option->getGlobalBounds().left;
+    int hovered_menu_option_width = hovered_menu_option->getGlobalBounds().width;
+
+    if (hovered_menu_option_left <= view_pos.x && view_pos.x < hovered_menu_option_left + hovered_menu_option_width){ // Start hovering
+        hovering = true;
+        hovered_menu_option->setFillColor(option_chosen_color);
+        // We create our own rectangle, *as to use our own top and height* (and not GlobalBounds),
+        // as to create the illusion that the menu options are directly "stacked above each other"
+        hovered_rectangle_bounds = sf::IntRect(hovered_menu_option_left, menu_title_rectangle_height + (first_option_row + rectangle_index) * menu_option_rectangle_height,
+                                               hovered_menu_option_width, menu_option_rectangle_height);
+
+        cursor.loadFromSystem(sf::Cursor::Hand);
+        window.setMouseCursor(cursor);
+        return true;
     }
+
+    return changed;
 }
 
 void MenuScreen::handleScroll(short int delta){
@@ -119,7 +126,7 @@ void MenuScreen::handleScroll(short int delta){
 void MenuScreen::setText(){
     centerText(menu_title, 0);
 
-    int height = menu_title_rectangle_height; // Start positioning options right below title
+    int height = menu_title_rectangle_height + first_option_row * menu_option_rectangle_height; // Start positioning options right below title (and the rows before them)
     for (auto& menu_option : menu_options){
         centerText(menu_option, height);
         height += menu_option_rectangle_height;
@@ -128,8 +135,8 @@ void MenuScreen::setText(){
 
 // Only drawing the viewed menu options
 void MenuScreen::drawText() const{
-    int first_menu_option_index = left_top_view_pos.y / menu_option_rectangle_height - 1;
-    int last_menu_option_index = (left_top_view_pos.y + window.getSize().y) / menu_option_rectangle_height + 1;
+    int first_menu_option_index = left_top_view_pos.y / menu_option_rectangle_height - 1 - first_option_row;
+    int last_menu_option_index = (left_top_view_pos.y + window.getSize().y) / menu_option_rectangle_height + 1 - first_option_row;
     for (int i = first_menu_option_index; i < last_menu_option_index; i++){
         // Since we add 1 or subtract 1 above, there's a chance we got out of range,
         // and it's easier to ask for forgiveness here than to ask for permission :-)
@@ -9,6 +9,9 @@ class MenuScreen: public BaseScreen{
 protected:
     // Depending on the concrete sub class, saves filename itself or automaton name
     std::vector <sf::Text> menu_options;
+    // The row of 'menu_options[0]'. A menu with a lot of rows (see 'PatternMenuScreen') keeps in 'menu_options' only the rows around the view,
+    // which are consecutive from this one; a short menu keeps them all, from row 0.
+    int first_option_row;
     sf::Text menu_title;
     const int menu_option_rectangle_height;
     const int menu_title_rectangle_height; // Take this height from top of window - the options start from here
@@ -21,7 +24,8 @@ protected:
     sf::Sprite arrow_up_sprite, arrow_down_sprite;
 
     static int getTopAndBottomOfGlyphs(int baseline);
-    void handleHover(bool& hovering, int& rectangle_index, std::vector <std::string>* vec, sf::Text*& hovered_menu_option,
+    // Returns whether the hover changed (so the screen should be drawn again)
+    bool handleHover(bool& hovering, int& rectangle_index, std::vector <std::string>* vec, sf::Text*& hovered_menu_option,
                      sf::IntRect& hovered_rectangle_bounds);
     void handleScroll(short int delta);
     void setText();
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include "pattern_catalog.h"
+#include "bit_utils.h"
+#include "macrocell.h"
+#include "profiler.h"
+#include "rle.h"
+
+// How many cells (along each axis) go into a thumbnail pixel, so that the longer side of the pattern fills the thumbnail.
+static long long int cellsPerPixel(long long int width, long long int height){
+    long long int side = std::max(width, height);
+    return std::max(1LL, side / CATALOG_THUMBNAIL_SIZE + (side % CATALOG_THUMBNAIL_SIZE != 0));
+}
+
+static void summarizeRLE(const std::string& path, CatalogEntry& entry){
+    RLEReader reader;
+    std::vector<Cell> cells;
+    if (reader.open(path) != RLE_OK || reader.readCells(cells) != RLE_OK) return;
+
+    entry.is_valid = true;
+    entry.rule = reader.getHeader().rule;
+    entry.population = cells.size();
+    if (cells.empty()) return;
+
+    BoundingBox box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    for (const auto& cell : cells){
+        box.left = std::min(box.left, cell.x);
+        box.top = std::min(box.top, cell.y);
+        box.right = std::max(box.right, cell.x);
+        box.bottom = std::max(box.bottom, cell.y);
+    }
+    entry.width = (long long int)box.right - box.left + 1;
+    entry.height = (long long int)box.bottom - box.top + 1;
+
+    long long int cells_per_pixel = cellsPerPixel(entry.width, entry.height);
+    for (const auto& cell : cells){
+        entry.thumbnail[((long long int)cell.y - box.top) / cells_per_pixel] |= 1 << (((long long int)cell.x - box.left) / cells_per_pixel);
+    }
+}
+
+/* Marks the pixels of the node at (left, top), where the pattern's bounding box starts at (0,0).
+A node that is no bigger than a pixel marks every pixel its bounding box touches (at most 2x2 of them), and we don't go below it -
+otherwise a huge pattern would take a walk down to the leaves along every pixel's border. Leaves of a small pattern mark their cells one by one. */
+static void markQuadtreeThumbnail(const Quadtree& tree, const std::vector<QuadtreeNodeSummary>& summaries, uint32_t node,
+                                  long long int left, long long int top, long long int cells_per_pixel, CatalogEntry& entry){
+    if (node == 0) return;
+
+    const QuadtreeNode& n = tree.nodes[node];
+    const QuadtreeNodeSummary& summary = summaries[node];
+    if (n.level == QUADTREE_LEAF_LEVEL && cells_per_pixel < 8){
+        for (uint64_t cells = n.leaf; cells != 0; cells &= cells - 1){
+            int bit = countTrailingZeros64(cells);
+            entry.thumbnail[(top + bit / 8) / cells_per_pixel] |= 1 << ((left + bit % 8) / cells_per_pixel);
+        }
+        return;
+    }
+    if ((1LL << n.level) <= cells_per_pixel){
+        for (long long int y = (top + summary.top) / cells_per_pixel; y <= (top + summary.bottom) / cells_per_pixel; y++){
+            for (long long int x = (left + summary.left) / cells_per_pixel; x <= (left + summary.right) / cells_per_pixel; x++){
+                entry.thumbnail[y] |= 1 << x;
+            }
+        }
+        return;
+    }
+
+    long long int half = 1LL << (n.level - 1);
+    markQuadtreeThumbnail(tree, summaries, n.nw, left, top, cells_per_pixel, entry);
+    markQuadtreeThumbnail(tree, summaries, n.ne, left + half, top, cells_per_pixel, entry);
+    markQuadtreeThumbnail(tree, summaries, n.sw, left, top + half, cells_per_pixel, entry);
+    markQuadtreeThumbnail(tree, summaries, n.se, left + half, top + half, cells_per_pixel, entry);
+}
+
+// A macrocell pattern is summarized from its tree, without expanding it to cells, so a huge one costs as little as its file is small.
+static void summarizeMacrocell(const std::string& path, CatalogEntry& entry){
+    Quadtree tree;
+    MacrocellHeader header;
+    if (readMacrocell(path, tree, header) != MC_OK) return;
+
+    entry.is_valid = true;
+    entry.rule = header.rule;
+    if (tree.root == 0) return;
+
+    std::vector<QuadtreeNodeSummary> summaries = summarizeQuadtree(tree);
+    const QuadtreeNodeSummary& root = summaries[tree.root];
+    entry.population = root.population;
+    entry.width = root.right - root.left + 1;
+    entry.height = root.bottom - root.top + 1;
+
+    // The root's top-left corner, relative to the pattern's bounding box
+    markQuadtreeThumbnail(tree, summaries, tree.root, -root.left, -root.top, cellsPerPixel(entry.width, entry.height), entry);
+}
+
+bool summarizePatternFile(const std::string& path, CatalogEntry& entry){
+    PROFILE_SCOPE("summarizePatternFile");
+    entry.is_valid = false;
+    entry.width = entry.height = 0;
+    entry.population = 0;
+    entry.rule.clear();
+    std::memset(entry.thumbnail, 0, sizeof(entry.thumbnail));
+
+    if (std::filesystem::path(path).extension() == ".mc") summarizeMacrocell(path, entry);
+    else summarizeRLE(path, entry);
+
+    if (!entry.is_valid){
+        entry.width = entry.height = 0;
+        entry.population = 0;
+        entry.rule.clear();
+        std::memset(entry.thumbnail, 0, sizeof(entry.thumbnail));
+    }
+
+    return entry.is_valid;
+}
+
+PatternCatalog::PatternCatalog(const std::string& directory, const std::string& index_path):
+directory(directory), index_path(index_path), rebuilding(false), stop_requested(false), files_checked(0), version(0) { }
+
+PatternCatalog::~PatternCatalog(){
+    stop_requested = true;
+    if (thread.joinable()) thread.join();
+}
+
+/* The index is a text file: the magic line, and then a line per entry, with its fields separated by tabs -
+path, modification time, size, whether it's valid, width, height, population, rule, and the thumbnail's rows in hex.
+A line that doesn't parse is skipped (its file is then parsed again), and an index of another version is ignored altogether. */
+bool PatternCatalog::loadIndex(std::vector<CatalogEntry>& loaded) const{
+    std::ifstream file(index_path);
+    std::string line;
+    if (!file || !std::getline(file, line) || line != std::string(CATALOG_MAGIC) + " " + std::to_string(CATALOG_VERSION)) return false;
+
+    while (std::getline(file, line)){
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (size_t tab = line.find('\t'); tab != std::string::npos; tab = line.find('\t', start)){
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        fields.push_back(line.substr(start));
+        if (fields.size() != 9 || fields[8].size() != 4 * CATALOG_THUMBNAIL_SIZE) continue;
+
+        CatalogEntry entry;
+        try {
+            entry.path = fields[0];
+            entry.modified_time = std::stoll(fields[1]);
+            entry.file_size = std::stoull(fields[2]);
+            entry.is_valid = fields[3] == "1";
+            entry.width = std::stoll(fields[4]);
+            entry.height = std::stoll(fields[5]);
+            entry.population = std::stoull(fields[6]);
+            entry.rule = fields[7];
+            for (int y = 0; y < CATALOG_THUMBNAIL_SIZE; y++) entry.thumbnail[y] = (uint16_t)std::stoul(fields[8].substr(4 * y, 4), nullptr, 16);
+        } catch (std::exception& exc) {
+            continue;
+        }
+
+        loaded.push_back(entry);
+    }
+
+    return true;
+}
+
+// Written next to the index first, and moved over it once it's complete, like a checkpoint - so a crash never leaves half an index.
+bool PatternCatalog::saveIndex(const std::vector<CatalogEntry>& saved) const{
+    std::string temp_path = index_path + ".tmp";
+    std::ofstream file(temp_path);
+    if (!file) return false;
+
+    file << CATALOG_MAGIC << " " << CATALOG_VERSION << "\n";
+    for (const auto& entry : saved){
+        // Such a path can't be written in a line of its own, so its file is simply parsed again next time
+        if (entry.path.find_first_of("\t\r\n") != std::string::npos) continue;
+
+        char thumbnail[4 * CATALOG_THUMBNAIL_SIZE + 1];
+        for (int y = 0; y < CATALOG_THUMBNAIL_SIZE; y++) snprintf(thumbnail + 4 * y, 5, "%04x", entry.thumbnail[y]);
+
+        file << entry.path << '\t' << entry.modified_time << '\t' << entry.file_size << '\t' << entry.is_valid << '\t'
+             << entry.width << '\t' << entry.height << '\t' << entry.population << '\t' << entry.rule << '\t' << thumbnail << '\n';
+    }
+    file.close();
+
+    std::error_code error;
+    if (!file || (std::filesystem::rename(temp_path, index_path, error), error)){
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+void PatternCatalog::publish(std::vector<CatalogEntry>& new_entries){
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    entries.swap(new_entries);
+    version++;
+}
+
+void PatternCatalog::rebuild(){
+    PROFILE_SCOPE("PatternCatalog::rebuild");
+    std::vector<CatalogEntry> previous = getEntries();
+    if (getVersion() == 0 && loadIndex(previous)){
+        std::vector<CatalogEntry> loaded = previous;
+        publish(loaded);
+    }
+
+    std::unordered_map<std::string, const CatalogEntry*> previous_by_path;
+    for (const auto& entry : previous) previous_by_path.emplace(entry.path, &entry);
+
+    // Like the menu, we only look one level down: every sub-directory is a pattern type, and the patterns are in it
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for (const auto& pattern_type_dir : std::filesystem::directory_iterator(directory, error)){
+        if (!pattern_type_dir.is_directory(error)) continue;
+
+        for (const auto& file : std::filesystem::directory_iterator(pattern_type_dir.path(), error)){
+            std::string extension = file.path().extension().string();
+            if ((extension == ".rle" || extension == ".mc") && file.is_regular_file(error)) paths.push_back(file.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<CatalogEntry> rebuilt;
+    rebuilt.reserve(paths.size());
+    bool changed = paths.size() != previous.size();
+    for (const auto& path : paths){
+        if (stop_requested) break;
+        files_checked++;
+
+        CatalogEntry entry;
+        entry.path = path.string();
+        entry.file_size = std::filesystem::file_size(path, error);
+        if (error) continue; // Deleted since we listed it
+        entry.modified_time = (long long int)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        if (error) continue;
+
+        auto iter = previous_by_path.find(entry.path);
+        if (iter != previous_by_path.end() && iter->second->modified_time == entry.modified_time && iter->second->file_size == entry.file_size){
+            rebuilt.push_back(*iter->second);
+            continue;
+        }
+
+        summarizePatternFile(entry.path, entry);
+        rebuilt.push_back(entry);
+        changed = true;
+    }
+
+    // If we were stopped halfway, what we have is incomplete, and the index file is left as it was
+    if (!stop_requested && (changed || rebuilt.size() != previous.size())){
+        saveIndex(rebuilt);
+        publish(rebuilt);
+    }
+    rebuilding = false;
+}
+
+void PatternCatalog::startRebuild(){
+    if (rebuilding) return;
+    if (thread.joinable()) thread.join(); // The last rebuild is over, but its thread still has to be joined
+
+    rebuilding = true;
+    files_checked = 0;
+    thread = std::thread(&PatternCatalog::rebuild, this);
+}
+
+bool PatternCatalog::isRebuilding() const{
+    return rebuilding;
+}
+
+unsigned long long int PatternCatalog::filesChecked() const{
+    return files_checked;
+}
+
+unsigned int PatternCatalog::getVersion() const{
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    return version;
+}
+
+std::vector<CatalogEntry> PatternCatalog::getEntries() const{
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    return entries;
+}
@@ -0,0 +1,71 @@
+#ifndef GAME_OF_LIFE_PATTERN_CATALOG_H
+#define GAME_OF_LIFE_PATTERN_CATALOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATALOG_MAGIC "game_of_life pattern catalog" // The first line of the index file, followed by its version
+#define CATALOG_VERSION 1
+#define CATALOG_THUMBNAIL_SIZE 16 // Thumbnails are this many pixels wide and tall
+
+// What we know about a pattern file without parsing it again - as long as it wasn't changed since.
+struct CatalogEntry{
+    std::string path;
+    long long int modified_time; // In the file system's own clock, so it's only compared with itself
+    unsigned long long int file_size;
+
+    bool is_valid; // False if the file couldn't be parsed, and then the fields below are all 0
+    long long int width, height; // Of the pattern's bounding box
+    unsigned long long int population;
+    std::string rule; // As the file specifies it, or empty if it doesn't
+    // Bit x of row y is set if the pattern has a live cell in that pixel. The pattern is scaled by its longer side, so it keeps its proportions.
+    uint16_t thumbnail[CATALOG_THUMBNAIL_SIZE];
+};
+
+/* An index of the .rle and .mc files in the sub-directories of a patterns directory, kept in a file, so we don't parse them on every run.
+An entry is reused for as long as its file has the same modification time and size, so rebuilding the index after a file was added or changed
+parses only that file, and the others cost a 'stat()' each.
+
+Both loading the index and rebuilding it happen on a thread of their own, so none of it is done before the first screen shows.
+The index is published (see 'getVersion()') once it's loaded, and again once it's rebuilt. */
+class PatternCatalog{
+private:
+    const std::string directory, index_path;
+    std::thread thread;
+    std::atomic<bool> rebuilding, stop_requested;
+    std::atomic<unsigned long long int> files_checked;
+
+    mutable std::mutex entries_mutex; // Guards 'entries' and 'version'
+    std::vector<CatalogEntry> entries; // Sorted by path
+    unsigned int version;
+
+    bool loadIndex(std::vector<CatalogEntry>& loaded) const;
+    bool saveIndex(const std::vector<CatalogEntry>& saved) const;
+    void publish(std::vector<CatalogEntry>& new_entries);
+    void rebuild();
+
+public:
+    PatternCatalog(const std::string& directory, const std::string& index_path);
+    ~PatternCatalog(); // Stops a rebuild that is still going (without saving it) and waits for it
+    PatternCatalog(const PatternCatalog&) = delete;
+    PatternCatalog& operator=(const PatternCatalog&) = delete;
+
+    // Starts a rebuild on the background thread, unless one is going already. The first one loads the index file as well.
+    void startRebuild();
+    bool isRebuilding() const;
+    // How many files the current (or last) rebuild went over, for showing its progress.
+    unsigned long long int filesChecked() const;
+
+    // Goes up by one every time new entries are published, so the caller knows when to take them.
+    unsigned int getVersion() const;
+    std::vector<CatalogEntry> getEntries() const;
+};
+
+// Parses the .rle or .mc file at 'path' into its entry. Returns false if it's not a valid pattern (and then the entry is marked so).
+bool summarizePatternFile(const std::string& path, CatalogEntry& entry);
+
+#endif
@@ -25,8 +25,11 @@ void PatternInputScreen::handleLeftClick(const sf::Vector2i& pixel_pos) const{
         view_pos_integer.y /= CELL_SIZE;
 
         // We allow selecting and deselecting cells
-        if (grid.count(view_pos_integer)) grid.erase(view_pos_integer);
-        else grid.insert(view_pos_integer);
+        Cell cell = {view_pos_integer.x, view_pos_integer.y};
+        if (grid->count(cell)) grid->erase(cell);
+        else grid->insert(cell);
+        render_cache.setCell(cell, grid->count(cell));
+        density_cache.invalidate(); // A texel might be a square of many cells, so there's no patching it
     }
 }
 
@@ -34,10 +37,13 @@ short int PatternInputScreen::run(){
     bool clicking = false, dragging = false;
     sf::Vector2i old_pos, initial_click_pos;
     sf::Clock key_press_clock;
+    render_cache.invalidate(); // The grid may have changed since it was drawn last (like when a game ends)
+    density_cache.invalidate();
+    frame_scheduler.requestRedraw();
 
     while (true){
         sf::Event evnt;
-        while (window.pollEvent(evnt)){
+        while (frame_scheduler.pollEvent(window, evnt)){
             switch (evnt.type){
                 // The program exits when user closes the window by pressing 'X'.
                 case sf::Event::Closed:
@@ -45,7 +51,7 @@ short int PatternInputScreen::run(){
 
                 case sf::Event::KeyPressed:
                     if (evnt.key.code == sf::Keyboard::Escape){
-                        grid.clear();
+                        grid->clear();
                         zoom = 1;
                         return PATTERN_MENU_SCREEN;
                     }
@@ -100,6 +106,7 @@ short int PatternInputScreen::run(){
                     else dragging = true;
 
                     handleDrag(old_pos, new_pos);
+                    frame_scheduler.requestRedraw();
                     break;
                 }
 
@@ -130,7 +137,10 @@ short int PatternInputScreen::run(){
         long long int delta_time = key_press_clock.restart().asMicroseconds();
         // Because 'isKeyPressed' is "connected" to the actual device, it's getting input even when window is out of focus.
         // We want to accept keyboard input only when the window has focus, so we check for it.
-        if (window.hasFocus()) checkForChangeViewWithKeys(delta_time);
+        if (window.hasFocus() && checkForChangeViewWithKeys(delta_time)) frame_scheduler.requestRedraw();
+
+        // Nothing else changes the grid or the view, so without an event (or a key held down) the frame would be the same as the last one
+        if (!frame_scheduler.startFrame()) continue;
 
         window.clear(dead_cell_color);
         // Note to self: in previous versions, drawing took almost 100%(!) of the iteration's runtime, because we drew the *entire grid* every time.
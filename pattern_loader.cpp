@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include "pattern_loader.h"
+#include "bit_utils.h"
+#include "macrocell.h"
+#include "profiler.h"
+#include "rle.h"
+
+PatternLoader::PatternLoader(): done(true), cancel_requested(false), work_done(0), total_work(0), status(PATTERN_LOAD_OK) { }
+
+PatternLoader::~PatternLoader(){
+    cancel();
+    wait();
+}
+
+// Inserts the cells, moved by (dx, dy), a batch at a time - so the engine's bulk insert is used, and we can stop between batches.
+pattern_load_status PatternLoader::insertBatches(Engine& engine, const std::vector<Cell>& cells, int dx, int dy){
+    std::vector<Cell> batch;
+    batch.reserve(std::min<size_t>(cells.size(), PATTERN_LOAD_BATCH_SIZE));
+
+    for (size_t start = 0; start < cells.size(); start += PATTERN_LOAD_BATCH_SIZE){
+        if (cancel_requested) return PATTERN_LOAD_CANCELLED;
+
+        size_t end = std::min<size_t>(cells.size(), start + PATTERN_LOAD_BATCH_SIZE);
+        batch.clear();
+        for (size_t i = start; i < end; i++) batch.push_back({cells[i].x + dx, cells[i].y + dy});
+        engine.insertCells(batch);
+        work_done += batch.size();
+    }
+
+    return PATTERN_LOAD_OK;
+}
+
+pattern_load_status PatternLoader::loadRLE(const std::string& file_path, Engine& engine, int center_x, int center_y){
+    RLEReader reader;
+    rle_status status = reader.open(file_path);
+    const RLEHeader& header = reader.getHeader();
+    file_rule = header.rule;
+
+    // With the size from the header the cells are decoded right where they go; otherwise we need their center of mass first
+    bool has_size = 0 < header.width && 0 < header.height;
+    std::vector<Cell> cells;
+    if (status == RLE_OK){
+        if (has_size) status = reader.readCells(cells, center_x - header.width / 2, center_y - header.height / 2);
+        else status = reader.readCells(cells);
+    }
+    if (status == RLE_FILE_ERROR) return PATTERN_LOAD_FILE_ERROR;
+    if (status == RLE_FORMAT_ERROR) return PATTERN_LOAD_FORMAT_ERROR;
+    total_work = cells.size();
+
+    int dx = 0, dy = 0;
+    if (!has_size && !cells.empty()){
+        long long int sum_x = 0, sum_y = 0;
+        for (const auto& cell : cells){
+            sum_x += cell.x;
+            sum_y += cell.y;
+        }
+        dx = center_x - (int)(sum_x / (long long int)cells.size());
+        dy = center_y - (int)(sum_y / (long long int)cells.size());
+    }
+
+    return insertBatches(engine, cells, dx, dy);
+}
+
+// Like 'forEachQuadtreeCell()', but it can be stopped halfway: it returns false as soon as 'func' does.
+static bool forEachNodeCellUntil(const Quadtree& tree, uint32_t node, long long int left, long long int top, const std::function<bool(const Cell&)>& func){
+    if (node == 0) return true;
+
+    const QuadtreeNode& n = tree.nodes[node];
+    if (n.level == QUADTREE_LEAF_LEVEL){
+        for (uint64_t cells = n.leaf; cells != 0; cells &= cells - 1){
+            int bit = countTrailingZeros64(cells);
+            if (!func({(int)(left + bit % 8), (int)(top + bit / 8)})) return false;
+        }
+        return true;
+    }
+
+    long long int half = 1LL << (n.level - 1);
+    return forEachNodeCellUntil(tree, n.nw, left, top, func) && forEachNodeCellUntil(tree, n.ne, left + half, top, func) &&
+           forEachNodeCellUntil(tree, n.sw, left, top + half, func) && forEachNodeCellUntil(tree, n.se, left + half, top + half, func);
+}
+
+pattern_load_status PatternLoader::loadMacrocell(const std::string& file_path, Engine& engine, int center_x, int center_y){
+    Quadtree tree;
+    MacrocellHeader header;
+    mc_status status = readMacrocell(file_path, tree, header);
+    file_rule = header.rule;
+    if (status == MC_FILE_ERROR) return PATTERN_LOAD_FILE_ERROR;
+    if (status == MC_FORMAT_ERROR) return PATTERN_LOAD_FORMAT_ERROR;
+
+    long long int left = 0, top = 0;
+    trimQuadtree(tree, left, top);
+    if (QUADTREE_MAX_LEVEL < tree.level()) return PATTERN_LOAD_TOO_BIG;
+    if (tree.root == 0) return PATTERN_LOAD_OK;
+
+    long long int half = 1LL << (tree.level() - 1);
+    long long int x = center_x - half, y = center_y - half;
+    x -= (x % half + half) % half; // Rounding down, also for negative numbers
+    y -= (y % half + half) % half;
+
+    if (engine.insertsQuadtreeNodes()){
+        total_work = 1;
+        engine.insertQuadtree(tree, (int)x, (int)y);
+        work_done = 1;
+        return PATTERN_LOAD_OK;
+    }
+
+    total_work = summarizeQuadtree(tree)[tree.root].population;
+    std::vector<Cell> batch;
+    batch.reserve(PATTERN_LOAD_BATCH_SIZE);
+    bool finished = forEachNodeCellUntil(tree, tree.root, x, y, [this, &engine, &batch](const Cell& cell){
+        batch.push_back(cell);
+        if (batch.size() < PATTERN_LOAD_BATCH_SIZE) return true;
+
+        engine.insertCells(batch);
+        work_done += batch.size();
+        batch.clear();
+        return !cancel_requested;
+    });
+    if (!finished) return PATTERN_LOAD_CANCELLED;
+
+    engine.insertCells(batch);
+    work_done += batch.size();
+    return PATTERN_LOAD_OK;
+}
+
+void PatternLoader::start(const std::string& file_path, Engine& engine, int center_x, int center_y){
+    wait(); // There's only one load at a time
+
+    done = false;
+    cancel_requested = false;
+    work_done = 0;
+    total_work = 0;
+    file_rule.clear();
+    thread = std::thread([this, file_path, &engine, center_x, center_y](){
+        PROFILE_SCOPE("PatternLoader::load");
+        if (std::filesystem::path(file_path).extension() == ".mc") status = loadMacrocell(file_path, engine, center_x, center_y);
+        else status = loadRLE(file_path, engine, center_x, center_y);
+        done = true;
+    });
+}
+
+void PatternLoader::cancel(){
+    cancel_requested = true;
+}
+
+bool PatternLoader::isDone() const{
+    return done;
+}
+
+double PatternLoader::progress() const{
+    unsigned long long int total = total_work;
+    if (done) return 1;
+    if (total == 0) return 0;
+
+    return std::min(1.0, (double)work_done / total);
+}
+
+pattern_load_status PatternLoader::wait(){
+    if (thread.joinable()) thread.join();
+    return status;
+}
+
+const std::string& PatternLoader::getFileRule() const{
+    return file_rule;
+}
@@ -0,0 +1,49 @@
+#ifndef GAME_OF_LIFE_PATTERN_LOADER_H
+#define GAME_OF_LIFE_PATTERN_LOADER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cell.h"
+#include "engine.h"
+
+#define PATTERN_LOAD_BATCH_SIZE (1 << 16) // Cells are inserted into the engine this many at a time, and a cancel is noticed between batches
+
+enum pattern_load_status {PATTERN_LOAD_OK, PATTERN_LOAD_FILE_ERROR, PATTERN_LOAD_FORMAT_ERROR, PATTERN_LOAD_TOO_BIG, PATTERN_LOAD_CANCELLED};
+
+/* Loads an .rle or .mc file into an engine on a thread of its own, so the screen keeps responding (and can show the progress) while a big one loads.
+The file is parsed first, and then its cells are streamed into the engine in batches, so the load can be cancelled halfway.
+A macrocell file goes into an engine that takes quadtrees as they are (see 'Engine::insertsQuadtreeNodes()') in one go, since that's quick anyway.
+
+The pattern is centered at (center_x, center_y): by its size, if the file tells it (like an .rle header does), or else by its center of mass.
+A macrocell tree is rounded to a multiple of half its size, so an engine that is a quadtree itself can take its nodes.
+Nobody else may touch the engine until the load is done. If it's cancelled (or fails), whatever was inserted so far stays in the engine. */
+class PatternLoader{
+private:
+    std::thread thread;
+    std::atomic<bool> done, cancel_requested;
+    std::atomic<unsigned long long int> work_done, total_work;
+    // Written by the thread before 'done' is set
+    pattern_load_status status;
+    std::string file_rule;
+
+    pattern_load_status insertBatches(Engine& engine, const std::vector<Cell>& cells, int dx, int dy);
+    pattern_load_status loadRLE(const std::string& file_path, Engine& engine, int center_x, int center_y);
+    pattern_load_status loadMacrocell(const std::string& file_path, Engine& engine, int center_x, int center_y);
+
+public:
+    PatternLoader();
+    ~PatternLoader(); // Cancels a load that is still going, and waits for it
+
+    void start(const std::string& file_path, Engine& engine, int center_x, int center_y);
+    void cancel();
+    bool isDone() const;
+    double progress() const; // From 0 to 1. It stays 0 while the file is parsed, since until then we don't know how many cells it has.
+    // Waits for the load to finish (if it hasn't yet), and returns how it went.
+    pattern_load_status wait();
+    // The rule the file was made for, as it says it (or empty, if it doesn't). Valid once the load is done.
+    const std::string& getFileRule() const;
+};
+
+#endif
@@ -1,183 +1,466 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <iostream>
 #include <filesystem>
-#include <fstream>
 #include "screens.h"
 
+/* The text is measured from the left of the window (so it has to be centered after this).
+A character is never to the left of the one before it, so we binary search for the longest beginning that fits,
+instead of going over the characters one by one (every 'findCharacterPos()' goes over them as well). */
 void PatternMenuScreen::truncateFileNameIfTooLong(sf::Text& text){
+    text.setPosition(0, text.getPosition().y);
     std::string text_str = text.getString();
-    size_t i = text_str.size() - 1;
-    for (; 0 <= i; i--){
-        // 100 is an arbitrary number so filenames at screen width wouldn't be allowed
-        if (text.findCharacterPos(i + 1).x < window.getSize().x - 100) break;
+    float max_x = window.getSize().x - 100; // 100 is an arbitrary number so filenames at screen width wouldn't be allowed
+    if (text.findCharacterPos(text_str.size()).x < max_x) return;
+
+    size_t fitting = 0, not_fitting = text_str.size(); // Lengths of a beginning that fits, and of one that doesn't
+    while (fitting + 1 < not_fitting){
+        size_t length = (fitting + not_fitting) / 2;
+        if (text.findCharacterPos(length).x < max_x) fitting = length;
+        else not_fitting = length;
     }
 
-    text_str.erase(i + 1, std::string::npos);
-    if (i != text.getString().getSize() - 1) text_str.append("..."); // If we've entered, that means we've truncated
-    text.setString(text_str);
-}
-
-// The function saves all .rle filenames in 'pattern' directory in 'menu_options',
-// and saves the corresponding path to father directory in 'num_to_pattern_path'.
-void PatternMenuScreen::iterateOverPatternDirectory(){
-    unsigned long long int index = 2;
-
-    // 'directory_iterator' is on one hand a container, and on other hand an iterator...very confusing.
-    // Anyway, it stores all the files in given 'dir_path'.
-    for (const auto& pattern_type_dir : std::filesystem::directory_iterator("patterns")){ // Iterating over pattern *types*.
-        // If it's not a directory, or it's an empty directory, we continue.
-        if (!std::filesystem::is_directory(pattern_type_dir) || std::filesystem::is_empty(pattern_type_dir)) continue;
-        // 'pattern_type_dir.path()' returns relative path, 'relative()' returns it without the dirname at the start,
-        // 'stem()' stems the file extension, and 'string()', well, returns the string version of the 'path' object.
-        menu_options.emplace_back(relative(pattern_type_dir.path(), "patterns").stem().string() + ":", font, OPTION_CHARACTER_SIZE);
-        menu_options.back().setFillColor(important_color);
-        menu_options.back().setStyle(sf::Text::Bold);
-        truncateFileNameIfTooLong(menu_options.back());
-        menu_options_pattern_paths.emplace_back("");
-
-        for (const auto& entry : std::filesystem::directory_iterator(pattern_type_dir)){ // Iterating over patterns themselves.
-            // If it's not an .rle file, we continue.
-            if (entry.path().extension().string() != ".rle") continue;
-
-            menu_options.emplace_back(std::to_string(index) + ". " + relative(entry.path(), pattern_type_dir).stem().string(), font, OPTION_CHARACTER_SIZE);
-            truncateFileNameIfTooLong(menu_options.back());
-
-            menu_options_pattern_paths.push_back(entry.path().parent_path().string());
-            index++;
+    text.setString(text_str.substr(0, fitting) + "...");
+}
+
+// What the catalog knows about the pattern, shown next to its name, like "  [3x3, 5 cells, B3/S23]".
+std::string PatternMenuScreen::describeEntry(const CatalogEntry& entry){
+    if (!entry.is_valid) return "  [unreadable]";
+
+    std::string description = "  [" + std::to_string(entry.width) + "x" + std::to_string(entry.height) + ", " + std::to_string(entry.population) + " cells";
+    if (!entry.rule.empty()) description += ", " + entry.rule;
+    return description + "]";
+}
+
+// The entries are sorted by path, so the patterns of every directory come one after another.
+// We work out the name and directory of every entry once per catalog update, so the rows can be made of indices alone (see 'buildRows()').
+void PatternMenuScreen::buildEntryNames(){
+    entry_names.clear();
+    entry_directories.clear();
+    directory_names.clear();
+
+    // We cut the paths ourselves - with 'std::filesystem::path' it takes 4 times longer, which shows with tens of thousands of patterns
+    std::string pattern_type_dir;
+    for (size_t i = 0; i < catalog_entries.size(); i++){
+        const std::string& path = catalog_entries[i].path;
+        size_t filename_start = path.find_last_of("/\\") + 1; // 0 if there's no directory
+        if (i == 0 || path.compare(0, filename_start, pattern_type_dir) != 0){
+            pattern_type_dir = path.substr(0, filename_start);
+            size_t dir_start = filename_start < 2 ? 0 : pattern_type_dir.find_last_of("/\\", filename_start - 2) + 1;
+            directory_names.push_back(pattern_type_dir.substr(dir_start, filename_start - 1 - dir_start));
         }
+        entry_directories.push_back(directory_names.size() - 1);
+
+        // Macrocell files keep their extension in the menu, so a pattern that comes in both formats can be told apart
+        size_t extension_start = path.find_last_of('.');
+        bool is_macrocell = extension_start != std::string::npos && filename_start <= extension_start && path.compare(extension_start, std::string::npos, ".mc") == 0;
+        if (extension_start == std::string::npos || extension_start <= filename_start || is_macrocell) extension_start = path.size();
+        entry_names.push_back(path.substr(filename_start, extension_start - filename_start));
     }
+
+    is_name_index_built = false; // It's of the old names
 }
 
-PatternMenuScreen::PatternMenuScreen(){
-    // 0th item is "custom pattern", so obviously it has no path.
-    // Still writing something, so I can identify pattern directories later.
-    menu_options_pattern_paths = {"Custom"};
-    menu_options.emplace_back("1. Input your own custom pattern", font, OPTION_CHARACTER_SIZE);
+// The custom pattern, and then the patterns that match the search, each under the name of its directory.
+void PatternMenuScreen::buildRows(){
+    rows.clear();
+    rows.push_back({CUSTOM_PATTERN_ROW, -1});
+
+    std::vector<int> matches;
+    if (!search.empty()) matches = name_index.namesIn(search_range);
+    size_t matches_count = search.empty() ? catalog_entries.size() : matches.size();
+
+    int previous_directory = -1;
+    for (size_t i = 0; i < matches_count; i++){
+        int entry_index = search.empty() ? i : matches[i];
+        if (entry_directories[entry_index] != previous_directory){
+            previous_directory = entry_directories[entry_index];
+            rows.push_back({DIRECTORY_ROW, entry_index});
+        }
+        rows.push_back({PATTERN_ROW, entry_index});
+    }
 
-    // If 'patterns' directory doesn't exist, it creates it; otherwise, it does nothing.
-    // Calling 'iterateOverPatternDirectory()' in 'run()' (to reflect changes made to files while the program runs) hurts performance,
-    // as it's an expensive function.
-    // Instead, we call it once (before the menus are showed), and if the user deletes/moves the files, we simply exit
-    std::filesystem::create_directories("patterns");
-    iterateOverPatternDirectory();
+    menu_screen_total_height = menu_title_rectangle_height + rows.size() * menu_option_rectangle_height;
+}
 
-    menu_title.setString("Pattern Menu");
-    menu_screen_total_height = menu_title_rectangle_height + menu_options.size() * menu_option_rectangle_height;
+// Makes 'menu_options[option_index]' the text of its row (and sets its path), whatever row it was the text of before.
+void PatternMenuScreen::setOption(int option_index){
+    const PatternMenuRow& row = rows[first_option_row + option_index];
+    sf::Text& text = menu_options[option_index];
+
+    switch (row.type){
+        case CUSTOM_PATTERN_ROW:
+            // It has no path, but still writing something, so I can tell it from the directory names
+            text.setString("1. Input your own custom pattern");
+            menu_options_pattern_paths[option_index] = "Custom";
+            break;
+
+        case DIRECTORY_ROW:
+            text.setString(directory_names[entry_directories[row.entry_index]] + ":");
+            menu_options_pattern_paths[option_index] = "";
+            break;
+
+        case PATTERN_ROW:
+            // The custom pattern is 1, and the patterns are numbered from 2 in the catalog's order (also when some are filtered out by the search)
+            text.setString(std::to_string(row.entry_index + 2) + ". " + entry_names[row.entry_index] + describeEntry(catalog_entries[row.entry_index]));
+            menu_options_pattern_paths[option_index] = catalog_entries[row.entry_index].path;
+            break;
+    }
+
+    text.setFillColor(row.type == DIRECTORY_ROW ? important_color : option_not_chosen_color);
+    text.setStyle(row.type == DIRECTORY_ROW ? sf::Text::Bold : sf::Text::Regular);
+    truncateFileNameIfTooLong(text);
+    centerText(text, menu_title_rectangle_height + (first_option_row + option_index) * menu_option_rectangle_height);
 }
 
-sf::Vector2i PatternMenuScreen::centerOfMass() const{
-    if (chosen_pattern.empty()) return {0,0}; // If pattern is empty, then there is no center of mass.
+/* Makes 'menu_options' the texts of the rows in the view, and 'OPTIONS_MARGIN_ROWS' more on each side. Returns whether it changed them.
+When we scroll, the texts of the rows that left that range are recycled for the rows that came into it (the others stay as they are),
+so a scroll costs as much as the rows it brings in, however many rows there are. With 'rebuild', all of them are made again
+(for when the rows or the window's size changed). The hover must be reset before (see 'resetHover()'), as its text might become another row's. */
+bool PatternMenuScreen::setVisibleOptions(bool rebuild){
+    int rows_in_view = window.getSize().y / menu_option_rectangle_height + 1;
+    int first_row = ((int)left_top_view_pos.y - menu_title_rectangle_height) / menu_option_rectangle_height - OPTIONS_MARGIN_ROWS;
+    first_row = std::max(0, std::min<int>(first_row, rows.size() - 1));
+    int count = std::min<int>(rows.size() - first_row, rows_in_view + 2 * OPTIONS_MARGIN_ROWS);
+
+    int shift = first_row - first_option_row;
+    if (!rebuild && shift == 0 && count == (int)menu_options.size()) return false;
+    first_option_row = first_row;
+
+    if (rebuild || count != (int)menu_options.size() || count <= std::abs(shift)){
+        menu_options.resize(count, sf::Text("", font, OPTION_CHARACTER_SIZE));
+        menu_options_pattern_paths.resize(count);
+        for (int i = 0; i < count; i++) setOption(i);
+        return true;
+    }
 
-    int sum_x = 0, sum_y = 0, cell_amount = chosen_pattern.size();
+    // The texts that scrolled out on one side are moved to the other side, where they become the rows that scrolled in
+    if (0 < shift){
+        std::rotate(menu_options.begin(), menu_options.begin() + shift, menu_options.end());
+        std::rotate(menu_options_pattern_paths.begin(), menu_options_pattern_paths.begin() + shift, menu_options_pattern_paths.end());
+        for (int i = count - shift; i < count; i++) setOption(i);
+    }
+    else{
+        std::rotate(menu_options.begin(), menu_options.end() + shift, menu_options.end());
+        std::rotate(menu_options_pattern_paths.begin(), menu_options_pattern_paths.end() + shift, menu_options_pattern_paths.end());
+        for (int i = 0; i < -shift; i++) setOption(i);
+    }
+    return true;
+}
 
-    for (const auto& cell : chosen_pattern){
-        sum_x += cell.x;
-        sum_y += cell.y;
+/* Shows only the patterns that have a word starting with 'new_search' (all of them, if it's empty).
+If it's the search we had with more letters typed, we search only in what that one found. A new search is shown from the top. */
+void PatternMenuScreen::setSearch(const std::string& new_search){
+    bool is_typed_on = search.size() < new_search.size() && new_search.compare(0, search.size(), search) == 0;
+    bool is_new = new_search != search;
+    if (!new_search.empty() && !is_name_index_built){
+        name_index.build(entry_names);
+        is_name_index_built = true;
+        is_typed_on = false;
     }
+    if (!new_search.empty()) search_range = name_index.narrow(is_typed_on ? search_range : name_index.all(), new_search);
+    search = new_search;
 
-    return {sum_x / cell_amount, sum_y / cell_amount};
+    buildRows();
+    if (is_new) left_top_view_pos.y = 0;
+    else left_top_view_pos.y = std::min<float>(left_top_view_pos.y, std::max(0, menu_screen_total_height - (int)window.getSize().y));
+    view.reset(sf::FloatRect(0, left_top_view_pos.y, window.getSize().x, window.getSize().y));
+    window.setView(view);
+
+    setArrows();
+    setVisibleOptions(true);
+    setTitle();
 }
 
-// RLE parser: Takes an .rle file and fill 'pattern' according to its content.
-void PatternMenuScreen::RLEToGrid(){
-    std::ifstream rle_file; // read-only
-    rle_file.open(chosen_file_path);
-    if (rle_file.fail()){
-        std::cerr << "File has been deleted or moved since start of program" << std::endl;
-        exit(-1);
+// Un-hovers, before the texts in 'menu_options' are made anew or recycled for other rows - 'hovered_menu_option' is one of them.
+void PatternMenuScreen::resetHover(bool& hovering, sf::Text*& hovered_menu_option){
+    if (hovering){
+        hovered_menu_option->setFillColor(option_not_chosen_color);
+        hovering = false;
+        cursor.loadFromSystem(sf::Cursor::Arrow);
+        window.setMouseCursor(cursor);
     }
+    hovered_menu_option = nullptr;
+    setThumbnail(-1);
+}
 
-    std::string pattern_str; // We extract pattern's width and height from the first line.
-    getline(rle_file, pattern_str); // We only save live cells, so we don't care about first line (pattern's width and height).
-    getline(rle_file, pattern_str, '!');
+// Takes the catalog's entries, if it has published new ones since the menu was built. Returns whether it did.
+// The hover must be reset before (see 'resetHover()').
+bool PatternMenuScreen::updateMenuOptions(){
+    unsigned int version = catalog.getVersion();
+    if (version == catalog_version) return false;
+
+    catalog_version = version;
+    catalog_entries = catalog.getEntries();
+    buildEntryNames();
+    setSearch(search); // The same search, in the new entries
+    return true;
+}
 
-    int curr_x = 0, curr_y = 0;
-    std::string curr_num_str;
+// Until the catalog is first built (when there's no index file yet), we let the user know that more patterns are coming.
+// Returns whether the title changed (so it has to be drawn again).
+bool PatternMenuScreen::setTitle(){
+    std::string title = "Pattern Menu";
+    if (!search.empty()) title += " (search: " + search + "_)";
+    else if (catalog_entries.empty() && catalog.isRebuilding()) title += " (indexing, " + std::to_string(catalog.filesChecked()) + " files...)";
+    if (title == (std::string)menu_title.getString()) return false;
+
+    menu_title.setString(title);
+    centerText(menu_title, 0);
+    return true;
+}
 
-    for (auto c : pattern_str){
-        if ('0' <= c && c <= '9'){
-            curr_num_str.push_back(c);
-        }
-        else if (c == 'o'){
-            int curr_num = curr_num_str.empty() ? 1 : std::stoi(curr_num_str);
-            for (int i = 0; i < curr_num; i++){
-                chosen_pattern.insert({curr_x + i, curr_y});
-            }
-            curr_x += curr_num;
-            curr_num_str.clear();
-        }
-        else if (c == 'b'){
-            curr_x += curr_num_str.empty() ? 1 : std::stoi(curr_num_str);
-            curr_num_str.clear();
-        }
-        else if (c == '$'){
-            // A number before '$' implies multiple newlines.
-            int curr_num = curr_num_str.empty() ? 1 : std::stoi(curr_num_str);
-            curr_y += curr_num;
-            curr_num_str.clear();
-            curr_x = 0;
-        }
-        else if (!isspace(c)){ // if 'c' is none of the above and not a whitespace, then file formatting is erroneous.
-            std::cerr << "bad RLE file, terminating..." << std::endl;
-            exit(-1);
+// Puts the thumbnail of the given menu option to the right of it (or hides the thumbnail, if the option has none).
+void PatternMenuScreen::setThumbnail(int option_index){
+    if (option_index == thumbnail_option_index) return;
+    thumbnail_option_index = option_index;
+    thumbnail_quads.clear();
+
+    const PatternMenuRow* row = option_index < 0 ? nullptr : &rows[first_option_row + option_index];
+    if (!row || row->type != PATTERN_ROW || !catalog_entries[row->entry_index].is_valid){
+        thumbnail_option_index = -1;
+        return;
+    }
+
+    const float size = CATALOG_THUMBNAIL_SIZE * THUMBNAIL_PIXEL_SIZE;
+    sf::FloatRect option_bounds = menu_options[option_index].getGlobalBounds();
+    float left = std::min(option_bounds.left + option_bounds.width + 2 * DISTANCE, window.getSize().x - size - DISTANCE);
+    float top = menu_title_rectangle_height + (first_option_row + option_index) * menu_option_rectangle_height;
+    thumbnail_frame.setPosition(left, top);
+
+    const CatalogEntry& entry = catalog_entries[row->entry_index];
+    for (int y = 0; y < CATALOG_THUMBNAIL_SIZE; y++){
+        for (int x = 0; x < CATALOG_THUMBNAIL_SIZE; x++){
+            if (!(entry.thumbnail[y] >> x & 1)) continue;
+
+            float pixel_left = left + x * THUMBNAIL_PIXEL_SIZE, pixel_top = top + y * THUMBNAIL_PIXEL_SIZE;
+            thumbnail_quads.append(sf::Vertex(sf::Vector2f(pixel_left, pixel_top), sf::Color::White));
+            thumbnail_quads.append(sf::Vertex(sf::Vector2f(pixel_left + THUMBNAIL_PIXEL_SIZE, pixel_top), sf::Color::White));
+            thumbnail_quads.append(sf::Vertex(sf::Vector2f(pixel_left + THUMBNAIL_PIXEL_SIZE, pixel_top + THUMBNAIL_PIXEL_SIZE), sf::Color::White));
+            thumbnail_quads.append(sf::Vertex(sf::Vector2f(pixel_left, pixel_top + THUMBNAIL_PIXEL_SIZE), sf::Color::White));
         }
     }
+}
+
+void PatternMenuScreen::drawThumbnail() const{
+    if (thumbnail_option_index < 0) return;
+
+    window.draw(thumbnail_frame);
+    window.draw(thumbnail_quads);
+}
+
+PatternMenuScreen::PatternMenuScreen():
+catalog("patterns", PATTERN_CATALOG_PATH), catalog_version(0), is_name_index_built(false), is_loading(false), loading_text("", font, OPTION_CHARACTER_SIZE),
+thumbnail_quads(sf::PrimitiveType::Quads), thumbnail_option_index(-1) {
+    // If 'patterns' directory doesn't exist, it creates it; otherwise, it does nothing.
+    // We don't walk the directory here - the catalog loads its index and checks it against the files on a thread of its own,
+    // which starts now (while the automaton menu is shown), so the startup doesn't depend on how many patterns there are.
+    // Until the catalog publishes its entries (see 'updateMenuOptions()'), the menu has only the custom pattern.
+    // Whatever the number of patterns, only the rows in the view are made into texts, once they're shown (see 'setVisibleOptions()').
+    std::filesystem::create_directories("patterns");
+    catalog.startRebuild();
+    buildRows();
+
+    menu_title.setString("Pattern Menu");
 
-    rle_file.close();
+    thumbnail_frame.setSize(sf::Vector2f(CATALOG_THUMBNAIL_SIZE * THUMBNAIL_PIXEL_SIZE, CATALOG_THUMBNAIL_SIZE * THUMBNAIL_PIXEL_SIZE));
+    thumbnail_frame.setFillColor(sf::Color(40, 40, 40));
+    thumbnail_frame.setOutlineColor(important_color);
+    thumbnail_frame.setOutlineThickness(1);
+
+    progress_bar_frame.setFillColor(sf::Color(40, 40, 40));
+    progress_bar_frame.setOutlineColor(important_color);
+    progress_bar_frame.setOutlineThickness(2);
+    progress_bar_fill.setFillColor(important_color);
+    loading_text.setFillColor(important_color);
 }
 
-// Takes the pattern from the .rle file specified in 'chosen_file_path', and put in center of grid.
-void PatternMenuScreen::putPatternInGrid(){
-    /* We can't put the pattern in 'grid' and then modify the elements, since unordered_set's elements are const (if they change, the hash changes).
-    And we can't settle for erasing and insert when iterating over 'grid', since doing that will invalidate the iterators.
-    Sadly, we must create a temp and then copy its modified elements to 'grid'. */
-    RLEToGrid();
+// Lets the user know if the file was made for another rule than the one we run.
+void PatternMenuScreen::noteFileRule(const std::string& file_rulestring){
+    Rule file_rule;
+    if (!file_rulestring.empty() && parseRulestring(file_rulestring, file_rule) &&
+        (file_rule.getBornMask() != rule.getBornMask() || file_rule.getSurviveMask() != rule.getSurviveMask())){
+        std::cout << "Note: this pattern was made for the rule " << file_rulestring << std::endl;
+    }
+}
 
+// Starts loading the pattern in 'chosen_file_path' into the center of the grid. 'handleLoading()' takes it from here.
+void PatternMenuScreen::startLoading(){
     int cells_count_x = grid_width / CELL_SIZE, cells_count_y = grid_height / CELL_SIZE;
-    sf::Vector2i center_of_mass = centerOfMass();
+    pattern_loader.start(chosen_file_path, *grid, cells_count_x / 2, cells_count_y / 2);
+    is_loading = true;
+
+    loading_text.setString("Loading " + std::filesystem::path(chosen_file_path).filename().string() + "... (Esc to cancel)");
+    truncateFileNameIfTooLong(loading_text);
+    setProgressBar();
+}
+
+// The bar is in the middle of the window, wherever the menu is scrolled to, and the text is right above it.
+void PatternMenuScreen::setProgressBar(){
+    float width = window.getSize().x * PROGRESS_BAR_WIDTH_FRACTION;
+    float left = (window.getSize().x - width) / 2, top = left_top_view_pos.y + window.getSize().y / 2 - PROGRESS_BAR_HEIGHT / 2;
+
+    progress_bar_frame.setSize(sf::Vector2f(width, PROGRESS_BAR_HEIGHT));
+    progress_bar_frame.setPosition(left, top);
+    progress_bar_fill.setSize(sf::Vector2f(width * pattern_loader.progress(), PROGRESS_BAR_HEIGHT));
+    progress_bar_fill.setPosition(left, top);
+
+    centerText(loading_text, top - menu_option_rectangle_height - DISTANCE);
+}
+
+void PatternMenuScreen::drawProgressBar() const{
+    window.draw(progress_bar_frame);
+    window.draw(progress_bar_fill);
+    window.draw(loading_text);
+}
+
+// Once the loader is done: on to the game if the pattern is in 'grid', or back to the menu if the load was cancelled.
+short int PatternMenuScreen::finishLoading(){
+    pattern_load_status status = pattern_loader.wait();
+    is_loading = false;
+
+    switch (status){
+        case PATTERN_LOAD_OK:
+            noteFileRule(pattern_loader.getFileRule());
+
+            // Setting so that the exact center of the grid is in the center of the window
+            left_top_view_pos = sf::Vector2f(grid_width / 2 - window.getSize().x / 2, grid_height / 2 - window.getSize().y / 2);
+            setInitialView();
+            return GAME_SCREEN;
+
+        case PATTERN_LOAD_CANCELLED:
+            grid->clear(); // Of the part that made it in
+            frame_scheduler.requestRedraw(); // The menu, without the progress bar
+            return PATTERN_MENU_SCREEN;
+
+        case PATTERN_LOAD_FILE_ERROR:
+            std::cerr << "File has been deleted or moved since the patterns were indexed" << std::endl;
+            exit(-1);
+
+        case PATTERN_LOAD_FORMAT_ERROR:
+            std::cerr << "bad pattern file, terminating..." << std::endl;
+            exit(-1);
+
+        case PATTERN_LOAD_TOO_BIG:
+            std::cerr << "the pattern is too big, terminating..." << std::endl;
+            exit(-1);
+    }
 
-    for (const auto& cell : chosen_pattern){
-        // We shift the pattern to the grid's center, and shift it to account for its center of mass.
-        int x = cell.x + cells_count_x / 2 - center_of_mass.x;
-        int y = cell.y + cells_count_y / 2 - center_of_mass.y;
+    return PATTERN_MENU_SCREEN;
+}
 
-        grid.insert({x, y});
+/* A frame of the menu while a pattern is loading: the only keys are Esc (which cancels the load) and closing the window,
+so the window keeps responding no matter how big the pattern is. Returns the next screen, or 'PATTERN_MENU_SCREEN' to stay. */
+short int PatternMenuScreen::handleLoading(){
+    sf::Event evnt;
+    while (frame_scheduler.pollEvent(window, evnt)){
+        switch (evnt.type){
+            case sf::Event::Closed:
+                pattern_loader.cancel();
+                pattern_loader.wait();
+                return -1;
+
+            case sf::Event::KeyPressed:
+                if (evnt.key.code == sf::Keyboard::Escape) pattern_loader.cancel();
+                break;
+
+            case sf::Event::Resized:
+                resize(evnt, menu_screen_total_height);
+                centerText(menu_title, 0);
+                setVisibleOptions(true); // They're truncated by the window's width
+                break;
+        }
     }
+
+    if (pattern_loader.isDone()) return finishLoading();
+
+    // The bar is drawn again only once it has grown by a pixel
+    float fill_width = progress_bar_fill.getSize().x;
+    setProgressBar();
+    if (progress_bar_fill.getSize().x != fill_width) frame_scheduler.requestRedraw();
+    if (!frame_scheduler.startFrame()) return PATTERN_MENU_SCREEN;
+
+    window.clear();
+    drawText();
+    window.draw(menu_title);
+    drawProgressBar();
+    window.display();
+
+    return PATTERN_MENU_SCREEN;
 }
 
 short int PatternMenuScreen::run(){
-    chosen_pattern.clear();
     left_top_view_pos = sf::Vector2f(0.f,0.f);
     setInitialView();
-    setText();
+
+    // Files may have been added (like a pattern we've just saved) or changed since the last rebuild, so we check them again.
+    // Only those are parsed, and until it's done, we show what the catalog already has.
+    catalog.startRebuild();
+    // We make the texts again at the start of each 'run()', to adjust if there was a resize in another screen
+    if (!updateMenuOptions()) setVisibleOptions(true);
+    centerText(menu_title, 0);
+    setTitle();
     setArrows();
+    setThumbnail(-1);
+    frame_scheduler.requestRedraw(); // The screen before us drew something else
 
     bool hovering = false;
     int rectangle_index;
     sf::IntRect hovered_rectangle_bounds;
-    sf::Text* hovered_menu_option = &menu_options[0];
+    sf::Text* hovered_menu_option = nullptr;
+    bool is_hover_stale = true;
 
     while (true) {
-        handleHover(hovering, rectangle_index, &menu_options_pattern_paths, hovered_menu_option, hovered_rectangle_bounds);
+        if (is_loading){
+            short int next_screen = handleLoading();
+            if (next_screen != PATTERN_MENU_SCREEN) return next_screen;
+            is_hover_stale = true; // The mouse might have moved during the load, which doesn't look at it
+            continue;
+        }
+
+        if (catalog.getVersion() != catalog_version){
+            resetHover(hovering, hovered_menu_option); // The options are made anew
+            updateMenuOptions();
+            frame_scheduler.requestRedraw();
+            is_hover_stale = true;
+        }
+        else if (catalog_entries.empty() && setTitle()) frame_scheduler.requestRedraw(); // To show how far the indexing has gone
 
         sf::Event evnt;
-        while (window.pollEvent(evnt)){
+        while (frame_scheduler.pollEvent(window, evnt)){
+            is_hover_stale = true;
             switch (evnt.type){
                 case sf::Event::Closed:
                     return -1;
 
                 case sf::Event::KeyPressed:
                     if (evnt.key.code == sf::Keyboard::Escape){
-                        // When we escape, if we hover, we want to un-hover. If we don't hover, this essentially does nothing
-                        hovered_menu_option->setFillColor(option_not_chosen_color);
-                        cursor.loadFromSystem(sf::Cursor::Arrow);
-                        window.setMouseCursor(cursor);
+                        // When we escape, if we hover, we want to un-hover
+                        resetHover(hovering, hovered_menu_option);
 
-                        return AUTOMATON_MENU_SCREEN;
+                        if (!search.empty()) setSearch(""); // Esc takes back the search first, and only then the menu
+                        else return AUTOMATON_MENU_SCREEN;
                     }
                     break;
 
+                // Typing searches the patterns by the words of their names, and Backspace takes back the last letter
+                case sf::Event::TextEntered:
+                    if (evnt.text.unicode == 8 && !search.empty()){
+                        resetHover(hovering, hovered_menu_option);
+                        setSearch(search.substr(0, search.size() - 1));
+                    }
+                    else if (' ' <= evnt.text.unicode && evnt.text.unicode <= '~'){
+                        resetHover(hovering, hovered_menu_option);
+                        setSearch(search + (char)std::tolower((int)evnt.text.unicode));
+                    }
+                    break;
+
+                // Under the mouse there's another row now (which might not even have its text yet)
                 case sf::Event::MouseWheelScrolled:{
+                    resetHover(hovering, hovered_menu_option);
                     handleScroll(evnt.mouseWheelScroll.delta);
+                    setVisibleOptions(false);
                     break;
                 }
 
@@ -188,33 +471,45 @@ short int PatternMenuScreen::run(){
                     cursor.loadFromSystem(sf::Cursor::Arrow);
                     window.setMouseCursor(cursor);
 
-                    std::string pattern_name = textToString(hovered_menu_option);
-                    chosen_file_path = menu_options_pattern_paths[rectangle_index] + "\\" + pattern_name + ".rle";
+                    chosen_file_path = menu_options_pattern_paths[rectangle_index];
 
                     hovered_menu_option->setFillColor(option_not_chosen_color);
+                    hovering = false;
+                    setThumbnail(-1);
+
+                    if (rows[first_option_row + rectangle_index].type != CUSTOM_PATTERN_ROW){
+                        startLoading(); // We stay in the menu until it's loaded
+                        break;
+                    }
 
                     // Setting so that the exact center of the grid is in the center of the window
                     left_top_view_pos = sf::Vector2f(grid_width / 2 - window.getSize().x / 2, grid_height / 2 - window.getSize().y / 2);
                     setInitialView();
-
-                    if (rectangle_index != 0){ // Not custom pattern
-                        putPatternInGrid();
-                        return GAME_SCREEN;
-                    }
-                    else return PATTERN_INPUT_SCREEN;
+                    return PATTERN_INPUT_SCREEN;
                 }
 
                 case sf::Event::Resized:
+                    resetHover(hovering, hovered_menu_option);
                     resize(evnt, menu_screen_total_height);
-                    setText();
+                    centerText(menu_title, 0);
+                    setVisibleOptions(true); // They're truncated by the window's width, and there might be more rows in the view
                     arrow_down_sprite.setPosition(0, left_top_view_pos.y + window.getSize().y - arrow_down_sprite.getGlobalBounds().height);
                     break;
             }
         }
 
+        // The hover (and its thumbnail) can only change after an event: the mouse moved, or we scrolled under it, or the options were made anew
+        if (is_hover_stale){
+            is_hover_stale = false;
+            if (handleHover(hovering, rectangle_index, &menu_options_pattern_paths, hovered_menu_option, hovered_rectangle_bounds)) frame_scheduler.requestRedraw();
+            setThumbnail(hovering ? rectangle_index : -1); // Also after a 'resetHover()', which is always along with a redraw
+        }
+        if (!frame_scheduler.startFrame()) continue;
+
         window.clear();
 
         drawText();
+        drawThumbnail();
         window.draw(menu_title);
         drawArrows();
 
@@ -2,19 +2,75 @@
 #define GAME_OF_LIFE_PATTERN_MENU_SCREEN_H
 
 #include "screens.h"
+#include "pattern_catalog.h"
+#include "pattern_loader.h"
+#include "pattern_name_index.h"
+
+#define PATTERN_CATALOG_PATH "patterns/catalog.idx"
+#define THUMBNAIL_PIXEL_SIZE 4 // A thumbnail pixel is drawn as a square of this many screen pixels
+#define PROGRESS_BAR_WIDTH_FRACTION 0.6 // Of the window's width
+#define PROGRESS_BAR_HEIGHT 20
+#define OPTIONS_MARGIN_ROWS 10 // The rows that have a text in 'menu_options' are the ones in the view, and this many more above and below it
+
+enum pattern_menu_row_type {CUSTOM_PATTERN_ROW, DIRECTORY_ROW, PATTERN_ROW};
+
+// A row of the menu. It's only made into a text once it's near the view (see 'PatternMenuScreen::setVisibleOptions()').
+struct PatternMenuRow{
+    pattern_menu_row_type type;
+    int entry_index; // In 'catalog_entries'. For a directory, of its first pattern.
+};
 
 class PatternMenuScreen: public MenuScreen{
 private:
-    // Saves *parent* path of pattern files, so with 'menu_options' we can get the full file path
+    // The pattern files are known from the catalog, which is loaded and rebuilt in the background
+    PatternCatalog catalog;
+    unsigned int catalog_version; // Of the entries the menu was last built from
+    std::vector<CatalogEntry> catalog_entries;
+    std::vector<std::string> entry_names; // Of every entry, as the menu shows it
+    std::vector<int> entry_directories; // Of every entry, its index in 'directory_names'
+    std::vector<std::string> directory_names;
+
+    /* Typing filters the menu down to the patterns that have a word starting with what was typed (see 'PatternNameIndex').
+    The index is built only once there's something to search, so a big catalog doesn't slow down the menu's startup. */
+    PatternNameIndex name_index;
+    bool is_name_index_built;
+    std::string search; // In lowercase
+    PatternNameIndex::Range search_range;
+
+    // All the rows of the menu (of the patterns that match the search), but the texts are made only for the ones around the view
+    std::vector<PatternMenuRow> rows;
+    // Saves the path of the pattern file of every item in 'menu_options' (or "" for the directory names)
     std::vector <std::string> menu_options_pattern_paths;
     std::string chosen_file_path;
-    std::unordered_set<sf::Vector2i, pair_hash, pair_equal> chosen_pattern;
+
+    // The chosen pattern is loaded into 'grid' in the background, while we keep handling events and show the progress
+    PatternLoader pattern_loader;
+    bool is_loading;
+    sf::Text loading_text;
+    sf::RectangleShape progress_bar_frame, progress_bar_fill;
+
+    sf::RectangleShape thumbnail_frame;
+    sf::VertexArray thumbnail_quads;
+    int thumbnail_option_index; // The menu option whose thumbnail is in 'thumbnail_quads', or -1 if none
 
     static void truncateFileNameIfTooLong(sf::Text& text);
-    void iterateOverPatternDirectory();
-    sf::Vector2i centerOfMass() const;
-    void RLEToGrid();
-    void putPatternInGrid();
+    static std::string describeEntry(const CatalogEntry& entry);
+    void buildEntryNames();
+    void buildRows();
+    void setOption(int option_index);
+    bool setVisibleOptions(bool rebuild);
+    void setSearch(const std::string& new_search);
+    void resetHover(bool& hovering, sf::Text*& hovered_menu_option);
+    bool updateMenuOptions();
+    bool setTitle();
+    void setThumbnail(int option_index);
+    void drawThumbnail() const;
+    static void noteFileRule(const std::string& file_rulestring);
+    void startLoading();
+    void setProgressBar();
+    void drawProgressBar() const;
+    short int finishLoading();
+    short int handleLoading();
 
 public:
     PatternMenuScreen();
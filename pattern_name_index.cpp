@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cctype>
+#include "pattern_name_index.h"
+
+std::string PatternNameIndex::toLower(const std::string& str){
+    std::string lower = str;
+    for (auto& c : lower) c = std::tolower((unsigned char)c);
+    return lower;
+}
+
+bool PatternNameIndex::startsWith(const std::pair<int, int>& word_start, const std::string& prefix) const{
+    return names[word_start.first].compare(word_start.second, prefix.size(), prefix) == 0;
+}
+
+void PatternNameIndex::build(const std::vector<std::string>& new_names){
+    names.clear();
+    word_starts.clear();
+
+    for (size_t i = 0; i < new_names.size(); i++){
+        names.push_back(toLower(new_names[i]));
+        const std::string& name = names.back();
+        // The start of the name is always a word start, so a name that starts with a symbol can still be found by it
+        for (size_t j = 0; j < name.size(); j++){
+            if (j == 0 || (std::isalnum((unsigned char)name[j]) && !std::isalnum((unsigned char)name[j - 1]))) word_starts.emplace_back((int)i, (int)j);
+        }
+    }
+
+    std::sort(word_starts.begin(), word_starts.end(), [this](const std::pair<int, int>& a, const std::pair<int, int>& b){
+        int order = names[a.first].compare(a.second, std::string::npos, names[b.first], b.second, std::string::npos);
+        return order != 0 ? order < 0 : a < b;
+    });
+}
+
+PatternNameIndex::Range PatternNameIndex::all() const{
+    return {0, word_starts.size()};
+}
+
+PatternNameIndex::Range PatternNameIndex::narrow(const Range& within, const std::string& prefix) const{
+    auto begin = word_starts.begin() + within.first, end = word_starts.begin() + within.second;
+
+    // The ones before the prefix, then the ones that start with it, then the ones after it
+    auto first = std::partition_point(begin, end, [this, &prefix](const std::pair<int, int>& word_start){
+        return names[word_start.first].compare(word_start.second, std::string::npos, prefix) < 0;
+    });
+    auto last = std::partition_point(first, end, [this, &prefix](const std::pair<int, int>& word_start){ return startsWith(word_start, prefix); });
+
+    return {first - word_starts.begin(), last - word_starts.begin()};
+}
+
+std::vector<int> PatternNameIndex::namesIn(const Range& range) const{
+    std::vector<int> found;
+    found.reserve(range.second - range.first);
+    for (size_t i = range.first; i < range.second; i++) found.push_back(word_starts[i].first);
+
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return found;
+}
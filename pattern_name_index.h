@@ -0,0 +1,35 @@
+#ifndef GAME_OF_LIFE_PATTERN_NAME_INDEX_H
+#define GAME_OF_LIFE_PATTERN_NAME_INDEX_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Finds the names that have a word starting with a given prefix (case-insensitive), like "gun" in "Gosper glider gun", for the pattern menu's search.
+A word starts at the start of the name, or at a letter or a digit that follows anything else.
+
+Every word start is kept with the rest of its name, and they're sorted by that - so the ones that start with a prefix are all in a single range,
+which two binary searches find. A longer prefix is in a sub-range of a shorter one, so typing one more letter searches only what the last one found. */
+class PatternNameIndex{
+private:
+    std::vector<std::string> names; // In lowercase
+    std::vector<std::pair<int, int>> word_starts; // (name, position of the word in it), sorted by the rest of the name from there
+
+    bool startsWith(const std::pair<int, int>& word_start, const std::string& prefix) const;
+
+public:
+    // A range of the sorted word starts
+    typedef std::pair<size_t, size_t> Range;
+
+    // Indexes the given names, which are then known by their position in 'new_names'. Costs O(n log n) in the number of words.
+    void build(const std::vector<std::string>& new_names);
+    Range all() const;
+    // The word starts in 'within' that start with 'prefix' (lowercase). 'within' must be of a prefix of it (or 'all()').
+    Range narrow(const Range& within, const std::string& prefix) const;
+    // The names that the word starts in 'range' belong to, sorted and each one once.
+    std::vector<int> namesIn(const Range& range) const;
+
+    static std::string toLower(const std::string& str);
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include "profiler.h"
+#include "allocation_counter.h"
+#include "bit_utils.h"
+
+ProfilePhase::ProfilePhase(const std::string& name): count(0), total_ns(0), max_ns(0), allocations(0), name(name) {
+    for (auto& bucket : buckets) bucket = 0;
+}
+
+// Values below 16 get a bucket each. Above that, a value with its highest bit at 'e' goes to one of the 8 buckets of 'e',
+// by the 3 bits under the highest one.
+int ProfilePhase::bucketIndex(unsigned long long int ns){
+    if (ns < 16) return ns;
+
+    int exponent = 63 - countLeadingZeros64(ns);
+    return 16 + (exponent - 4) * 8 + (ns >> (exponent - 3) & 7);
+}
+
+unsigned long long int ProfilePhase::bucketUpperBound(int index){
+    if (index < 16) return index;
+
+    int exponent = (index - 16) / 8 + 4, sub_bucket = (index - 16) % 8;
+    return ((8ULL + sub_bucket + 1) << (exponent - 3)) - 1;
+}
+
+void ProfilePhase::record(unsigned long long int ns, unsigned long long int allocation_amount){
+    buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+    allocations.fetch_add(allocation_amount, std::memory_order_relaxed);
+
+    unsigned long long int curr_max = max_ns.load(std::memory_order_relaxed);
+    while (curr_max < ns && !max_ns.compare_exchange_weak(curr_max, ns, std::memory_order_relaxed));
+}
+
+unsigned long long int ProfilePhase::getCount() const{
+    return count;
+}
+
+unsigned long long int ProfilePhase::getTotalNs() const{
+    return total_ns;
+}
+
+unsigned long long int ProfilePhase::getMaxNs() const{
+    return max_ns;
+}
+
+unsigned long long int ProfilePhase::getAllocations() const{
+    return allocations;
+}
+
+// Returns the upper bound of the bucket the percentile falls in ('percentile' is in [0, 1]).
+unsigned long long int ProfilePhase::percentileNs(double percentile) const{
+    unsigned long long int target = percentile * count, seen = 0;
+    for (int i = 0; i < PROFILE_BUCKETS; i++){
+        seen += buckets[i];
+        if (target < seen) return std::min(bucketUpperBound(i), getMaxNs());
+    }
+
+    return getMaxNs();
+}
+
+Profiler::Profiler(): trace_next(0), start_time(std::chrono::steady_clock::now()) { }
+
+Profiler::~Profiler(){
+    exportAll();
+}
+
+// Constructed on first use, so it exists before any call site registers a phase (and is destroyed after them).
+Profiler& Profiler::instance(){
+    static Profiler profiler;
+    return profiler;
+}
+
+ProfilePhase& Profiler::phase(const std::string& name){
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& phase : phases){
+        if (phase->name == name) return *phase;
+    }
+
+    phases.push_back(std::make_unique<ProfilePhase>(name));
+    return *phases.back();
+}
+
+void Profiler::addTraceEvent(const ProfilePhase& phase, std::chrono::steady_clock::time_point start, long long int duration_ns){
+    // Small ids for the threads, in order of appearance, so the trace viewer shows them in a sensible order.
+    static std::atomic<int> thread_amount(0);
+    thread_local int thread = thread_amount++;
+
+    TraceEvent event = {&phase, std::chrono::duration_cast<std::chrono::nanoseconds>(start - start_time).count(), duration_ns, thread};
+    std::lock_guard<std::mutex> lock(mutex);
+    if (trace.size() < PROFILE_MAX_TRACE_EVENTS) trace.push_back(event);
+    else trace[trace_next] = event;
+    trace_next = (trace_next + 1) % PROFILE_MAX_TRACE_EVENTS;
+}
+
+std::string jsonString(const std::string& str){
+    std::string escaped = "\"";
+    for (char c : str){
+        if (c == '"' || c == '\\') escaped += '\\';
+        if ((unsigned char)c < 0x20){ // A control character can't be written as is
+            char code[7];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else escaped += c;
+    }
+
+    return escaped + "\"";
+}
+
+void Profiler::exportAll(){
+    std::lock_guard<std::mutex> lock(mutex);
+    const char* env = std::getenv("GOL_PROFILE_OUTPUT");
+    std::string prefix = env ? env : "gol_profile";
+
+    // The times are written with 3 decimals, so nothing under the unit's thousandth (a nanosecond, at most) is cut off or written in scientific notation
+    std::ofstream csv(prefix + ".csv");
+    csv << std::fixed << std::setprecision(3);
+    csv << "phase,count,total_ms,p50_us,p99_us,max_us,allocations" << std::endl;
+    std::ofstream json(prefix + ".json");
+    json << std::fixed << std::setprecision(3);
+    json << "[";
+
+    for (size_t i = 0; i < phases.size(); i++){
+        const ProfilePhase& phase = *phases[i];
+        double total_ms = phase.getTotalNs() / 1e6, p50_us = phase.percentileNs(0.5) / 1e3, p99_us = phase.percentileNs(0.99) / 1e3;
+        double max_us = phase.getMaxNs() / 1e3;
+
+        csv << phase.name << "," << phase.getCount() << "," << total_ms << "," << p50_us << "," << p99_us << "," << max_us << ","
+            << phase.getAllocations() << std::endl;
+        json << (i ? "," : "") << std::endl << "  {\"phase\": " << jsonString(phase.name) << ", \"count\": " << phase.getCount()
+             << ", \"total_ms\": " << total_ms << ", \"p50_us\": " << p50_us << ", \"p99_us\": " << p99_us << ", \"max_us\": " << max_us
+             << ", \"allocations\": " << phase.getAllocations() << "}";
+    }
+    json << std::endl << "]" << std::endl;
+
+    // The trace-event format: "X" is a complete event (with a duration), and the times are in microseconds.
+    std::ofstream trace_file(prefix + ".trace.json");
+    trace_file << std::fixed << std::setprecision(3);
+    trace_file << "{\"traceEvents\": [";
+    size_t first = trace.size() < PROFILE_MAX_TRACE_EVENTS ? 0 : trace_next; // The oldest event in the ring buffer
+    for (size_t i = 0; i < trace.size(); i++){
+        const TraceEvent& event = trace[(first + i) % trace.size()];
+        trace_file << (i ? "," : "") << std::endl << "{\"name\": " << jsonString(event.phase->name) << ", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+                   << event.thread << ", \"ts\": " << event.start_ns / 1e3 << ", \"dur\": " << event.duration_ns / 1e3 << "}";
+    }
+    trace_file << std::endl << "]}" << std::endl;
+}
+
+ScopedTimer::ScopedTimer(ProfilePhase& phase): phase(phase), start(std::chrono::steady_clock::now()), start_allocations(allocationCount()) { }
+
+ScopedTimer::~ScopedTimer(){
+    long long int duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    phase.record(duration_ns, allocationCount() - start_allocations);
+    Profiler::instance().addTraceEvent(phase, start, duration_ns);
+}
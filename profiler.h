@@ -0,0 +1,95 @@
+#ifndef GAME_OF_LIFE_PROFILER_H
+#define GAME_OF_LIFE_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILE_BUCKETS 496 // See 'ProfilePhase::bucketIndex()'
+#define PROFILE_MAX_TRACE_EVENTS (1 << 20) // The trace keeps only the latest events, so a long run doesn't eat all the memory
+
+/* Scoped timers for the hot paths. Put 'PROFILE_SCOPE("name");' at the top of a scope, and the time until the end of the scope
+(with nanosecond resolution) is added to the latency histogram of that phase, along with the heap allocations made meanwhile (by any thread).
+At exit, the phases are written as a summary (p50, p99, max, allocations) in CSV and JSON, and the latest events as a Chrome trace
+(open it in chrome://tracing or in Perfetto), to see where the frame time spikes come from.
+The output files are 'gol_profile.csv', 'gol_profile.json' and 'gol_profile.trace.json', or with the prefix in the GOL_PROFILE_OUTPUT environment variable.
+
+It's all compiled out unless we build with the GOL_PROFILE CMake option, so normally 'PROFILE_SCOPE' costs nothing. */
+
+#ifdef GOL_PROFILE
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// The phase is looked up once per call site (it's a static), so a timer costs 2 clock reads and a few atomic additions.
+#define PROFILE_SCOPE(name) \
+    static ProfilePhase& PROFILE_CONCAT(profile_phase_, __LINE__) = Profiler::instance().phase(name); \
+    ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(PROFILE_CONCAT(profile_phase_, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+/* The latency histogram of a phase. The buckets are logarithmic with 8 sub-buckets per power of 2 (like HdrHistogram),
+so a percentile is accurate up to 12.5%, whether the phase takes 100ns or 10s. It's updated with atomics, so any thread may time a phase. */
+class ProfilePhase{
+private:
+    std::atomic<unsigned long long int> buckets[PROFILE_BUCKETS];
+    std::atomic<unsigned long long int> count, total_ns, max_ns, allocations;
+
+    static int bucketIndex(unsigned long long int ns);
+    static unsigned long long int bucketUpperBound(int index);
+
+public:
+    const std::string name;
+
+    explicit ProfilePhase(const std::string& name);
+    void record(unsigned long long int ns, unsigned long long int allocation_amount);
+
+    unsigned long long int getCount() const;
+    unsigned long long int getTotalNs() const;
+    unsigned long long int getMaxNs() const;
+    unsigned long long int getAllocations() const;
+    unsigned long long int percentileNs(double percentile) const;
+};
+
+class Profiler{
+private:
+    struct TraceEvent{
+        const ProfilePhase* phase;
+        long long int start_ns, duration_ns;
+        int thread;
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfilePhase>> phases; // Owned here (and not by the call sites), since they must outlive everything until the export
+    std::vector<TraceEvent> trace; // A ring buffer
+    size_t trace_next;
+    const std::chrono::steady_clock::time_point start_time;
+
+    Profiler();
+    void exportAll();
+
+public:
+    ~Profiler(); // Writes the output files
+    static Profiler& instance();
+
+    ProfilePhase& phase(const std::string& name);
+    void addTraceEvent(const ProfilePhase& phase, std::chrono::steady_clock::time_point start, long long int duration_ns);
+};
+
+// The string in double quotes, escaped for JSON (for the output files here, and for the headless tools' output).
+std::string jsonString(const std::string& str);
+
+class ScopedTimer{
+private:
+    ProfilePhase& phase;
+    const std::chrono::steady_clock::time_point start;
+    const unsigned long long int start_allocations;
+
+public:
+    explicit ScopedTimer(ProfilePhase& phase);
+    ~ScopedTimer();
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <climits>
+#include "quadtree.h"
+#include "bit_utils.h"
+
+Quadtree::Quadtree(): nodes(1, {0, 0, 0, 0, 0, 0}), root(0) { }
+
+int Quadtree::level() const{
+    return root == 0 ? QUADTREE_LEAF_LEVEL : nodes[root].level;
+}
+
+QuadtreeBuilder::QuadtreeBuilder(Quadtree& tree): tree(tree) {
+    tree = Quadtree();
+}
+
+uint32_t QuadtreeBuilder::makeLeaf(uint64_t cells){
+    if (cells == 0) return 0;
+
+    auto iter = leaves.find(cells);
+    if (iter != leaves.end()) return iter->second;
+
+    tree.nodes.push_back({QUADTREE_LEAF_LEVEL, 0, 0, 0, 0, cells});
+    leaves.emplace(cells, tree.nodes.size() - 1);
+    return tree.nodes.size() - 1;
+}
+
+uint32_t QuadtreeBuilder::makeNode(int level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se){
+    if (nw == 0 && ne == 0 && sw == 0 && se == 0) return 0;
+
+    NodeKey key = {nw, ne, sw, se};
+    auto iter = inner_nodes.find(key);
+    if (iter != inner_nodes.end()) return iter->second;
+
+    tree.nodes.push_back({level, nw, ne, sw, se, 0});
+    inner_nodes.emplace(key, tree.nodes.size() - 1);
+    return tree.nodes.size() - 1;
+}
+
+// Like 'HashLifeEngine::buildNode()': the cells are partitioned quadrant by quadrant, so every node is made once.
+static uint32_t buildNode(QuadtreeBuilder& builder, Cell* begin, Cell* end, int level, long long int left, long long int top){
+    if (begin == end) return 0;
+    if (level == QUADTREE_LEAF_LEVEL){
+        uint64_t cells = 0;
+        for (Cell* cell = begin; cell != end; cell++) cells |= 1ULL << (8 * (cell->y - top) + (cell->x - left));
+        return builder.makeLeaf(cells);
+    }
+
+    long long int half = 1LL << (level - 1);
+    Cell* south = std::partition(begin, end, [top, half](const Cell& cell){ return cell.y < top + half; });
+    Cell* north_east = std::partition(begin, south, [left, half](const Cell& cell){ return cell.x < left + half; });
+    Cell* south_east = std::partition(south, end, [left, half](const Cell& cell){ return cell.x < left + half; });
+
+    uint32_t nw = buildNode(builder, begin, north_east, level - 1, left, top);
+    uint32_t ne = buildNode(builder, north_east, south, level - 1, left + half, top);
+    uint32_t sw = buildNode(builder, south, south_east, level - 1, left, top + half);
+    uint32_t se = buildNode(builder, south_east, end, level - 1, left + half, top + half);
+    return builder.makeNode(level, nw, ne, sw, se);
+}
+
+void quadtreeFromCells(std::vector<Cell>& cells, Quadtree& tree){
+    QuadtreeBuilder builder(tree);
+    if (cells.empty()) return;
+
+    BoundingBox box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    for (const auto& cell : cells){
+        box.left = std::min(box.left, cell.x);
+        box.top = std::min(box.top, cell.y);
+        box.right = std::max(box.right, cell.x);
+        box.bottom = std::max(box.bottom, cell.y);
+    }
+
+    // The root's top-left corner is then on a multiple of half its size, so a HashLife universe can take its nodes as they are.
+    // A root of level 32 covers all the 'int' coordinates, so it's never bigger than that.
+    int level = QUADTREE_LEAF_LEVEL;
+    long long int half = 1LL << (level - 1);
+    while (box.left < -half || box.top < -half || half <= box.right || half <= box.bottom){
+        level++;
+        half *= 2;
+    }
+
+    tree.root = buildNode(builder, cells.data(), cells.data() + cells.size(), level, -half, -half);
+}
+
+static void forEachNodeCell(const Quadtree& tree, uint32_t node, long long int left, long long int top, const std::function<void(const Cell&)>& func){
+    if (node == 0) return;
+
+    const QuadtreeNode& n = tree.nodes[node];
+    if (n.level == QUADTREE_LEAF_LEVEL){
+        for (uint64_t cells = n.leaf; cells != 0; cells &= cells - 1){
+            int bit = countTrailingZeros64(cells);
+            func({(int)(left + bit % 8), (int)(top + bit / 8)});
+        }
+        return;
+    }
+
+    long long int half = 1LL << (n.level - 1);
+    forEachNodeCell(tree, n.nw, left, top, func);
+    forEachNodeCell(tree, n.ne, left + half, top, func);
+    forEachNodeCell(tree, n.sw, left, top + half, func);
+    forEachNodeCell(tree, n.se, left + half, top + half, func);
+}
+
+void forEachQuadtreeCell(const Quadtree& tree, long long int left, long long int top, const std::function<void(const Cell&)>& func){
+    forEachNodeCell(tree, tree.root, left, top, func);
+}
+
+void trimQuadtree(Quadtree& tree, long long int& left, long long int& top){
+    while (tree.root != 0 && tree.nodes[tree.root].level != QUADTREE_LEAF_LEVEL){
+        const QuadtreeNode& n = tree.nodes[tree.root];
+        if ((n.nw != 0) + (n.ne != 0) + (n.sw != 0) + (n.se != 0) != 1) break;
+
+        long long int half = 1LL << (n.level - 1);
+        if (n.ne != 0 || n.se != 0) left += half;
+        if (n.sw != 0 || n.se != 0) top += half;
+        tree.root = n.nw | n.ne | n.sw | n.se;
+    }
+}
+
+std::vector<QuadtreeNodeSummary> summarizeQuadtree(const Quadtree& tree){
+    std::vector<QuadtreeNodeSummary> summaries(tree.nodes.size(), {0, 0, 0, 0, 0});
+
+    // Children are before their parents, so they're always summarized first
+    for (size_t i = 1; i < tree.nodes.size(); i++){
+        const QuadtreeNode& n = tree.nodes[i];
+        QuadtreeNodeSummary& summary = summaries[i];
+
+        if (n.level == QUADTREE_LEAF_LEVEL){
+            summary = {(unsigned long long int)popcount64(n.leaf), 8, 8, -1, -1};
+            for (uint64_t cells = n.leaf; cells != 0; cells &= cells - 1){
+                int bit = countTrailingZeros64(cells);
+                summary.left = std::min<long long int>(summary.left, bit % 8);
+                summary.top = std::min<long long int>(summary.top, bit / 8);
+                summary.right = std::max<long long int>(summary.right, bit % 8);
+                summary.bottom = std::max<long long int>(summary.bottom, bit / 8);
+            }
+            continue;
+        }
+
+        long long int half = 1LL << (n.level - 1);
+        summary = {0, LLONG_MAX, LLONG_MAX, LLONG_MIN, LLONG_MIN};
+        const uint32_t children[4] = {n.nw, n.ne, n.sw, n.se};
+        for (int quadrant = 0; quadrant < 4; quadrant++){
+            if (children[quadrant] == 0) continue;
+
+            const QuadtreeNodeSummary& child = summaries[children[quadrant]];
+            long long int x = quadrant % 2 * half, y = quadrant / 2 * half;
+            summary.population = ULLONG_MAX - summary.population < child.population ? ULLONG_MAX : summary.population + child.population;
+            summary.left = std::min(summary.left, x + child.left);
+            summary.top = std::min(summary.top, y + child.top);
+            summary.right = std::max(summary.right, x + child.right);
+            summary.bottom = std::max(summary.bottom, y + child.bottom);
+        }
+    }
+
+    return summaries;
+}
@@ -0,0 +1,75 @@
+#ifndef GAME_OF_LIFE_QUADTREE_H
+#define GAME_OF_LIFE_QUADTREE_H
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "cell.h"
+
+#define QUADTREE_LEAF_LEVEL 3 // Leaves are 8x8 squares, like in Golly's macrocell files
+#define QUADTREE_MAX_LEVEL 31 // A pattern in a bigger square (even after trimming the empty space around it) doesn't fit in 'int' coordinates
+
+/* A node of level 'k' is a square of 2^k x 2^k cells. Leaves are of level 'QUADTREE_LEAF_LEVEL', and the other nodes have 4 children of level 'k-1'.
+Children are referenced by their index in 'Quadtree::nodes', which is always smaller than their parent's, and 0 is the empty node (of any level). */
+struct QuadtreeNode{
+    int level;
+    uint32_t nw, ne, sw, se;
+    uint64_t leaf; // Only for leaves: bit (8*y + x) is the cell at (x, y), relative to the leaf's top-left corner
+};
+
+/* A pattern as a quadtree in which identical sub-squares are stored once - which is what a macrocell file holds,
+so a huge but regular pattern takes little memory, and it can go between a file and an engine that is a quadtree itself (like HashLife) without a cell list.
+The tree has no position of its own: whoever inserts it says where its top-left corner goes. */
+struct Quadtree{
+    std::vector<QuadtreeNode> nodes; // 'nodes[0]' is a placeholder for the empty node
+    uint32_t root; // 0 if the pattern is empty
+
+    Quadtree();
+    int level() const; // Of the root. An empty tree is of the leaf level.
+};
+
+/* Builds a quadtree node by node, bottom-up, and returns the node that already exists if it's the same square (hash-consing).
+A node that would be empty is never created - 0 is returned instead. */
+class QuadtreeBuilder{
+private:
+    struct NodeKey{
+        uint32_t nw, ne, sw, se;
+        bool operator==(const NodeKey& other) const { return nw == other.nw && ne == other.ne && sw == other.sw && se == other.se; }
+    };
+    struct NodeKeyHash{
+        std::size_t operator()(const NodeKey& key) const{
+            uint64_t hash = ((uint64_t)key.nw * 0x9E3779B97F4A7C15) ^ ((uint64_t)key.ne * 0xC2B2AE3D27D4EB4F) ^
+                            ((uint64_t)key.sw * 0x165667B19E3779F9) ^ ((uint64_t)key.se * 0x27D4EB2F165667C5);
+            return hash ^ (hash >> 29);
+        }
+    };
+
+    Quadtree& tree;
+    std::unordered_map<uint64_t, uint32_t> leaves;
+    std::unordered_map<NodeKey, uint32_t, NodeKeyHash> inner_nodes; // The children determine the level, so it's not a part of the key
+
+public:
+    explicit QuadtreeBuilder(Quadtree& tree); // Empties 'tree'
+
+    uint32_t makeLeaf(uint64_t cells);
+    uint32_t makeNode(int level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+};
+
+// Builds the tree of the given cells, with the center of its root at (0,0) - like Golly, and 'HashLifeEngine'. The cells are reordered on the way.
+void quadtreeFromCells(std::vector<Cell>& cells, Quadtree& tree);
+// Calls 'func' for every live cell of the tree, with its top-left corner at (left, top).
+void forEachQuadtreeCell(const Quadtree& tree, long long int left, long long int top, const std::function<void(const Cell&)>& func);
+/* While the root has a single non-empty child, makes that child the root (so the tree is about as big as the pattern is).
+'left' and 'top' are the coordinates of the root's top-left corner, and they're moved with it. */
+void trimQuadtree(Quadtree& tree, long long int& left, long long int& top);
+
+// The live cells of a node, and their bounding box relative to the node's top-left corner. All 0 for the empty node.
+struct QuadtreeNodeSummary{
+    unsigned long long int population; // Stops at ULLONG_MAX, for the few trees that have more cells than that
+    long long int left, top, right, bottom;
+};
+// Summarizes every node of the tree (by its index), in one pass over the nodes - so it's as fast for a huge regular pattern as for a small one.
+std::vector<QuadtreeNodeSummary> summarizeQuadtree(const Quadtree& tree);
+
+#endif
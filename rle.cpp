@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include "rle.h"
+#include "bit_utils.h"
+#include "profiler.h"
+#include "thread_pool.h"
+
+RLEReader::RLEReader(): header({0, 0, "", {}}), body(nullptr), body_end(nullptr) { }
+
+static std::string trim(const char* begin, const char* end){
+    while (begin < end && isspace((unsigned char)*begin)) begin++;
+    while (begin < end && isspace((unsigned char)end[-1])) end--;
+
+    return std::string(begin, end);
+}
+
+static bool parseNumber(const std::string& str, int& number){
+    if (str.empty() || str.size() > 9) return false; // More than 9 digits might not fit in an int, and no pattern is that big anyway
+    number = 0;
+    for (auto c : str){
+        if (!isdigit((unsigned char)c)) return false;
+        number = number * 10 + (c - '0');
+    }
+
+    return true;
+}
+
+/* The file starts with '#' lines (name, author, comments...), and then the header, which is of the form "x = 3, y = 3, rule = B3/S23".
+The header is optional (some tools don't write it), so if the first line that isn't a comment doesn't start with 'x', it's already the body. */
+rle_status RLEReader::parseHeader(){
+    const char* p = file.data();
+    const char* end = file.data() + file.size();
+
+    while (p < end){
+        const char* line_end = (const char*)std::memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        std::string line = trim(p, line_end);
+
+        if (line.empty()){
+            p = line_end + (line_end < end);
+            continue;
+        }
+        if (line[0] == '#'){
+            header.comment_lines.push_back(line);
+            p = line_end + (line_end < end);
+            continue;
+        }
+        if (line[0] != 'x') break;
+
+        // "key = value" pairs, separated by commas
+        size_t pair_start = 0;
+        while (pair_start <= line.size()){
+            size_t pair_end = std::min(line.find(',', pair_start), line.size());
+            size_t equals = line.find('=', pair_start);
+            if (equals == std::string::npos || pair_end < equals) return RLE_FORMAT_ERROR;
+
+            std::string key = trim(line.data() + pair_start, line.data() + equals);
+            std::string value = trim(line.data() + equals + 1, line.data() + pair_end);
+            if ((key == "x" && !parseNumber(value, header.width)) || (key == "y" && !parseNumber(value, header.height))) return RLE_FORMAT_ERROR;
+            if (key == "rule") header.rule = value;
+
+            pair_start = pair_end + 1;
+        }
+
+        p = line_end + (line_end < end);
+        break;
+    }
+
+    body = p;
+    body_end = (const char*)std::memchr(p, '!', end - p); // Anything after the '!' is a comment
+    if (!body_end) body_end = end;
+
+    return RLE_OK;
+}
+
+rle_status RLEReader::open(const std::string& file_path){
+    header = {0, 0, "", {}};
+    if (!file.open(file_path)) return RLE_FILE_ERROR;
+
+    return parseHeader();
+}
+
+const RLEHeader& RLEReader::getHeader() const{
+    return header;
+}
+
+/* Decodes a part of the body that starts at the beginning of a row, with the rows relative to the part's first row.
+'rows' is set to how many rows the part moves down - the amount of rows before the row the next part starts on. */
+static bool decodeChunk(const char* begin, const char* end, int left, std::vector<Cell>& cells, int& rows){
+    long long int x = 0, y = 0, count = 0;
+    bool has_count = false;
+
+    for (const char* p = begin; p < end; p++){
+        char c = *p;
+        if ('0' <= c && c <= '9'){
+            count = count * 10 + (c - '0');
+            if (INT_MAX < count) return false;
+            has_count = true;
+            continue;
+        }
+
+        long long int run = has_count ? count : 1;
+        if (c == 'o'){
+            if (INT_MAX < x + run) return false;
+            for (long long int i = 0; i < run; i++) cells.push_back({(int)(left + x + i), (int)y});
+            x += run;
+        }
+        else if (c == 'b') x += run;
+        else if (c == '$'){ // A number before '$' implies multiple newlines
+            y += run;
+            x = 0;
+            if (INT_MAX < y) return false;
+        }
+        else if (isspace((unsigned char)c)) continue; // Lines are wrapped at some length, and the numbers don't carry over whitespace
+        else return false; // If 'c' is none of the above, then file formatting is erroneous
+
+        count = 0;
+        has_count = false;
+    }
+
+    rows = (int)y;
+    return true;
+}
+
+/* The decodes share one pool, like an engine keeps its own, so a read doesn't create (and join) a thread per core; it's made on the first file
+that has more than one chunk. Files are read on more than one thread (the catalog's rebuild and the pattern loader), and the pool runs a job at a time,
+so a decode that finds the pool busy decodes on its own thread instead of waiting for it. */
+static std::mutex decode_pool_mutex; // Held while a decode uses the pool
+
+static ThreadPool& decodePool(){
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+/* The body is split at (roughly) equal distances, and every split point is pushed forward to right after the next '$'.
+The chunks are decoded in parallel with the rows relative to their own start, and 'chunk_tops' is set to where every chunk really starts,
+by the rows of the chunks before it. The callers shift the cells down by it on their way out (while copying them, if they copy them anyway). */
+rle_status RLEReader::decode(int left, int top, std::vector<std::vector<Cell>>& chunk_cells, std::vector<int>& chunk_tops) const{
+    PROFILE_SCOPE("RLEReader::decode");
+    size_t body_size = body_end - body;
+    size_t chunk_count = std::max<size_t>(1, body_size / RLE_CHUNK_SIZE);
+
+    std::vector<const char*> splits = {body};
+    for (size_t i = 1; i < chunk_count; i++){
+        const char* split = std::max(splits.back(), body + body_size * i / chunk_count);
+        const char* row_end = (const char*)std::memchr(split, '$', body_end - split);
+        if (!row_end) break;
+        if (splits.back() < row_end + 1) splits.push_back(row_end + 1);
+    }
+    splits.push_back(body_end);
+    chunk_count = splits.size() - 1;
+
+    chunk_cells.assign(chunk_count, {});
+    std::vector<int> chunk_rows(chunk_count, 0);
+    std::vector<char> chunk_ok(chunk_count, false); // Not 'vector<bool>', since the workers write to neighboring elements
+
+    auto decodeTask = [&](size_t chunk, int /*worker*/){
+        chunk_ok[chunk] = decodeChunk(splits[chunk], splits[chunk + 1], left, chunk_cells[chunk], chunk_rows[chunk]);
+    };
+    std::unique_lock<std::mutex> pool_lock(decode_pool_mutex, std::defer_lock);
+    if (1 < chunk_count && 1 < std::thread::hardware_concurrency() && pool_lock.try_lock()) decodePool().parallelFor(chunk_count, decodeTask);
+    else for (size_t chunk = 0; chunk < chunk_count; chunk++) decodeTask(chunk, 0);
+    if (std::find(chunk_ok.begin(), chunk_ok.end(), false) != chunk_ok.end()) return RLE_FORMAT_ERROR;
+
+    long long int chunk_top = top;
+    chunk_tops.assign(chunk_count, 0);
+    for (size_t chunk = 0; chunk < chunk_count; chunk++){
+        if (INT_MAX < chunk_top + chunk_rows[chunk]) return RLE_FORMAT_ERROR;
+        chunk_tops[chunk] = (int)chunk_top;
+        chunk_top += chunk_rows[chunk];
+    }
+
+    return RLE_OK;
+}
+
+rle_status RLEReader::readCells(std::vector<Cell>& cells, int left, int top) const{
+    PROFILE_SCOPE("RLEReader::readCells");
+    std::vector<std::vector<Cell>> chunk_cells;
+    std::vector<int> chunk_tops;
+    rle_status status = decode(left, top, chunk_cells, chunk_tops);
+    if (status != RLE_OK) return status;
+
+    size_t total = cells.size();
+    for (const auto& chunk : chunk_cells) total += chunk.size();
+    cells.reserve(total);
+    for (size_t chunk = 0; chunk < chunk_cells.size(); chunk++){
+        for (const auto& cell : chunk_cells[chunk]) cells.push_back({cell.x, cell.y + chunk_tops[chunk]});
+    }
+
+    return RLE_OK;
+}
+
+rle_status RLEReader::insertInto(Engine& engine, int left, int top) const{
+    std::vector<std::vector<Cell>> chunk_cells;
+    std::vector<int> chunk_tops;
+    rle_status status = decode(left, top, chunk_cells, chunk_tops);
+    if (status != RLE_OK) return status;
+
+    for (size_t chunk = 0; chunk < chunk_cells.size(); chunk++){
+        for (auto& cell : chunk_cells[chunk]) cell.y += chunk_tops[chunk];
+        engine.insertCells(chunk_cells[chunk]);
+    }
+    return RLE_OK;
+}
+
+rle_status readRLE(const std::string& file_path, std::vector<Cell>& cells){
+    RLEReader reader;
+    rle_status status = reader.open(file_path);
+    if (status != RLE_OK) return status;
+
+    return reader.readCells(cells);
+}
+
+int radixPasses(const BoundingBox& box){
+    unsigned long long int width = (unsigned long long int)((long long int)box.right - box.left + 1);
+    unsigned long long int max_key = (unsigned long long int)((long long int)box.bottom - box.top) * width + (width - 1);
+    if (max_key == 0) return 0;
+
+    int key_bits = 64 - countLeadingZeros64(max_key);
+    return (key_bits + RADIX_BITS - 1) / RADIX_BITS;
+}
+
+/* The key of a cell is its index in the bounding box, row by row. The box is at most 2^32 x 2^32, so that always fits in 64 bits.
+Every pass sorts by the next 'RADIX_BITS' bits of the key, and keeps the order of the previous passes among equal digits,
+so after the pass on the highest digit the cells are sorted by the whole key. */
+int sortCellsInRowOrder(std::vector<Cell>& cells, const BoundingBox& box, std::atomic<unsigned long long int>* work_done){
+    PROFILE_SCOPE("sortCellsInRowOrder");
+    int passes = radixPasses(box);
+    if (cells.size() < 2 || passes == 0) return passes;
+
+    unsigned long long int width = (unsigned long long int)((long long int)box.right - box.left + 1);
+    auto key = [&box, width](const Cell& cell){
+        return (unsigned long long int)((long long int)cell.y - box.top) * width + (unsigned long long int)((long long int)cell.x - box.left);
+    };
+
+    std::vector<Cell> scratch(cells.size());
+    std::vector<size_t> offsets(1 << RADIX_BITS);
+    const unsigned long long int digit_mask = (1ULL << RADIX_BITS) - 1;
+
+    for (int pass = 0; pass < passes; pass++){
+        int shift = pass * RADIX_BITS;
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const auto& cell : cells) offsets[(key(cell) >> shift) & digit_mask]++;
+
+        size_t offset = 0;
+        for (auto& digit_offset : offsets){
+            size_t count = digit_offset;
+            digit_offset = offset;
+            offset += count;
+        }
+
+        for (const auto& cell : cells) scratch[offsets[(key(cell) >> shift) & digit_mask]++] = cell;
+        cells.swap(scratch);
+        if (work_done) *work_done += cells.size();
+    }
+
+    return passes;
+}
+
+/* Encodes the body into a buffer of about 'RLE_WRITE_BUFFER_SIZE' bytes, and flushes it to the file whenever it fills up.
+The runs are never split between lines, so a line is wrapped before the run that would make it longer than 'RLE_LINE_LENGTH'. */
+class RLEBodyWriter{
+private:
+    std::ofstream& file;
+    std::string buffer;
+    int line_length;
+
+    void flush(){
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+public:
+    explicit RLEBodyWriter(std::ofstream& file): file(file), line_length(0) {
+        buffer.reserve(RLE_WRITE_BUFFER_SIZE + RLE_LINE_LENGTH + 1);
+    }
+
+    // A run of 1 is written without the count.
+    void writeRun(long long int count, char tag){
+        char token[24];
+        int length = 0;
+        if (1 < count) length = std::snprintf(token, sizeof(token) - 1, "%lld", count);
+        token[length++] = tag;
+
+        if (RLE_LINE_LENGTH < line_length + length){
+            buffer.push_back('\n');
+            line_length = 0;
+        }
+        buffer.append(token, length);
+        line_length += length;
+
+        if (RLE_WRITE_BUFFER_SIZE <= buffer.size()) flush();
+    }
+
+    void finish(){
+        buffer.append("!\n");
+        flush();
+    }
+};
+
+rle_status writeRLE(const std::string& file_path, std::vector<Cell>& cells, const Rule& rule, RLEWriteProgress* progress){
+    PROFILE_SCOPE("writeRLE");
+    std::ofstream file(file_path);
+    if (!file) return RLE_FILE_ERROR;
+
+    BoundingBox box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    for (const auto& cell : cells){
+        box.left = std::min(box.left, cell.x);
+        box.right = std::max(box.right, cell.x);
+        box.top = std::min(box.top, cell.y);
+        box.bottom = std::max(box.bottom, cell.y);
+    }
+
+    if (cells.empty()){
+        file << "x = 0, y = 0, rule = " << rule.toString() << "\n!\n";
+        return file ? RLE_OK : RLE_FILE_ERROR;
+    }
+
+    std::atomic<unsigned long long int>* work_done = nullptr;
+    if (progress){
+        progress->total_work = (unsigned long long int)(radixPasses(box) + 1) * cells.size(); // The passes of the sort, and then the writing
+        work_done = &progress->work_done;
+    }
+    sortCellsInRowOrder(cells, box, work_done);
+
+    file << "x = " << (long long int)box.right - box.left + 1 << ", y = " << (long long int)box.bottom - box.top + 1 << ", rule = " << rule.toString() << "\n";
+
+    RLEBodyWriter writer(file);
+    long long int row = box.top;
+    size_t i = 0;
+    while (i < cells.size()){
+        size_t row_start = i;
+        int y = cells[i].y;
+        if (row < y) writer.writeRun(y - row, '$'); // A number before '$' skips the empty rows as well
+        row = y;
+
+        long long int column = box.left; // The next column that isn't written yet. The dead cells at the end of the row aren't written at all.
+        while (i < cells.size() && cells[i].y == y){
+            if (column < cells[i].x) writer.writeRun(cells[i].x - column, 'b');
+
+            size_t streak_start = i;
+            while (i + 1 < cells.size() && cells[i + 1].y == y && (long long int)cells[i + 1].x == (long long int)cells[i].x + 1) i++;
+            i++;
+            writer.writeRun(i - streak_start, 'o');
+            column = (long long int)cells[i - 1].x + 1;
+        }
+
+        if (work_done) *work_done += i - row_start;
+    }
+    writer.finish();
+
+    return file ? RLE_OK : RLE_FILE_ERROR;
+}
+
+RLEExport::RLEExport(): done(true), write_progress{{0}, {0}}, status(RLE_OK) { }
+
+RLEExport::~RLEExport(){
+    wait();
+}
+
+void RLEExport::start(const std::string& file_path, std::vector<Cell> cells, const Rule& rule){
+    wait(); // There's only one export at a time
+
+    done = false;
+    write_progress.work_done = 0;
+    write_progress.total_work = 0;
+    thread = std::thread([this, file_path, cells = std::move(cells), rule]() mutable {
+        status = writeRLE(file_path, cells, rule, &write_progress);
+        done = true;
+    });
+}
+
+bool RLEExport::isDone() const{
+    return done;
+}
+
+double RLEExport::progress() const{
+    unsigned long long int total_work = write_progress.total_work;
+    if (done) return 1;
+    if (total_work == 0) return 0;
+
+    return std::min(1.0, (double)write_progress.work_done / total_work);
+}
+
+rle_status RLEExport::wait(){
+    if (thread.joinable()) thread.join();
+    return status;
+}
@@ -0,0 +1,92 @@
+#ifndef GAME_OF_LIFE_RLE_H
+#define GAME_OF_LIFE_RLE_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cell.h"
+#include "engine.h"
+#include "mapped_file.h"
+
+#define RLE_CHUNK_SIZE (1 << 20) // In bytes. A bigger body is split into chunks of about this size, which are decoded in parallel.
+#define RLE_LINE_LENGTH 70 // Lines of a written body are wrapped before they get longer than this
+#define RLE_WRITE_BUFFER_SIZE (1 << 16) // In bytes. The body is written to the file in blocks of about this size.
+#define RADIX_BITS 16 // 'sortCellsInRowOrder()' sorts by this many bits of the key per pass
+
+enum rle_status {RLE_OK, RLE_FILE_ERROR, RLE_FORMAT_ERROR};
+
+// What an .rle file says about its pattern, besides the cells themselves.
+struct RLEHeader{
+    int width, height; // 0 if the file has no header line
+    std::string rule; // Empty if the header doesn't specify one
+    std::vector<std::string> comment_lines; // The '#' lines before the header, as they are (like "#N Glider")
+};
+
+/* RLE parser. The file is memory-mapped and decoded straight from the mapping, without copying it into a string first.
+'open()' parses only the '#' lines and the header, so the caller can decide where to put the pattern (by its size) before decoding it.
+A big body is split into chunks right after '$' characters, so every chunk starts at the beginning of a row,
+and the chunks are decoded on all the cores. Every chunk counts its own rows, so once they're all done we know where each one starts. */
+class RLEReader{
+private:
+    MappedFile file;
+    RLEHeader header;
+    const char* body; // From right after the header up to the '!'
+    const char* body_end;
+
+    rle_status parseHeader();
+    rle_status decode(int left, int top, std::vector<std::vector<Cell>>& chunk_cells, std::vector<int>& chunk_tops) const;
+
+public:
+    RLEReader();
+
+    rle_status open(const std::string& file_path);
+    const RLEHeader& getHeader() const;
+
+    // Appends the live cells to 'cells', with the pattern's top-left corner at (left, top).
+    rle_status readCells(std::vector<Cell>& cells, int left = 0, int top = 0) const;
+    // Inserts the live cells into the engine (in bulk, see 'Engine::insertCells()'), with the pattern's top-left corner at (left, top).
+    rle_status insertInto(Engine& engine, int left = 0, int top = 0) const;
+};
+
+// Takes an .rle file and appends its live cells to 'cells'. Cells are relative to the pattern's top-left corner, which is (0,0).
+rle_status readRLE(const std::string& file_path, std::vector<Cell>& cells);
+
+// How far a write has gone. 'total_work' is set once the write knows how big the pattern is (until then it's 0).
+struct RLEWriteProgress{
+    std::atomic<unsigned long long int> work_done, total_work;
+};
+
+/* Sorts the cells by rows (top to bottom, and left to right in every row), which is the order they're written in.
+It's an LSD radix sort on the cell's offset from the top-left corner of 'box', so the key is only as wide as the pattern is big,
+and it takes a few linear passes and a scratch copy of the cells - instead of a heap node per cell, like an ordered set.
+Returns how many passes it took; 'radixPasses()' tells that in advance. 'work_done' (if not null) is advanced by the cells of every pass. */
+int sortCellsInRowOrder(std::vector<Cell>& cells, const BoundingBox& box, std::atomic<unsigned long long int>* work_done = nullptr);
+int radixPasses(const BoundingBox& box);
+
+/* Writes the cells as an .rle file, with the pattern's top-left corner as the origin. The cells are sorted in place.
+The body is encoded into a fixed-size buffer that is flushed whenever it fills up, so no matter how big the pattern is,
+the only memory we need besides the cells is that buffer (and the sort's scratch copy). */
+rle_status writeRLE(const std::string& file_path, std::vector<Cell>& cells, const Rule& rule, RLEWriteProgress* progress = nullptr);
+
+/* Writes an .rle file on a thread of its own, so a big pattern can be saved without freezing the screen.
+It works on its own copy of the cells, so the engine is free again as soon as 'start()' returns. */
+class RLEExport{
+private:
+    std::thread thread;
+    std::atomic<bool> done;
+    RLEWriteProgress write_progress;
+    rle_status status; // Written by the thread before 'done' is set
+
+public:
+    RLEExport();
+    ~RLEExport(); // Waits for the file to be finished, so we don't leave half a file behind
+
+    void start(const std::string& file_path, std::vector<Cell> cells, const Rule& rule);
+    bool isDone() const;
+    double progress() const; // From 0 to 1
+    // Waits for the export to finish (if it hasn't yet), and returns how it went.
+    rle_status wait();
+};
+
+#endif
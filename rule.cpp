@@ -0,0 +1,80 @@
+#include <cctype>
+#include "rule.h"
+
+Rule::Rule(): Rule({}, {}) { }
+
+Rule::Rule(const std::set<short int>& born_digits, const std::set<short int>& survive_digits): born_mask(0), survive_mask(0), block_table(BLOCK_TABLE_SIZE) {
+    for (const auto& digit : born_digits) born_mask |= 1 << digit;
+    for (const auto& digit : survive_digits) survive_mask |= 1 << digit;
+
+    for (int neighbors = 0; neighbors <= 8; neighbors++){
+        next_state[0][neighbors] = born_mask >> neighbors & 1;
+        next_state[1][neighbors] = survive_mask >> neighbors & 1;
+    }
+
+    for (int block = 0; block < BLOCK_TABLE_SIZE; block++){
+        uint8_t result = 0;
+        for (int y = 1; y <= 2; y++){
+            for (int x = 1; x <= 2; x++){
+                int neighbors = 0;
+                for (int k = y - 1; k <= y + 1; k++){
+                    for (int p = x - 1; p <= x + 1; p++){
+                        if (k != y || p != x) neighbors += block >> (4 * k + p) & 1;
+                    }
+                }
+
+                if (next_state[block >> (4 * y + x) & 1][neighbors]) result |= 1 << (2 * (y - 1) + (x - 1));
+            }
+        }
+        block_table[block] = result;
+    }
+}
+
+std::set<short int> Rule::bornDigits() const{
+    std::set<short int> digits;
+    for (short int digit = 0; digit <= 8; digit++){
+        if (born_mask >> digit & 1) digits.insert(digit);
+    }
+
+    return digits;
+}
+
+std::set<short int> Rule::surviveDigits() const{
+    std::set<short int> digits;
+    for (short int digit = 0; digit <= 8; digit++){
+        if (survive_mask >> digit & 1) digits.insert(digit);
+    }
+
+    return digits;
+}
+
+std::string Rule::toString() const{
+    std::string rulestring = "B";
+    for (const auto& digit : bornDigits()) rulestring += std::to_string(digit);
+    rulestring += "/S";
+    for (const auto& digit : surviveDigits()) rulestring += std::to_string(digit);
+
+    return rulestring;
+}
+
+/* Parses a rulestring of the form "B<digits>/S<digits>" (the '/' is optional, and so is the case of the letters).
+This is the same format we write in the header of the .rle files we export.
+Born digits are in range [1,8] (a B0 rule would turn the entire infinite universe on), and survive digits are in range [0,8]. */
+bool parseRulestring(const std::string& rulestring, Rule& rule){
+    std::set<short int> born_digits, survive_digits;
+    std::set<short int>* curr_digits = nullptr;
+
+    for (auto c : rulestring){
+        if (c == 'B' || c == 'b') curr_digits = &born_digits;
+        else if (c == 'S' || c == 's') curr_digits = &survive_digits;
+        else if (c == '/' || isspace(c)) continue;
+        else if ('0' <= c && c <= '8' && curr_digits){
+            if (curr_digits == &born_digits && c == '0') return false;
+            curr_digits->insert(c - '0');
+        }
+        else return false;
+    }
+
+    rule = Rule(born_digits, survive_digits);
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef GAME_OF_LIFE_RULE_H
+#define GAME_OF_LIFE_RULE_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#define BLOCK_TABLE_SIZE 65536 // One entry for every 4x4 block
+
+/* A rule compiled from its born and survive digits, so that stepping never touches a 'std::set'.
+We compile it once, when the automaton is chosen, into flat tables for each kind of engine:
+1) Masks, where bit 'k' is on if a cell with 'k' neighbors is born/survives (for the bit-parallel tiled engine).
+2) An 18 entries table of [state][neighbor count] -> next state (for the cell-by-cell sparse engine).
+3) A 65536 entries table of 4x4 block -> its 2x2 center in the next generation (for block-based stepping, like HashLife's base case).
+A 4x4 block is encoded with cell (x,y) in bit '4y + x', and a 2x2 center with cell (x,y) in bit '2y + x'. */
+class Rule{
+private:
+    uint16_t born_mask, survive_mask;
+    bool next_state[2][9];
+    std::vector<uint8_t> block_table;
+
+public:
+    Rule(); // A rule in which everything dies
+    Rule(const std::set<short int>& born_digits, const std::set<short int>& survive_digits);
+
+    uint16_t getBornMask() const { return born_mask; }
+    uint16_t getSurviveMask() const { return survive_mask; }
+    bool nextState(bool is_live, int neighbors) const { return next_state[is_live][neighbors]; }
+    uint8_t blockResult(uint16_t block) const { return block_table[block]; }
+
+    std::set<short int> bornDigits() const;
+    std::set<short int> surviveDigits() const;
+    std::string toString() const; // In "B<digits>/S<digits>" form
+};
+
+bool parseRulestring(const std::string& rulestring, Rule& rule);
+
+#endif
@@ -14,11 +14,12 @@ short int RulestringMenuScreen::run(){
     sf::Text* curr_prompt = &born_prompt;
     short int curr_lower_limit = 1; // Lower limit is 1 for born_prompt, but will be 0 for survive_prompt
     int curr_prompt_initial_size = born_prompt.getString().getSize();
-    std::set <short int> curr_prompt_digits;
+    std::set <short int> curr_prompt_digits, born_digits;
 
+    frame_scheduler.requestRedraw(); // The screen before us drew something else
     while (true) {
         sf::Event evnt;
-        while (window.pollEvent(evnt)){
+        while (frame_scheduler.pollEvent(window, evnt)){
             switch (evnt.type){
                 case sf::Event::Closed:
                     return -1;
@@ -66,7 +67,7 @@ short int RulestringMenuScreen::run(){
                             born_prompt.setString(initial_born_prompt_str);
                             survive_prompt.setString(initial_survive_prompt_str);
 
-                            survive_digits = curr_prompt_digits;
+                            rule = Rule(born_digits, curr_prompt_digits);
                             return PATTERN_MENU_SCREEN;
                         }
                     }
@@ -82,6 +83,8 @@ short int RulestringMenuScreen::run(){
             }
         }
 
+        if (!frame_scheduler.startFrame()) continue;
+
         window.clear();
         window.draw(born_prompt);
         window.draw(survive_prompt);
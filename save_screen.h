@@ -2,13 +2,21 @@
 #define GAME_OF_LIFE_SAVE_SCREEN_H
 
 #include "screens.h"
+#include "rle.h"
+
+#define SAVE_PROMPT "Would you like to save this pattern in an .rle file? [Y/N] "
 
 class SaveScreen: public GridScreen{
 private:
     sf::Text save_prompt;
     const sf::Color live_cell_diff, dead_cell_diff, outline_diff; // The color diffs enable us to dim the screen
 
-    static std::string gridToRLE();
+    RLEExport rle_export;
+    bool is_saving;
+    std::string saved_file_path;
+
+    void startSaving();
+    void setProgressText();
     void dimOrBrightenScreen() const;
 
 public:
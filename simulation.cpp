@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include "simulation.h"
+#include "profiler.h"
+
+Simulation::Simulation(std::unique_ptr<Engine>& engine): engine(engine), is_running(false), block_level(0), view_rect{INT_MIN, INT_MIN, INT_MAX, INT_MAX},
+                                                         timestep(0), step_size(1), generation(0),
+                                                         stop_on_cycle(false), turbo(false), frame_budget(DEFAULT_FRAME_BUDGET), target_rate(0),
+                                                         in_cycle(false), is_idle(false), is_at_coordinate_limit(false), published_block_level(0), published_view_rect(view_rect), cycle(), seconds_per_generation(0), seconds_per_publish(0), last_batch(0),
+                                                         rate_window_generation(0), generations_per_second(0) {
+    for (int i = 0; i < SNAPSHOT_BUFFERS; i++) buffers.push_back(std::make_shared<GridSnapshot>());
+}
+
+Simulation::~Simulation(){
+    stop();
+}
+
+static std::atomic<unsigned long long int> next_snapshot_id(1);
+
+/* A buffer that only 'buffers' holds is free: the published one is also held by 'published', and the one being drawn by the render loop.
+And since the render loop gets snapshots only through 'published', nobody can grab a free buffer while we fill it.
+
+We copy only the cells in the view rectangle, which the engine finds with its spatial index ('Engine::forEachCellInRect()'),
+so a snapshot costs as much as the cells around the view, even when the universe has millions more.
+
+The diff is against the snapshot that is still published, which we hold on to while we fill the next one. It's exact whatever happened in between
+(even if the engine was edited or replaced between a 'stop()' and a 'start()'), since it's taken from the cells of both - in the same rectangle.
+Once it gets too big we stop collecting it - the snapshot is then drawn from scratch anyway.
+A snapshot of squares (see 'setBlockLevel()') has no diff, and neither has the first snapshot of cells after one, or after a new rectangle. */
+void Simulation::publish(){
+    PROFILE_SCOPE("Simulation::publish");
+    std::shared_ptr<GridSnapshot> snapshot;
+    for (const auto& buffer : buffers){
+        if (buffer.use_count() == 1){
+            snapshot = buffer;
+            break;
+        }
+    }
+    if (!snapshot){ // The render loop held on to an old snapshot for a while. It doesn't happen with one snapshot per frame, but just in case.
+        snapshot = std::make_shared<GridSnapshot>();
+        buffers.push_back(snapshot);
+    }
+
+    std::shared_ptr<const GridSnapshot> previous = std::atomic_load(&published);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        published_block_level = block_level;
+        published_view_rect = view_rect;
+    }
+
+    snapshot->id = next_snapshot_id++;
+    snapshot->generation = generation;
+    snapshot->population = engine->population();
+    snapshot->in_cycle = in_cycle;
+    snapshot->cycle = cycle;
+    snapshot->is_at_coordinate_limit = is_at_coordinate_limit;
+    snapshot->generations_per_second = generations_per_second;
+    // A buffer that once held a bigger rectangle (or the whole universe) would cost us that much to clear on every publish
+    size_t expected_size = previous && previous->block_level == 0 ? previous->cells.size() : 0;
+    if (SNAPSHOT_MAX_SLACK * std::max<size_t>(MIN_TABLE_CAPACITY, expected_size) < snapshot->cells.capacity()) snapshot->cells = CellSet();
+    snapshot->cells.clear();
+    snapshot->births.clear();
+    snapshot->deaths.clear();
+    snapshot->previous_id = previous ? previous->id : 0;
+    snapshot->rect = published_view_rect;
+    snapshot->block_level = published_block_level;
+    if (published_block_level == 0 && SNAPSHOT_MAX_SLACK * MIN_TABLE_CAPACITY < snapshot->blocks.capacity()) snapshot->blocks = CellMap<unsigned long long int>();
+    snapshot->blocks.clear();
+
+    if (published_block_level != 0){
+        engine->forEachBlock(published_block_level, [&snapshot](const Cell& block, unsigned long long int population){
+            snapshot->blocks[block] = population;
+        });
+        snapshot->has_diff = false;
+        std::atomic_store(&published, std::shared_ptr<const GridSnapshot>(snapshot));
+        return;
+    }
+
+    const BoundingBox& rect = snapshot->rect;
+    bool has_diff = previous != nullptr && previous->block_level == 0 && previous->rect.left == rect.left && previous->rect.top == rect.top &&
+                    previous->rect.right == rect.right && previous->rect.bottom == rect.bottom;
+    engine->forEachCellInRect(rect, [&snapshot, &previous, &has_diff](const Cell& cell){
+        snapshot->cells.insert(cell);
+        if (has_diff && !previous->cells.count(cell)){
+            snapshot->births.push_back(cell);
+            has_diff = snapshot->births.size() <= MAX_SNAPSHOT_DIFF;
+        }
+    });
+    if (has_diff){
+        previous->cells.forEach([&snapshot, &has_diff](const Cell& cell){
+            if (!has_diff || snapshot->cells.count(cell)) return;
+            snapshot->deaths.push_back(cell);
+            has_diff = snapshot->births.size() + snapshot->deaths.size() <= MAX_SNAPSHOT_DIFF;
+        });
+    }
+    if (!has_diff){
+        snapshot->births.clear();
+        snapshot->deaths.clear();
+    }
+    snapshot->has_diff = has_diff;
+
+    std::atomic_store(&published, std::shared_ptr<const GridSnapshot>(snapshot));
+}
+
+void Simulation::start(){
+    stop(); // The thread might have ended by itself, on a cycle - but it still has to be joined
+
+    generation = engine->getGeneration(); // Which isn't 0 after restoring a checkpoint
+    cycle_detector.clear();
+    cycle_detector.record(generation, engine->signature(), cycle);
+    in_cycle = false;
+    is_idle = false;
+    is_at_coordinate_limit = false;
+    seconds_per_generation = 0;
+    seconds_per_publish = 0;
+    last_batch = 0;
+    rate_window_start = std::chrono::steady_clock::now();
+    rate_window_generation = generation;
+    generations_per_second = 0;
+    publish();
+    is_running = true;
+    thread = std::thread(&Simulation::loop, this);
+}
+
+void Simulation::stop(){
+    if (!thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_running = false;
+    }
+    wake_up.notify_all();
+    thread.join();
+}
+
+/* How many generations to run in turbo mode: as many as fit in the frame budget, at the speed of the last batch.
+The budget is for the whole batch, so the publish (as long as the last one took) comes out of it first - but the generations always get
+at least half of it, so a huge view that takes longer to publish than the budget still lets the simulation go on (in fewer, bigger snapshots).
+A batch grows by at most 2x at a time, so one cheap batch (say, of a pattern that's about to explode) can't make the next one take seconds.
+It's always a multiple of the step, so we still publish only the generations the game would have shown. */
+unsigned long long int Simulation::turboBatch() const{
+    unsigned long long int step = step_size;
+    if (seconds_per_generation <= 0) return step;
+
+    double budget = frame_budget / 1000.0;
+    budget = std::max(budget / 2, budget - seconds_per_publish);
+    double fitting_steps = budget / seconds_per_generation / step;
+    unsigned long long int max_steps = std::max<unsigned long long int>(1, 2 * last_batch / step);
+    if ((double)max_steps <= fitting_steps) return max_steps * step;
+
+    return std::max<unsigned long long int>(1, (unsigned long long int)fitting_steps) * step;
+}
+
+void Simulation::measureRate(){
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - rate_window_start).count();
+    if (seconds * 1000 < RATE_WINDOW) return;
+
+    generations_per_second = (generation - rate_window_generation) / seconds;
+    rate_window_start = now;
+    rate_window_generation = generation;
+}
+
+// Whether the screen has asked for another block level or view rectangle than the ones we've published. Must be called with 'mutex' held.
+bool Simulation::isRepublishNeeded() const{
+    return block_level != published_block_level || view_rect.left != published_view_rect.left || view_rect.top != published_view_rect.top ||
+           view_rect.right != published_view_rect.right || view_rect.bottom != published_view_rect.bottom;
+}
+
+/* We keep a steady beat of a step every 'timestep' milliseconds, measured from the start of the previous step.
+If a step takes longer than that, the next one starts right away (so a big pattern simply runs as fast as it can).
+In turbo mode we don't wait at all, unless we're ahead of the target rate - then we sleep until the next step is due.
+The target rate is kept from the moment it was set (so being behind for a while is made up for later, up to the frame budget).
+Sleeping on the condition variable (and not with 'sleep') lets 'stop()' wake us up immediately - and 'setBlockLevel()' and 'setViewRect()' too,
+in which case we publish the same generation again, and go back to waiting for the same step. */
+void Simulation::loop(){
+    auto next_step_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(turbo ? 0 : (int)timestep);
+    auto paced_since = std::chrono::steady_clock::now();
+    unsigned long long int paced_rate = 0, paced_generations = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    auto woken = [this] { return !is_running || isRepublishNeeded(); };
+
+    while (true){
+        if (is_idle) wake_up.wait(lock, woken);
+        else wake_up.wait_until(lock, next_step_time, woken);
+        if (!is_running) return;
+
+        bool republish = isRepublishNeeded();
+        lock.unlock();
+        if (republish){
+            publish();
+            lock.lock();
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        unsigned long long int generations = step_size;
+        if (!turbo) next_step_time = std::max(now, next_step_time) + std::chrono::milliseconds(timestep);
+        else{
+            next_step_time = now;
+            generations = turboBatch();
+
+            unsigned long long int rate = target_rate;
+            if (rate != paced_rate){
+                paced_rate = rate;
+                paced_since = now;
+                paced_generations = 0;
+            }
+            if (rate != 0){
+                double owed = std::chrono::duration<double>(now - paced_since).count() * rate - paced_generations;
+                unsigned long long int owed_steps = owed <= 0 ? 0 : (unsigned long long int)owed / step_size;
+                generations = std::min(generations, owed_steps * step_size);
+                if (generations == 0){ // We're ahead, so we sleep until a step is owed
+                    next_step_time = paced_since + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double>((double)(paced_generations + step_size) / rate));
+                    lock.lock();
+                    continue;
+                }
+                paced_generations += generations;
+            }
+        }
+
+        auto advance_start = std::chrono::steady_clock::now();
+        engine->advance(generations);
+        auto advance_end = std::chrono::steady_clock::now();
+        seconds_per_generation = std::chrono::duration<double>(advance_end - advance_start).count() / generations;
+        last_batch = generations;
+        generation = engine->getGeneration(); // Which is less than we asked for, at the coordinate limit
+        is_at_coordinate_limit = engine->isAtCoordinateLimit();
+        measureRate();
+        if (!in_cycle) in_cycle = cycle_detector.record(generation, engine->signature(), cycle);
+        publish();
+        seconds_per_publish = std::chrono::duration<double>(std::chrono::steady_clock::now() - advance_end).count(); // With the cycle detection
+        if ((in_cycle && stop_on_cycle) || is_at_coordinate_limit) is_idle = true;
+
+        lock.lock();
+    }
+}
+
+void Simulation::setTimestep(int milliseconds){
+    timestep = milliseconds;
+}
+
+void Simulation::setStepSize(unsigned long long int generations){
+    step_size = generations;
+}
+
+void Simulation::setStopOnCycle(bool stop){
+    stop_on_cycle = stop;
+}
+
+void Simulation::setTurbo(bool enabled){
+    turbo = enabled;
+}
+
+void Simulation::setFrameBudget(int milliseconds){
+    frame_budget = milliseconds;
+}
+
+void Simulation::setTargetRate(unsigned long long int generations_per_second){
+    target_rate = generations_per_second;
+}
+
+void Simulation::setBlockLevel(int level){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        block_level = level;
+    }
+    wake_up.notify_all();
+}
+
+void Simulation::setViewRect(const BoundingBox& rect){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        view_rect = rect;
+    }
+    wake_up.notify_all();
+}
+
+unsigned long long int Simulation::getGeneration() const{
+    return generation;
+}
+
+std::shared_ptr<const GridSnapshot> Simulation::latestSnapshot() const{
+    return std::atomic_load(&published);
+}
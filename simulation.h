@@ -0,0 +1,136 @@
+#ifndef GAME_OF_LIFE_SIMULATION_H
+#define GAME_OF_LIFE_SIMULATION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cycle_detector.h"
+#include "engine.h"
+#include "flat_cell_table.h"
+
+#define SNAPSHOT_BUFFERS 3 // One published, one being drawn, and one being filled
+#define DEFAULT_FRAME_BUDGET 14 // In milliseconds. In turbo mode, how long a batch (stepping and publishing) takes (a bit less than a frame at 60 FPS).
+#define RATE_WINDOW 500 // In milliseconds. The generations/sec readout is averaged over this long.
+#define SNAPSHOT_MAX_SLACK 8 // A snapshot buffer whose set has this many times more slots than the last snapshot needed is let go, since clearing it costs by its slots
+#define MAX_SNAPSHOT_DIFF (1 << 18) // Births and deaths. A bigger change is published without a diff, since redrawing the view from scratch is cheaper then.
+
+/* A copy of the live cells of a generation around the view. Once published it never changes, so the render loop can read it while the next generation is computed.
+Only the cells in 'rect' are copied (see 'Simulation::setViewRect()'), so publishing costs as much as the screen shows, not as the whole universe.
+'population' is still of the whole universe. */
+struct GridSnapshot{
+    unsigned long long int id; // Unique among all the snapshots of all the simulations, starting from 1
+    unsigned long long int generation;
+    unsigned long long int population;
+    BoundingBox rect;
+    CellSet cells; // The live cells in 'rect'
+    bool in_cycle; // Whether the pattern has repeated itself by this generation, and if so, how
+    CycleInfo cycle;
+    bool is_at_coordinate_limit; // The simulation stopped here, since the cells would have moved beyond the coordinates we can represent
+    double generations_per_second; // As measured recently
+
+    /* The cells that were born and died (in 'rect') since the snapshot that was published right before this one (the one of 'previous_id'),
+    so whoever drew that one can patch what it drew instead of drawing it all again. Without a diff ('has_diff' is false), they're empty.
+    There's a diff only between snapshots of the same rectangle. */
+    bool has_diff;
+    unsigned long long int previous_id;
+    std::vector<Cell> births, deaths;
+
+    /* Zoomed out, the screen draws squares of cells and not the cells themselves (see 'Simulation::setBlockLevel()').
+    Then 'cells' is empty (and there's no diff), and 'blocks' has the population of every square of 2^block_level x 2^block_level cells
+    that has live cells, by the square's coordinates (see 'Engine::forEachBlock()'). With a 'block_level' of 0 it's the other way around. */
+    int block_level;
+    CellMap<unsigned long long int> blocks;
+};
+
+/* Runs the engine on its own thread, advancing it every 'timestep' milliseconds, and publishes a snapshot after every advance.
+The render loop only ever reads the latest snapshot, so a slow generation doesn't freeze the input (and a slow frame doesn't slow down the simulation).
+The engine belongs to the simulation thread while it runs: anything else may touch it only after 'stop()'.
+
+Every generation is also recorded in a 'CycleDetector', so once the pattern settles into a cycle the snapshots say so,
+and (if 'setStopOnCycle()' is on) the simulation stops by itself - nothing new is going to happen anyway.
+
+In turbo mode there's no timestep: we run as many generations as fit in the frame budget, publish, and go again.
+The budget is for the whole batch, publishing included, so the generations get what the last publish left of it.
+How many generations fit is adapted to the time the recent generations took (so a pattern that grows gets smaller batches).
+With a target rate, we run only as many generations as that rate owes us by now (and sleep when we're ahead of it).
+
+The snapshots are triple-buffered: we fill a buffer nobody holds, and publish it by swapping a shared_ptr atomically.
+A buffer is free again when the render loop lets go of it, so after the first few generations publishing doesn't allocate.
+Once it stops on a cycle, the thread stays around (idle) until 'stop()', only to publish the same generation again if the block level or the view rectangle changes. */
+class Simulation{
+private:
+    std::unique_ptr<Engine>& engine; // A reference to the pointer, since the engine might be replaced between 'stop()' and 'start()'
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake_up; // On a stop, or on a new block level or view rectangle
+    bool is_running;
+    int block_level; // Guarded by 'mutex'
+    BoundingBox view_rect; // Guarded by 'mutex'
+
+    std::atomic<int> timestep; // In milliseconds
+    std::atomic<unsigned long long int> step_size; // Generations per timestep
+    std::atomic<unsigned long long int> generation;
+    std::atomic<bool> stop_on_cycle;
+    std::atomic<bool> turbo;
+    std::atomic<int> frame_budget; // In milliseconds
+    std::atomic<unsigned long long int> target_rate; // Generations per second in turbo mode, or 0 for as many as we can
+
+    // Used only by the simulation thread (and by 'start()', before there is one)
+    CycleDetector cycle_detector;
+    bool in_cycle;
+    bool is_idle; // Stopped on a cycle (or at the coordinate limit): we don't step anymore, but we still publish again on a new block level
+    bool is_at_coordinate_limit;
+    int published_block_level;
+    BoundingBox published_view_rect;
+    CycleInfo cycle;
+    double seconds_per_generation; // Of the last batch, or 0 if we haven't measured yet
+    double seconds_per_publish; // Of the last batch
+    unsigned long long int last_batch;
+    std::chrono::steady_clock::time_point rate_window_start;
+    unsigned long long int rate_window_generation;
+    double generations_per_second;
+
+    std::vector<std::shared_ptr<GridSnapshot>> buffers;
+    std::shared_ptr<const GridSnapshot> published; // Accessed only with 'std::atomic_load()'/'std::atomic_store()'
+
+    bool isRepublishNeeded() const;
+    void publish();
+    unsigned long long int turboBatch() const;
+    void measureRate();
+    void loop();
+
+public:
+    explicit Simulation(std::unique_ptr<Engine>& engine);
+    ~Simulation();
+
+    // 'start()' publishes the current state right away, so there's always a snapshot to draw. The cycle detection starts over,
+    // and the generation counter continues from the engine's.
+    void start();
+    // Returns after the generation that is being computed (if any) is done.
+    void stop();
+
+    void setTimestep(int milliseconds);
+    void setStepSize(unsigned long long int generations);
+    void setStopOnCycle(bool stop);
+    void setTurbo(bool enabled);
+    void setFrameBudget(int milliseconds);
+    // 0 runs as many generations as the frame budget allows.
+    void setTargetRate(unsigned long long int generations_per_second);
+    /* From now on, publish the populations of squares of 2^level x 2^level cells instead of the cells (or the cells, with 0).
+    A zoomed-out screen can't tell the cells apart anyway, and there are a lot fewer squares than cells to copy.
+    The current generation is published again right away, so the screen doesn't wait a timestep for the new detail. */
+    void setBlockLevel(int level);
+    /* From now on, publish only the live cells in 'rect' (at first, all of them are). The screen passes the cells around its view,
+    with a margin, so the simulation copies (and diffs) only what might be drawn, however big the universe is.
+    Like a new block level, the current generation is published again right away, for the new rectangle. */
+    void setViewRect(const BoundingBox& rect);
+    unsigned long long int getGeneration() const;
+
+    std::shared_ptr<const GridSnapshot> latestSnapshot() const;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <climits>
+#include "sparse_engine.h"
+#include "profiler.h"
+
+SparseEngine::SparseEngine(): tracks_signature(false), grid_signature(), is_index_valid(false) { }
+
+void SparseEngine::insert(const Cell& cell){
+    if (!grid.insert(cell)) return;
+
+    is_index_valid = false;
+    if (tracks_signature) addCellToSignature(grid_signature, cell.x, cell.y);
+}
+
+void SparseEngine::erase(const Cell& cell){
+    if (!grid.erase(cell)) return;
+
+    is_index_valid = false;
+    if (tracks_signature) removeCellFromSignature(grid_signature, cell.x, cell.y);
+}
+
+// Growing the set once up front, instead of rehashing it over and over while it fills up.
+void SparseEngine::insertCells(const std::vector<Cell>& cells){
+    grid.reserve(grid.size() + cells.size());
+    for (const auto& cell : cells) insert(cell);
+}
+
+bool SparseEngine::count(const Cell& cell) const{
+    return grid.count(cell);
+}
+
+void SparseEngine::clear(){
+    grid.clear();
+    is_index_valid = false;
+    grid_signature = {};
+    generation = 0;
+}
+
+unsigned long long int SparseEngine::population() const{
+    return grid.size();
+}
+
+void SparseEngine::forEachCell(const std::function<void(const Cell&)>& func) const{
+    grid.forEach(func);
+}
+
+/* A counting sort of the cells by their tiles: we count the cells of every tile, turn the counts into ranges of 'indexed_cells',
+and then put every cell at the end of its tile's range (so in the end, a range's end is where the next range starts). */
+void SparseEngine::buildIndex() const{
+    PROFILE_SCOPE("SparseEngine::buildIndex");
+    tile_ranges.clear();
+    grid.forEach([this](const Cell& cell){ tile_ranges[{cell.x >> 6, cell.y >> 6}].second++; });
+
+    size_t begin = 0;
+    tile_ranges.forEach([&begin](const Cell&, std::pair<size_t, size_t>& range){
+        size_t count = range.second;
+        range = {begin, begin};
+        begin += count;
+    });
+
+    indexed_cells.resize(grid.size());
+    grid.forEach([this](const Cell& cell){
+        std::pair<size_t, size_t>& range = tile_ranges[{cell.x >> 6, cell.y >> 6}];
+        indexed_cells[range.second++] = cell;
+    });
+    is_index_valid = true;
+}
+
+// Like 'TiledEngine::forEachCellInRect()': we look up the tiles the rectangle covers, or go over the tiles we have, whichever are fewer.
+void SparseEngine::forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const{
+    if (rect.right < rect.left || rect.bottom < rect.top) return;
+    if (!is_index_valid) buildIndex();
+
+    int tile_left = rect.left >> 6, tile_top = rect.top >> 6, tile_right = rect.right >> 6, tile_bottom = rect.bottom >> 6;
+    auto visit = [this, &rect, &func](const std::pair<size_t, size_t>& range){
+        for (size_t i = range.first; i < range.second; i++){
+            const Cell& cell = indexed_cells[i];
+            if (rect.left <= cell.x && cell.x <= rect.right && rect.top <= cell.y && cell.y <= rect.bottom) func(cell);
+        }
+    };
+
+    if ((unsigned long long int)((long long int)tile_right - tile_left + 1) * ((long long int)tile_bottom - tile_top + 1) <= tile_ranges.size()){
+        for (int tile_y = tile_top; tile_y <= tile_bottom; tile_y++){
+            for (int tile_x = tile_left; tile_x <= tile_right; tile_x++){
+                const std::pair<size_t, size_t>* range = tile_ranges.find({tile_x, tile_y});
+                if (range) visit(*range);
+            }
+        }
+        return;
+    }
+
+    tile_ranges.forEach([&](const Cell& tile, const std::pair<size_t, size_t>& range){
+        if (tile_left <= tile.x && tile.x <= tile_right && tile_top <= tile.y && tile.y <= tile_bottom) visit(range);
+    });
+}
+
+// Only the tiles at the edges of the tiles' bounding box can hold the extreme cells, so only their cells are looked at.
+BoundingBox SparseEngine::boundingBox() const{
+    if (!is_index_valid) buildIndex();
+
+    BoundingBox tile_box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    tile_ranges.forEach([&tile_box](const Cell& tile, const std::pair<size_t, size_t>&){
+        tile_box.left = std::min(tile_box.left, tile.x);
+        tile_box.top = std::min(tile_box.top, tile.y);
+        tile_box.right = std::max(tile_box.right, tile.x);
+        tile_box.bottom = std::max(tile_box.bottom, tile.y);
+    });
+
+    BoundingBox box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    tile_ranges.forEach([this, &tile_box, &box](const Cell& tile, const std::pair<size_t, size_t>& range){
+        if (tile.x != tile_box.left && tile.x != tile_box.right && tile.y != tile_box.top && tile.y != tile_box.bottom) return;
+
+        for (size_t i = range.first; i < range.second; i++){
+            box.left = std::min(box.left, indexed_cells[i].x);
+            box.top = std::min(box.top, indexed_cells[i].y);
+            box.right = std::max(box.right, indexed_cells[i].x);
+            box.bottom = std::max(box.bottom, indexed_cells[i].y);
+        }
+    });
+
+    return box;
+}
+
+StateSignature SparseEngine::signature(){
+    if (!tracks_signature){
+        grid_signature = Engine::signature();
+        tracks_signature = true;
+    }
+
+    return grid_signature;
+}
+
+// This function adds the Moore neighborhood of every cell (including itself) to the map.
+void SparseEngine::addNeighbors(CellMap<short int>& m) const{
+    PROFILE_SCOPE("SparseEngine::addNeighbors");
+    grid.forEach([&m](const Cell& coordinate){
+
+        for (int k = coordinate.y - 1; k <= coordinate.y + 1; k++){
+            for (int p = coordinate.x - 1; p <= coordinate.x + 1; p++){
+                m[{p, k}]++;
+            }
+        }
+    });
+}
+
+// Apply rules based on chosen automaton's 'born' and 'survive' digits (compiled into a table of [state][neighbors] -> next state).
+// The cells that are live in the next generation go to 'next_grid', which then becomes the grid.
+// On the way, if the signature is tracked, we update it with the births and deaths (the cells whose state changes), so it never needs a rescan.
+void SparseEngine::applyRules(const CellMap<short int>& m){
+    PROFILE_SCOPE("SparseEngine::applyRules");
+    next_grid.clear();
+    next_grid.reserve(grid.size());
+
+    m.forEach([this](const Cell& coordinate, short int amount){
+        bool is_curr_cell_live = grid.count(coordinate);
+        // We subtract 'is_curr_cell_live', because a *live* cell also counts itself in 'm'.
+        bool is_next_cell_live = rule.nextState(is_curr_cell_live, amount - is_curr_cell_live);
+        if (is_next_cell_live) next_grid.insert(coordinate);
+
+        if (!tracks_signature) return;
+        if (is_next_cell_live && !is_curr_cell_live) addCellToSignature(grid_signature, coordinate.x, coordinate.y);
+        else if (!is_next_cell_live && is_curr_cell_live) removeCellFromSignature(grid_signature, coordinate.x, coordinate.y);
+    });
+
+    std::swap(grid, next_grid);
+    is_index_valid = false;
+}
+
+/* Update the grid to next generation. The algorithm is as follows:
+1) Take the set of lives cells (grid), and for every cell:
+Add itself and its neighbors to a map that maps coordinate to number of appearances.
+*Adding *itself* is crucial, for cells without neighbors, for example.
+2) Iterate over the map s.t. for every coordinate with 'k' appearances:
+If it's live and fulfills the 'survive' rule, or it's dead and fulfills the 'burn' rule - insert it to the next grid.
+*In previous versions, when we only had Game of Life, this is what we did:
+(I'm saving it because I really like this solution; and also because it's my project, and I can do whatever I want):
+"If a cell appears 3 times (has been added 3 times), add it to the new set.
+If a cell appears 4 times *and is live*, add it to the new set.
+The new set is the new generation. Swap it with grid.
+Explanation: in order for a cell to be live in next gen, it needs to be:
+-Live with 2 neighbors or dead with 3 neighbors - in this case it will appear 3 times.
+-Live with 3 neighbors - in this case it will be *live* and appear 4 times."
+
+Let's denote p = number of live cells. So:
+Time complexity: O(9p + 9p)=O(p). Space complexity: O(9p + 9p)=O(p).
+This is a lot more efficient than our previous algorithm, which was in time O(n^2) and space O(1).
+Although space was O(1) (because it's about *additional* space, and we did it in-place),
+we still had to rely on an O(n^2) matrix, so overall this algorithm is superior*.
+*With the caveat that a matrix is contiguous in memory, so under certain architecture with certain caches, it might be faster. */
+void SparseEngine::step(){
+    /* Back when this was a local std::unordered_map, after a shitload of tests and plotting in Matlab, I've come to the conclusion that:
+    -reserving in advance 1.015 times the previous size improves performance.
+    -Tinkering with max_load_factor doesn't do a whole lot.
+    Now the map is a member that keeps its storage between generations, so it's already as big as last generation needed. */
+    coordinate_to_amount.clear();
+
+    // Note for self: from testing, 'addNeighbors()' takes ~75% of function's runtime, while 'applyRules()' takes ~25%.
+    // The costly operation is accessing the map, not iterating over all the neighbors.
+    addNeighbors(coordinate_to_amount);
+    applyRules(coordinate_to_amount);
+    generation++;
+}
@@ -0,0 +1,47 @@
+#ifndef GAME_OF_LIFE_SPARSE_ENGINE_H
+#define GAME_OF_LIFE_SPARSE_ENGINE_H
+
+#include <utility>
+#include <vector>
+#include "engine.h"
+#include "flat_cell_table.h"
+
+class SparseEngine: public Engine{
+private:
+    // We implement the grid using a sparse matrix - which is just a set that stores only the *live cells*.
+    // Thus, the space complexity reduces from O(n^2) to O(num of live cells).
+    CellSet grid;
+    bool tracks_signature; // Whether 'signature()' has been called, and so 'grid_signature' is updated on every insertion and removal from 'grid'
+    StateSignature grid_signature;
+    // The tables 'step()' fills. They're members, and not locals, so their storage is reused by every generation.
+    CellSet next_grid;
+    CellMap<short int> coordinate_to_amount; // Maps a coordinate to amount of times it has been added.
+
+    /* A directory of the live cells by their 64x64 tiles, so 'forEachCellInRect()' and 'boundingBox()' don't go over the whole set.
+    It's built on the first query after the cells change (and every step changes them), so runs that never ask don't pay for it. */
+    mutable bool is_index_valid;
+    mutable CellMap<std::pair<size_t, size_t>> tile_ranges; // Maps a tile to the range of its cells in 'indexed_cells'
+    mutable std::vector<Cell> indexed_cells; // Grouped by tile
+
+    void addNeighbors(CellMap<short int>& m) const;
+    void applyRules(const CellMap<short int>& m);
+    void buildIndex() const;
+
+public:
+    SparseEngine();
+
+    void insert(const Cell& cell) override;
+    void erase(const Cell& cell) override;
+    void insertCells(const std::vector<Cell>& cells) override;
+    bool count(const Cell& cell) const override;
+    void clear() override;
+    unsigned long long int population() const override;
+    void forEachCell(const std::function<void(const Cell&)>& func) const override;
+    void forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const override;
+    BoundingBox boundingBox() const override;
+    StateSignature signature() override;
+
+    void step() override;
+};
+
+#endif
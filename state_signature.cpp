@@ -0,0 +1,60 @@
+#include "state_signature.h"
+
+#define POWER_TABLE_BITS 11 // 3 tables of 2^11 powers cover every exponent up to 2^33, which is more than any int coordinate
+
+// Square-and-multiply, for the exponents the tables don't cover.
+static uint64_t power(uint64_t base, unsigned long long int exponent){
+    uint64_t result = 1;
+    for (; exponent; exponent >>= 1){
+        if (exponent & 1) result = hashMultiply(result, base);
+        base = hashMultiply(base, base);
+    }
+
+    return result;
+}
+
+// The inverse (mod 2^61 - 1), by Fermat's little theorem: for a prime p, a^(p - 1) = 1, so a^(p - 2) is the inverse of a.
+static uint64_t inverse(uint64_t base){
+    return power(base, STATE_HASH_MODULUS - 2);
+}
+
+/* The powers are computed on every birth and death, so they'd better be cheap: an exponent is split into 3 chunks of bits,
+and its power is the product of the 3 chunks' powers, which are looked up. */
+class PowerTable{
+private:
+    uint64_t powers[3][1 << POWER_TABLE_BITS];
+
+public:
+    explicit PowerTable(uint64_t base){
+        for (int chunk = 0; chunk < 3; chunk++){
+            uint64_t chunk_base = power(base, 1ULL << (chunk * POWER_TABLE_BITS));
+            powers[chunk][0] = 1;
+            for (int i = 1; i < (1 << POWER_TABLE_BITS); i++) powers[chunk][i] = hashMultiply(powers[chunk][i - 1], chunk_base);
+        }
+    }
+
+    uint64_t operator()(unsigned long long int exponent) const{
+        const unsigned long long int mask = (1 << POWER_TABLE_BITS) - 1;
+        return hashMultiply(hashMultiply(powers[0][exponent & mask], powers[1][exponent >> POWER_TABLE_BITS & mask]), powers[2][exponent >> (2 * POWER_TABLE_BITS) & mask]);
+    }
+};
+
+static const uint64_t inverse_x = inverse(STATE_HASH_BASE_X), inverse_y = inverse(STATE_HASH_BASE_Y);
+static const PowerTable powers_x(STATE_HASH_BASE_X), inverse_powers_x(inverse_x);
+static const PowerTable powers_y(STATE_HASH_BASE_Y), inverse_powers_y(inverse_y);
+
+static uint64_t hashPower(const PowerTable& powers, const PowerTable& inverse_powers, uint64_t base, uint64_t inverse_base, long long int exponent){
+    // The magnitude as unsigned, so that even the most negative exponent has one
+    unsigned long long int magnitude = exponent < 0 ? 0 - (unsigned long long int)exponent : exponent;
+    if (magnitude >> (3 * POWER_TABLE_BITS) == 0) return exponent < 0 ? inverse_powers(magnitude) : powers(magnitude);
+
+    return power(exponent < 0 ? inverse_base : base, magnitude);
+}
+
+uint64_t hashPowerX(long long int exponent){
+    return hashPower(powers_x, inverse_powers_x, STATE_HASH_BASE_X, inverse_x, exponent);
+}
+
+uint64_t hashPowerY(long long int exponent){
+    return hashPower(powers_y, inverse_powers_y, STATE_HASH_BASE_Y, inverse_y, exponent);
+}
@@ -0,0 +1,84 @@
+#ifndef GAME_OF_LIFE_STATE_SIGNATURE_H
+#define GAME_OF_LIFE_STATE_SIGNATURE_H
+
+#include <cstdint>
+
+#define STATE_HASH_MODULUS 0x1FFFFFFFFFFFFFFFULL // 2^61 - 1, which is prime
+#define STATE_HASH_BASE_X 0x1E3779B97F4A7C15ULL // Both bases must be below the modulus (and not 0), so that they have inverses
+#define STATE_HASH_BASE_Y 0x02B2AE3D27D4EB4FULL
+
+/* A summary of a set of live cells, which the engines keep up to date from the births and deaths of every step
+(so reading it is O(1), and not a scan of the whole universe). 'CycleDetector' compares them to find repeating states.
+
+The hash is the sum (mod 2^61 - 1) of X^x * Y^y over the live cells, so a birth adds its term and a death subtracts it.
+The modulus is a prime: modulo 2^64, sums of powers collide on patterns as simple as a row of cells at the numbers with an odd amount of 1 bits
+against the row at the ones with an even amount (the Thue-Morse sequence), which would make 2 different states look like a cycle.
+Unlike a XOR of random values per cell (Zobrist hashing), it also behaves well under translation:
+moving every cell by (dx, dy) multiplies the hash by X^dx * Y^dy. So 2 states are the same pattern, only moved,
+exactly when their hashes differ by that factor - where (dx, dy) is how far the sums of the coordinates moved, divided by the population.
+The sums of the coordinates wrap around (mod 2^64), which is fine, since we only ever compare them and subtract them. */
+struct StateSignature{
+    uint64_t hash;
+    unsigned long long int population;
+    uint64_t sum_x, sum_y;
+};
+
+// The arithmetic of the hash, on numbers below the modulus
+inline uint64_t hashAdd(uint64_t a, uint64_t b){
+    uint64_t sum = a + b;
+    return sum < STATE_HASH_MODULUS ? sum : sum - STATE_HASH_MODULUS;
+}
+
+inline uint64_t hashSubtract(uint64_t a, uint64_t b){
+    return a < b ? a + STATE_HASH_MODULUS - b : a - b;
+}
+
+// Since 2^61 = 1 (mod 2^61 - 1), the bits of the product above the 61st are simply added to the ones below.
+inline uint64_t hashMultiply(uint64_t a, uint64_t b){
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)a * b;
+    uint64_t folded = ((uint64_t)product & STATE_HASH_MODULUS) + (uint64_t)(product >> 61);
+#else
+    // With 32-bit halves: a * b = high * 2^64 + middle * 2^32 + low, where 2^64 = 8, and the bits of 'middle' from the 29th are worth 2^61 = 1
+    uint64_t a_high = a >> 32, a_low = a & 0xFFFFFFFF, b_high = b >> 32, b_low = b & 0xFFFFFFFF;
+    uint64_t high = a_high * b_high, middle = a_high * b_low + a_low * b_high, low = a_low * b_low;
+    uint64_t sum = (high << 3) + ((middle & 0x1FFFFFFF) << 32) + (middle >> 29) + (low & STATE_HASH_MODULUS) + (low >> 61);
+    uint64_t folded = (sum & STATE_HASH_MODULUS) + (sum >> 61);
+#endif
+    return folded < STATE_HASH_MODULUS ? folded : folded - STATE_HASH_MODULUS;
+}
+
+// X^exponent and Y^exponent (mod 2^61 - 1). A negative exponent is a power of the inverse.
+uint64_t hashPowerX(long long int exponent);
+uint64_t hashPowerY(long long int exponent);
+
+inline void addCellToSignature(StateSignature& signature, long long int x, long long int y){
+    signature.hash = hashAdd(signature.hash, hashMultiply(hashPowerX(x), hashPowerY(y)));
+    signature.population++;
+    signature.sum_x += x;
+    signature.sum_y += y;
+}
+
+inline void removeCellFromSignature(StateSignature& signature, long long int x, long long int y){
+    signature.hash = hashSubtract(signature.hash, hashMultiply(hashPowerX(x), hashPowerY(y)));
+    signature.population--;
+    signature.sum_x -= x;
+    signature.sum_y -= y;
+}
+
+// Adds (or subtracts) the signature of a set of cells whose coordinates are relative to (left, top).
+inline void addSignature(StateSignature& signature, const StateSignature& part, long long int left, long long int top){
+    signature.hash = hashAdd(signature.hash, hashMultiply(part.hash, hashMultiply(hashPowerX(left), hashPowerY(top))));
+    signature.population += part.population;
+    signature.sum_x += part.sum_x + part.population * left;
+    signature.sum_y += part.sum_y + part.population * top;
+}
+
+inline void subtractSignature(StateSignature& signature, const StateSignature& part, long long int left, long long int top){
+    signature.hash = hashSubtract(signature.hash, hashMultiply(part.hash, hashMultiply(hashPowerX(left), hashPowerY(top))));
+    signature.population -= part.population;
+    signature.sum_x -= part.sum_x + part.population * left;
+    signature.sum_y -= part.sum_y + part.population * top;
+}
+
+#endif
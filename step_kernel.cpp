@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include "step_kernel.h"
+#include "step_kernel_names.h"
+#if defined(GOL_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static bool is_level_forced = false;
+static simd_level forced_level = SIMD_SCALAR;
+
+// Asks the CPU (with CPUID) which instruction sets it supports. On non-x86 builds there's only the scalar kernel.
+simd_level detectSimdLevel(){
+#if defined(GOL_X86_KERNELS) && defined(_MSC_VER)
+    // With MSVC we have to query CPUID ourselves, and also check (with XGETBV) that the OS saves the wide registers on context switch.
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool os_saves_registers = info[2] >> 27 & 1;
+    unsigned long long enabled_registers = os_saves_registers ? _xgetbv(0) : 0;
+
+    bool avx2 = false, avx512 = false;
+    if (7 <= max_leaf){
+        __cpuidex(info, 7, 0);
+        avx2 = info[1] >> 5 & 1;
+        avx512 = info[1] >> 16 & 1;
+    }
+
+    if (avx512 && (enabled_registers & 0xE6) == 0xE6) return SIMD_AVX512; // XMM, YMM and the 3 AVX-512 register states
+    if (avx2 && (enabled_registers & 0x6) == 0x6) return SIMD_AVX2; // XMM and YMM register states
+    return SIMD_SSE2;
+#elif defined(GOL_X86_KERNELS)
+    // GCC and Clang do all of the above (including the OS check) for us
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    return SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+// Forcing a level the CPU doesn't support would crash on the first step, so we never go above the detected level.
+simd_level selectedSimdLevel(){
+    static const simd_level detected_level = detectSimdLevel();
+
+    simd_level level = detected_level;
+    if (is_level_forced) level = forced_level;
+    else if (const char* env = std::getenv("GOL_SIMD")){
+        parseSimdLevel(env, level);
+    }
+
+    return level < detected_level ? level : detected_level;
+}
+
+void forceSimdLevel(simd_level level){
+    is_level_forced = true;
+    forced_level = level;
+}
+
+bool parseSimdLevel(const std::string& name, simd_level& level){
+    if (name == "scalar") level = SIMD_SCALAR;
+    else if (name == "sse2") level = SIMD_SSE2;
+    else if (name == "avx2") level = SIMD_AVX2;
+    else if (name == "avx512") level = SIMD_AVX512;
+    else return false;
+
+    return true;
+}
+
+std::string simdLevelName(simd_level level){
+    switch (level){
+        case SIMD_SSE2: return "sse2";
+        case SIMD_AVX2: return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+step_kernel getStepKernel(simd_level level, uint16_t born_mask, uint16_t survive_mask){
+#ifdef GOL_X86_KERNELS
+    switch (level){
+        case SIMD_SSE2: return selectKernelSse2(born_mask, survive_mask);
+        case SIMD_AVX2: return selectKernelAvx2(born_mask, survive_mask);
+        case SIMD_AVX512: return selectKernelAvx512(born_mask, survive_mask);
+        default: break;
+    }
+#endif
+    return selectKernelScalar(born_mask, survive_mask);
+}
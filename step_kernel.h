@@ -0,0 +1,33 @@
+#ifndef GAME_OF_LIFE_STEP_KERNEL_H
+#define GAME_OF_LIFE_STEP_KERNEL_H
+
+#include <cstdint>
+
+/* The inner loop of 'TiledEngine' - advancing the 64 rows of a tile - is pure bitwise logic, so it maps well onto SIMD registers.
+We compile a version of it for every instruction set, each in its own translation unit (with its own compiler flags),
+and pick the best one the CPU supports at runtime, so the same binary runs everywhere.
+
+A kernel gets 3 arrays of 'TILE_SIZE + 2' rows (the tile's rows plus one row above and one below):
+'center' are the rows themselves, and 'left'/'right' are the rows shifted so that bit 'i' holds the cell to the left/right of cell 'i'.
+It writes the next generation of the 'TILE_SIZE' middle rows into 'next'. */
+typedef void (*step_kernel)(const uint64_t* left, const uint64_t* center, const uint64_t* right, uint64_t* next,
+                            uint16_t born_mask, uint16_t survive_mask);
+
+// Ordered from weakest to strongest
+enum simd_level {SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512};
+
+simd_level detectSimdLevel();
+// The level the engines use: the detected one, unless it was forced lower (with 'forceSimdLevel()' or the GOL_SIMD environment variable).
+simd_level selectedSimdLevel();
+void forceSimdLevel(simd_level level);
+/* Every built-in automaton has a kernel of its own with the rule compiled in (see 'BUILTIN_RULES' in 'step_kernel_impl.h'),
+and any other rule gets the generic kernel, which reads the masks it's given. */
+step_kernel getStepKernel(simd_level level, uint16_t born_mask, uint16_t survive_mask);
+
+// The dispatch tables of the instruction sets. The x86 ones exist only when building for x86.
+step_kernel selectKernelScalar(uint16_t born_mask, uint16_t survive_mask);
+step_kernel selectKernelSse2(uint16_t born_mask, uint16_t survive_mask);
+step_kernel selectKernelAvx2(uint16_t born_mask, uint16_t survive_mask);
+step_kernel selectKernelAvx512(uint16_t born_mask, uint16_t survive_mask);
+
+#endif
@@ -0,0 +1,22 @@
+#include <immintrin.h>
+#include "step_kernel.h"
+#include "step_kernel_impl.h"
+
+// 4 rows (256 cells) per operation. This file is compiled with AVX2 enabled, and it's only called if the CPU supports it.
+struct Avx2Ops{
+    typedef __m256i Vec;
+    static const int ROWS = 4;
+
+    static Vec load(const uint64_t* ptr) { return _mm256_loadu_si256((const __m256i*)ptr); }
+    static void store(uint64_t* ptr, Vec vec) { _mm256_storeu_si256((__m256i*)ptr, vec); }
+    static Vec zero() { return _mm256_setzero_si256(); }
+    static Vec allOnes() { return _mm256_set1_epi32(-1); }
+    static Vec bitAnd(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    static Vec bitOr(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    static Vec bitXor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+    static Vec andNot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+    static Vec xor3(Vec a, Vec b, Vec c) { return bitXor(bitXor(a, b), c); }
+    static Vec majority(Vec a, Vec b, Vec c) { return bitOr(bitAnd(a, b), bitAnd(c, bitXor(a, b))); }
+};
+
+DEFINE_KERNEL_SELECTOR(Avx2Ops, selectKernelAvx2)
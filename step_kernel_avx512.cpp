@@ -0,0 +1,23 @@
+#include <immintrin.h>
+#include "step_kernel.h"
+#include "step_kernel_impl.h"
+
+/* 8 rows (512 cells) per operation. This file is compiled with AVX-512F enabled, and it's only called if the CPU supports it.
+AVX-512 has a 3-input logic instruction (the immediate is the truth table of the function), so a full adder is 2 instructions. */
+struct Avx512Ops{
+    typedef __m512i Vec;
+    static const int ROWS = 8;
+
+    static Vec load(const uint64_t* ptr) { return _mm512_loadu_si512((const void*)ptr); }
+    static void store(uint64_t* ptr, Vec vec) { _mm512_storeu_si512((void*)ptr, vec); }
+    static Vec zero() { return _mm512_setzero_si512(); }
+    static Vec allOnes() { return _mm512_set1_epi32(-1); }
+    static Vec bitAnd(Vec a, Vec b) { return _mm512_and_si512(a, b); }
+    static Vec bitOr(Vec a, Vec b) { return _mm512_or_si512(a, b); }
+    static Vec bitXor(Vec a, Vec b) { return _mm512_xor_si512(a, b); }
+    static Vec andNot(Vec a, Vec b) { return _mm512_andnot_si512(a, b); }
+    static Vec xor3(Vec a, Vec b, Vec c) { return _mm512_ternarylogic_epi64(a, b, c, 0x96); }
+    static Vec majority(Vec a, Vec b, Vec c) { return _mm512_ternarylogic_epi64(a, b, c, 0xE8); }
+};
+
+DEFINE_KERNEL_SELECTOR(Avx512Ops, selectKernelAvx512)
@@ -0,0 +1,169 @@
+#ifndef GAME_OF_LIFE_STEP_KERNEL_IMPL_H
+#define GAME_OF_LIFE_STEP_KERNEL_IMPL_H
+
+#include <cstdint>
+#include "step_kernel.h"
+
+/* The body of all the kernels, written once over an 'Ops' class that wraps a register type ('Ops::Vec') holding 'Ops::ROWS' rows.
+Every instruction set provides its own 'Ops' in its own translation unit.
+Note: this header is included in translation units compiled with AVX flags, so it must not pull in any inline code
+that might be shared with the rest of the program (like the standard library) - the linker could pick the AVX copy of it. */
+
+// The built-in automata of 'AutomatonMenuScreen', as (born digits, survive digits). Each one gets its own compiled kernel.
+// 'X' is called with 'ARG' passed through as its first argument.
+#define BUILTIN_RULES(X, ARG) \
+    X(ARG, "3", "23") /* Game of Life */ \
+    X(ARG, "3", "012345678") /* Life without Death */ \
+    X(ARG, "36", "23") /* HighLife */ \
+    X(ARG, "3678", "34678") /* Day and Night */ \
+    X(ARG, "2", "") /* Seeds */ \
+    X(ARG, "1", "012345678") /* H-trees */ \
+    X(ARG, "1357", "1357") /* Replicator */ \
+    X(ARG, "2", "0") /* Live Free or Die */ \
+    X(ARG, "234", "") /* Serviettes */ \
+    X(ARG, "25678", "5678") /* Iceballs */ \
+    X(ARG, "3", "023") /* DotLife */ \
+    X(ARG, "3", "12") /* Flock */ \
+    X(ARG, "3", "12345") /* Maze */ \
+    X(ARG, "3", "45678") /* Coral */ \
+    X(ARG, "35", "23") /* Grounded Life */ \
+    X(ARG, "357", "238") /* Pseudo Life */ \
+    X(ARG, "368", "245") /* Morley */
+
+constexpr uint16_t digitsMask(const char* digits){
+    uint16_t mask = 0;
+    for (; *digits; digits++) mask |= 1 << (*digits - '0');
+
+    return mask;
+}
+
+// The rule of a specialized kernel, known at compile time.
+template <uint16_t BORN, uint16_t SURVIVE>
+struct FixedRuleMasks{
+    static constexpr uint16_t born = BORN;
+    static constexpr uint16_t survive = SURVIVE;
+};
+// The rule of the generic kernel (for custom rulestrings), known only at runtime.
+struct RuntimeRuleMasks{
+    uint16_t born, survive;
+};
+
+// The mask of the cells that have exactly 'K' neighbors.
+template <class Ops, int K>
+inline typename Ops::Vec equalCount(typename Ops::Vec count0, typename Ops::Vec count1, typename Ops::Vec count2, typename Ops::Vec count3){
+    const typename Ops::Vec ones = Ops::allOnes();
+    return Ops::bitAnd(Ops::bitAnd(K & 1 ? count0 : Ops::bitXor(count0, ones), K & 2 ? count1 : Ops::bitXor(count1, ones)),
+                       Ops::bitAnd(K & 4 ? count2 : Ops::bitXor(count2, ones), K & 8 ? count3 : Ops::bitXor(count3, ones)));
+}
+
+/* The mask of the cells whose neighbor count is one of the digits in 'MASK'.
+It's unrolled at compile time, so only the counts that are in the rule cost anything; e.g. for Life, the compiler is left with
+"count == 3 || (alive && count == 2)", and the common sub-expressions of the 2 comparisons are computed once. */
+template <class Ops, uint16_t MASK, int K = 0>
+inline typename Ops::Vec matchCounts(typename Ops::Vec count0, typename Ops::Vec count1, typename Ops::Vec count2, typename Ops::Vec count3){
+    if constexpr (8 < K) return Ops::zero();
+    else if constexpr (MASK >> K & 1){
+        return Ops::bitOr(equalCount<Ops, K>(count0, count1, count2, count3), matchCounts<Ops, MASK, K + 1>(count0, count1, count2, count3));
+    }
+    else return matchCounts<Ops, MASK, K + 1>(count0, count1, count2, count3);
+}
+
+template <class Ops, uint16_t BORN, uint16_t SURVIVE>
+inline void matchRule(FixedRuleMasks<BORN, SURVIVE>, typename Ops::Vec count0, typename Ops::Vec count1, typename Ops::Vec count2,
+                      typename Ops::Vec count3, typename Ops::Vec& born, typename Ops::Vec& survive){
+    born = matchCounts<Ops, BORN>(count0, count1, count2, count3);
+    survive = matchCounts<Ops, SURVIVE>(count0, count1, count2, count3);
+}
+
+template <class Ops>
+inline void matchRule(RuntimeRuleMasks masks, typename Ops::Vec count0, typename Ops::Vec count1, typename Ops::Vec count2,
+                      typename Ops::Vec count3, typename Ops::Vec& born, typename Ops::Vec& survive){
+    const typename Ops::Vec ones = Ops::allOnes();
+    born = Ops::zero();
+    survive = Ops::zero();
+
+    for (int k = 0; k <= 8; k++){
+        if (!((masks.born | masks.survive) >> k & 1)) continue;
+
+        typename Ops::Vec equal = Ops::bitAnd(Ops::bitAnd(k & 1 ? count0 : Ops::bitXor(count0, ones), k & 2 ? count1 : Ops::bitXor(count1, ones)),
+                                              Ops::bitAnd(k & 4 ? count2 : Ops::bitXor(count2, ones), k & 8 ? count3 : Ops::bitXor(count3, ones)));
+        if (masks.born >> k & 1) born = Ops::bitOr(born, equal);
+        if (masks.survive >> k & 1) survive = Ops::bitOr(survive, equal);
+    }
+}
+
+/* Counting the neighbors: the 8 neighbors of the cells of row 'r' are 8 words (left, center and right of rows 'r-1' and 'r+1',
+and left and right of row 'r'). We add them with full adders (just like in hardware), where every bit position is a separate addition.
+The result is the neighbor count of every cell as 4 bit-planes: 'count0' holds bit 0 of every count, 'count1' holds bit 1, and so on. */
+template <class Ops, class Masks>
+inline void stepRowsImpl(const uint64_t* left, const uint64_t* center, const uint64_t* right, uint64_t* next, Masks masks){
+    typedef typename Ops::Vec Vec;
+
+    for (int i = 1; i <= 64; i += Ops::ROWS){
+        Vec above_left = Ops::load(left + i - 1), above_center = Ops::load(center + i - 1), above_right = Ops::load(right + i - 1);
+        Vec below_left = Ops::load(left + i + 1), below_center = Ops::load(center + i + 1), below_right = Ops::load(right + i + 1);
+        Vec side_left = Ops::load(left + i), side_right = Ops::load(right + i);
+        Vec self = Ops::load(center + i);
+
+        // Full adders of the row above and the row below (ones digit, and the carry), and a half adder of the cells to the sides.
+        Vec above_ones = Ops::xor3(above_left, above_center, above_right);
+        Vec above_twos = Ops::majority(above_left, above_center, above_right);
+        Vec below_ones = Ops::xor3(below_left, below_center, below_right);
+        Vec below_twos = Ops::majority(below_left, below_center, below_right);
+        Vec sides_ones = Ops::bitXor(side_left, side_right);
+        Vec sides_twos = Ops::bitAnd(side_left, side_right);
+
+        // Adding the 3 ones digits, and then the 4 twos digits (3 from the adders above, and 1 carry)
+        Vec count0 = Ops::xor3(above_ones, below_ones, sides_ones);
+        Vec ones_carry = Ops::majority(above_ones, below_ones, sides_ones);
+        Vec twos_sum = Ops::xor3(above_twos, below_twos, sides_twos);
+        Vec twos_carry = Ops::majority(above_twos, below_twos, sides_twos);
+        Vec count1 = Ops::bitXor(twos_sum, ones_carry);
+        Vec fours = Ops::bitAnd(twos_sum, ones_carry);
+        Vec count2 = Ops::bitXor(twos_carry, fours);
+        Vec count3 = Ops::bitAnd(twos_carry, fours); // Only when all 8 neighbors are live
+
+        Vec born, survive;
+        matchRule<Ops>(masks, count0, count1, count2, count3, born, survive);
+        Ops::store(next + i - 1, Ops::bitOr(Ops::bitAnd(self, survive), Ops::andNot(self, born)));
+    }
+}
+
+template <class Ops>
+void stepRowsGeneric(const uint64_t* left, const uint64_t* center, const uint64_t* right, uint64_t* next, uint16_t born_mask, uint16_t survive_mask){
+    stepRowsImpl<Ops>(left, center, right, next, RuntimeRuleMasks{born_mask, survive_mask});
+}
+
+// The masks are baked into the template, so the arguments are ignored.
+template <class Ops, uint16_t BORN, uint16_t SURVIVE>
+void stepRowsFixed(const uint64_t* left, const uint64_t* center, const uint64_t* right, uint64_t* next, uint16_t, uint16_t){
+    stepRowsImpl<Ops>(left, center, right, next, FixedRuleMasks<BORN, SURVIVE>());
+}
+
+struct SpecializedKernel{
+    uint16_t born_mask, survive_mask;
+    step_kernel kernel;
+};
+
+#define SPECIALIZED_KERNEL_ENTRY(OPS, BORN, SURVIVE) {digitsMask(BORN), digitsMask(SURVIVE), stepRowsFixed<OPS, digitsMask(BORN), digitsMask(SURVIVE)>},
+
+/* The dispatch table of an instruction set: returns the specialized kernel of the rule if it's a built-in one, or the generic kernel otherwise.
+Every instruction set's translation unit defines its own with this macro. */
+template <class Ops>
+step_kernel selectKernel(const SpecializedKernel* table, int table_size, uint16_t born_mask, uint16_t survive_mask){
+    for (int i = 0; i < table_size; i++){
+        if (table[i].born_mask == born_mask && table[i].survive_mask == survive_mask) return table[i].kernel;
+    }
+
+    return stepRowsGeneric<Ops>;
+}
+
+#define DEFINE_KERNEL_SELECTOR(OPS, SELECTOR_NAME) \
+    static const SpecializedKernel OPS##_table[] = { \
+        BUILTIN_RULES(SPECIALIZED_KERNEL_ENTRY, OPS) \
+    }; \
+    step_kernel SELECTOR_NAME(uint16_t born_mask, uint16_t survive_mask){ \
+        return selectKernel<OPS>(OPS##_table, sizeof(OPS##_table) / sizeof(OPS##_table[0]), born_mask, survive_mask); \
+    }
+
+#endif
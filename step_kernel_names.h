@@ -0,0 +1,13 @@
+#ifndef GAME_OF_LIFE_STEP_KERNEL_NAMES_H
+#define GAME_OF_LIFE_STEP_KERNEL_NAMES_H
+
+#include <string>
+#include "step_kernel.h"
+
+/* The names of the instruction sets ("scalar", "sse2", "avx2", "avx512"), for the GOL_SIMD environment variable and the headless tools.
+They're apart from 'step_kernel.h' because that one is included by the kernels' translation units, which must not include the standard library
+(see 'step_kernel_impl.h'). */
+bool parseSimdLevel(const std::string& name, simd_level& level);
+std::string simdLevelName(simd_level level);
+
+#endif
@@ -0,0 +1,21 @@
+#include "step_kernel.h"
+#include "step_kernel_impl.h"
+
+// One row (64 cells) per operation. This is the fallback for CPUs without any of the SIMD instruction sets we support.
+struct ScalarOps{
+    typedef uint64_t Vec;
+    static const int ROWS = 1;
+
+    static Vec load(const uint64_t* ptr) { return *ptr; }
+    static void store(uint64_t* ptr, Vec vec) { *ptr = vec; }
+    static Vec zero() { return 0; }
+    static Vec allOnes() { return ~(uint64_t)0; }
+    static Vec bitAnd(Vec a, Vec b) { return a & b; }
+    static Vec bitOr(Vec a, Vec b) { return a | b; }
+    static Vec bitXor(Vec a, Vec b) { return a ^ b; }
+    static Vec andNot(Vec a, Vec b) { return ~a & b; }
+    static Vec xor3(Vec a, Vec b, Vec c) { return a ^ b ^ c; }
+    static Vec majority(Vec a, Vec b, Vec c) { return (a & b) | (c & (a ^ b)); }
+};
+
+DEFINE_KERNEL_SELECTOR(ScalarOps, selectKernelScalar)
@@ -0,0 +1,22 @@
+#include <emmintrin.h>
+#include "step_kernel.h"
+#include "step_kernel_impl.h"
+
+// 2 rows (128 cells) per operation. SSE2 is part of every x86-64 CPU.
+struct Sse2Ops{
+    typedef __m128i Vec;
+    static const int ROWS = 2;
+
+    static Vec load(const uint64_t* ptr) { return _mm_loadu_si128((const __m128i*)ptr); }
+    static void store(uint64_t* ptr, Vec vec) { _mm_storeu_si128((__m128i*)ptr, vec); }
+    static Vec zero() { return _mm_setzero_si128(); }
+    static Vec allOnes() { return _mm_set1_epi32(-1); }
+    static Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    static Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static Vec bitXor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+    static Vec andNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+    static Vec xor3(Vec a, Vec b, Vec c) { return bitXor(bitXor(a, b), c); }
+    static Vec majority(Vec a, Vec b, Vec c) { return bitOr(bitAnd(a, b), bitAnd(c, bitXor(a, b))); }
+};
+
+DEFINE_KERNEL_SELECTOR(Sse2Ops, selectKernelSse2)
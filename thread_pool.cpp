@@ -0,0 +1,101 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int thread_count): job(nullptr), remaining_tasks(0), job_id(0), stopping(false) {
+    if (thread_count < 1) thread_count = 1;
+
+    for (int i = 0; i < thread_count; i++) queues.push_back(std::make_unique<TaskQueue>());
+    for (int i = 1; i < thread_count; i++) threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+
+    for (auto& thread : threads) thread.join();
+}
+
+int ThreadPool::getThreadCount() const{
+    return queues.size();
+}
+
+// Takes a task from the front of the worker's own queue, or steals one from the back of another queue.
+bool ThreadPool::popTask(int worker, size_t& task){
+    {
+        TaskQueue& own_queue = *queues[worker];
+        std::lock_guard<std::mutex> lock(own_queue.mutex);
+        if (!own_queue.tasks.empty()){
+            task = own_queue.tasks.front();
+            own_queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); i++){
+        TaskQueue& victim_queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim_queue.mutex);
+        if (!victim_queue.tasks.empty()){
+            task = victim_queue.tasks.back();
+            victim_queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runTasks(int worker){
+    size_t task;
+    while (popTask(worker, task)){
+        (*job.load())(task, worker);
+
+        if (--remaining_tasks == 0){
+            std::lock_guard<std::mutex> lock(mutex);
+            job_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(int worker){
+    unsigned long long int last_job_id = 0;
+
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [&](){ return stopping || job_id != last_job_id; });
+            if (stopping) return;
+            last_job_id = job_id;
+        }
+
+        runTasks(worker);
+    }
+}
+
+void ThreadPool::parallelFor(size_t task_count, const std::function<void(size_t, int)>& func){
+    if (task_count == 0) return;
+
+    // The job must be published before its tasks, since a worker can pop a task as soon as it's in a queue.
+    job = &func;
+    remaining_tasks = task_count;
+
+    // Worker 'i' gets the 'i'th contiguous block of tasks, so neighboring tasks (which usually touch neighboring memory) stay together.
+    for (size_t i = 0; i < queues.size(); i++){
+        size_t first = task_count * i / queues.size(), last = task_count * (i + 1) / queues.size();
+
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        for (size_t task = first; task < last; task++) queues[i]->tasks.push_back(task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job_id++;
+    }
+    job_available.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job_done.wait(lock, [&](){ return remaining_tasks == 0; });
+}
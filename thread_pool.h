@@ -0,0 +1,48 @@
+#ifndef GAME_OF_LIFE_THREAD_POOL_H
+#define GAME_OF_LIFE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A persistent pool of worker threads, with work-stealing.
+'parallelFor()' splits the tasks evenly between the queues of the workers (the calling thread is worker 0, so it works too).
+Every worker takes tasks from the front of its own queue, and when it runs out, it steals from the back of the others' queues;
+so a worker that got the expensive tasks doesn't hold everyone else back.
+The threads are created once, and sleep between jobs, so a job costs a wake-up and not a thread creation. */
+class ThreadPool{
+private:
+    struct TaskQueue{
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<TaskQueue>> queues; // One per worker
+    std::atomic<const std::function<void(size_t, int)>*> job;
+    std::atomic<size_t> remaining_tasks;
+
+    std::mutex mutex;
+    std::condition_variable job_available, job_done;
+    unsigned long long int job_id;
+    bool stopping;
+
+    bool popTask(int worker, size_t& task);
+    void runTasks(int worker);
+    void workerLoop(int worker);
+
+public:
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+
+    int getThreadCount() const;
+    // Calls 'func(task, worker)' for every task in [0, task_count), and returns when all of them are done.
+    void parallelFor(size_t task_count, const std::function<void(size_t, int)>& func);
+};
+
+#endif
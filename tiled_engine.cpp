@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "tiled_engine.h"
+#include "bit_utils.h"
+#include "profiler.h"
+
+static const Tile empty_tile = {};
+
+// By default we use all the cores.
+TiledEngine::TiledEngine(): live_cells(0), tracks_signature(false), cells_signature(), kernel(getStepKernel(selectedSimdLevel(), rule.getBornMask(), rule.getSurviveMask())),
+                            full_steps(FULL_STEPS_AFTER_EDIT) {
+    setThreadCount(std::thread::hardware_concurrency());
+}
+
+// The kernel is looked up once here, and not on every step.
+void TiledEngine::setRule(const Rule& new_rule){
+    Engine::setRule(new_rule);
+    kernel = getStepKernel(selectedSimdLevel(), rule.getBornMask(), rule.getSurviveMask());
+    invalidateTracking();
+}
+
+void TiledEngine::setThreadCount(int thread_count){
+    if (thread_count <= 1) thread_pool.reset();
+    else if (!thread_pool || thread_pool->getThreadCount() != thread_count) thread_pool = std::make_unique<ThreadPool>(thread_count);
+}
+
+// Packs the 2 tile coordinates into a single key, which is cheaper to hash and compare than a pair.
+uint64_t TiledEngine::tileKey(int tile_x, int tile_y){
+    return (uint64_t)(uint32_t)tile_x << 32 | (uint32_t)tile_y;
+}
+
+// The absolute coordinates of the top-left cell of a tile.
+long long int TiledEngine::tileLeft(uint64_t key){
+    return (long long int)(int32_t)(key >> 32) * TILE_SIZE;
+}
+
+long long int TiledEngine::tileTop(uint64_t key){
+    return (long long int)(int32_t)(uint32_t)key * TILE_SIZE;
+}
+
+// Returns nullptr if the tile isn't allocated (meaning all of its cells are dead, and have been for the last 2 generations).
+const TrackedTile* TiledEngine::findTile(int tile_x, int tile_y) const{
+    auto iter = tiles.find(tileKey(tile_x, tile_y));
+    return iter == tiles.end() ? nullptr : &iter->second;
+}
+
+/* The change tracking relies on every tile being the result of stepping the generation before it (with the current rule).
+Editing cells or changing the rule breaks that, so the next steps compute everything, until the tracking is trustworthy again:
+after the first full step the cells are genuine, and after the second one the previous cells are genuine too. */
+void TiledEngine::invalidateTracking(){
+    full_steps = FULL_STEPS_AFTER_EDIT;
+}
+
+// Note that '>>' on a negative int is an arithmetic shift (in practice, on every compiler we care about),
+// so it rounds towards minus infinity - which is exactly the tile a negative coordinate belongs to.
+void TiledEngine::insert(const Cell& cell){
+    TrackedTile& tile = tiles[tileKey(cell.x >> 6, cell.y >> 6)];
+    uint64_t& row = tile.cells.rows[cell.y & (TILE_SIZE - 1)];
+    uint64_t bit = (uint64_t)1 << (cell.x & (TILE_SIZE - 1));
+    if (row & bit) return;
+
+    row |= bit;
+    tile.population++;
+    live_cells++;
+    if (tracks_signature){
+        addCellToSignature(tile.signature, cell.x & (TILE_SIZE - 1), cell.y & (TILE_SIZE - 1));
+        addCellToSignature(cells_signature, cell.x, cell.y);
+    }
+    invalidateTracking();
+}
+
+/* Consecutive cells of a pattern are usually in the same tile (an RLE file goes row by row), so we look a tile up only when the tile changes.
+Pointers to the elements of an unordered_map stay valid when it grows, so holding on to the tile is fine. */
+void TiledEngine::insertCells(const std::vector<Cell>& cells){
+    uint64_t tile_key = 0;
+    TrackedTile* tile = nullptr;
+
+    for (const auto& cell : cells){
+        uint64_t key = tileKey(cell.x >> 6, cell.y >> 6);
+        if (!tile || key != tile_key){
+            tile = &tiles[key];
+            tile_key = key;
+        }
+
+        uint64_t& row = tile->cells.rows[cell.y & (TILE_SIZE - 1)];
+        uint64_t bit = (uint64_t)1 << (cell.x & (TILE_SIZE - 1));
+        if (row & bit) continue;
+
+        row |= bit;
+        tile->population++;
+        live_cells++;
+        if (tracks_signature){
+            addCellToSignature(tile->signature, cell.x & (TILE_SIZE - 1), cell.y & (TILE_SIZE - 1));
+            addCellToSignature(cells_signature, cell.x, cell.y);
+        }
+    }
+
+    invalidateTracking();
+}
+
+// The tiles are in our own layout, so they're merged in a word at a time.
+void TiledEngine::insertTiles(const BitmapTile* new_tiles, size_t count){
+    for (size_t i = 0; i < count; i++){
+        TrackedTile& tile = tiles[tileKey(new_tiles[i].tile_x, new_tiles[i].tile_y)];
+
+        for (int y = 0; y < TILE_SIZE; y++){
+            uint64_t born = new_tiles[i].rows[y] & ~tile.cells.rows[y];
+            if (born == 0) continue;
+
+            tile.cells.rows[y] |= born;
+            tile.population += popcount64(born);
+            live_cells += popcount64(born);
+            for (; tracks_signature && born; born &= born - 1){
+                int x = countTrailingZeros64(born);
+                addCellToSignature(tile.signature, x, y);
+                addCellToSignature(cells_signature, (long long int)new_tiles[i].tile_x * TILE_SIZE + x, (long long int)new_tiles[i].tile_y * TILE_SIZE + y);
+            }
+        }
+    }
+
+    invalidateTracking();
+}
+
+// A tile that becomes empty is kept until the next step, which drops it (its neighbors still need to know that it changed).
+void TiledEngine::erase(const Cell& cell){
+    auto iter = tiles.find(tileKey(cell.x >> 6, cell.y >> 6));
+    if (iter == tiles.end()) return;
+
+    uint64_t& row = iter->second.cells.rows[cell.y & (TILE_SIZE - 1)];
+    uint64_t bit = (uint64_t)1 << (cell.x & (TILE_SIZE - 1));
+    if (!(row & bit)) return;
+
+    row &= ~bit;
+    iter->second.population--;
+    live_cells--;
+    if (tracks_signature){
+        removeCellFromSignature(iter->second.signature, cell.x & (TILE_SIZE - 1), cell.y & (TILE_SIZE - 1));
+        removeCellFromSignature(cells_signature, cell.x, cell.y);
+    }
+    invalidateTracking();
+}
+
+bool TiledEngine::count(const Cell& cell) const{
+    const TrackedTile* tile = findTile(cell.x >> 6, cell.y >> 6);
+    if (!tile) return false;
+
+    return tile->cells.rows[cell.y & (TILE_SIZE - 1)] >> (cell.x & (TILE_SIZE - 1)) & 1;
+}
+
+void TiledEngine::clear(){
+    tiles.clear();
+    active_keys.clear();
+    live_cells = 0;
+    cells_signature = {};
+    generation = 0;
+    invalidateTracking();
+}
+
+unsigned long long int TiledEngine::population() const{
+    return live_cells;
+}
+
+void TiledEngine::forEachCell(const std::function<void(const Cell&)>& func) const{
+    for (const auto& key_and_tile : tiles){
+        int left = (int32_t)(key_and_tile.first >> 32) * TILE_SIZE, top = (int32_t)(uint32_t)key_and_tile.first * TILE_SIZE;
+
+        for (int i = 0; i < TILE_SIZE; i++){
+            // Iterating only over the set bits of the row, lowest first
+            for (uint64_t row = key_and_tile.second.cells.rows[i]; row; row &= row - 1){
+                func({left + countTrailingZeros64(row), top + i});
+            }
+        }
+    }
+}
+
+/* The tiles are our spatial index: we look up the tiles the rectangle covers (or, if there are more of those than allocated tiles, go over the allocated ones),
+and only the rows and columns of a tile that are inside the rectangle are read, by masking its row words. */
+void TiledEngine::forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const{
+    if (rect.right < rect.left || rect.bottom < rect.top) return;
+
+    int tile_left = rect.left >> 6, tile_top = rect.top >> 6, tile_right = rect.right >> 6, tile_bottom = rect.bottom >> 6;
+    auto visit = [&rect, &func](int tile_x, int tile_y, const TrackedTile& tile){
+        long long int left = (long long int)tile_x * TILE_SIZE, top = (long long int)tile_y * TILE_SIZE;
+        int first_column = (int)std::max<long long int>(0, rect.left - left), last_column = (int)std::min<long long int>(TILE_SIZE - 1, rect.right - left);
+        int first_row = (int)std::max<long long int>(0, rect.top - top), last_row = (int)std::min<long long int>(TILE_SIZE - 1, rect.bottom - top);
+        uint64_t mask = (~(uint64_t)0 >> (TILE_SIZE - 1 - last_column)) & (~(uint64_t)0 << first_column);
+
+        for (int i = first_row; i <= last_row; i++){
+            for (uint64_t row = tile.cells.rows[i] & mask; row; row &= row - 1) func({(int)(left + countTrailingZeros64(row)), (int)(top + i)});
+        }
+    };
+
+    if ((unsigned long long int)((long long int)tile_right - tile_left + 1) * ((long long int)tile_bottom - tile_top + 1) <= tiles.size()){
+        for (int tile_y = tile_top; tile_y <= tile_bottom; tile_y++){
+            for (int tile_x = tile_left; tile_x <= tile_right; tile_x++){
+                const TrackedTile* tile = findTile(tile_x, tile_y);
+                if (tile) visit(tile_x, tile_y, *tile);
+            }
+        }
+        return;
+    }
+
+    for (const auto& key_and_tile : tiles){
+        int tile_x = (int32_t)(key_and_tile.first >> 32), tile_y = (int32_t)(uint32_t)key_and_tile.first;
+        if (tile_left <= tile_x && tile_x <= tile_right && tile_top <= tile_y && tile_y <= tile_bottom) visit(tile_x, tile_y, key_and_tile.second);
+    }
+}
+
+// Only the tiles at the edges of the tiles' bounding box can hold the extreme cells, so only their rows are read (the others, only by their coordinates).
+BoundingBox TiledEngine::boundingBox() const{
+    BoundingBox tile_box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    for (const auto& key_and_tile : tiles){
+        if (key_and_tile.second.population == 0) continue; // Emptied by 'erase()', and not dropped yet
+
+        int tile_x = (int32_t)(key_and_tile.first >> 32), tile_y = (int32_t)(uint32_t)key_and_tile.first;
+        tile_box.left = std::min(tile_box.left, tile_x);
+        tile_box.top = std::min(tile_box.top, tile_y);
+        tile_box.right = std::max(tile_box.right, tile_x);
+        tile_box.bottom = std::max(tile_box.bottom, tile_y);
+    }
+
+    BoundingBox box = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    for (const auto& key_and_tile : tiles){
+        if (key_and_tile.second.population == 0) continue;
+        int tile_x = (int32_t)(key_and_tile.first >> 32), tile_y = (int32_t)(uint32_t)key_and_tile.first;
+        if (tile_x != tile_box.left && tile_x != tile_box.right && tile_y != tile_box.top && tile_y != tile_box.bottom) continue;
+
+        uint64_t columns = 0; // The columns that have a live cell in any row
+        int first_row = -1, last_row = -1;
+        for (int i = 0; i < TILE_SIZE; i++){
+            if (key_and_tile.second.cells.rows[i] == 0) continue;
+
+            columns |= key_and_tile.second.cells.rows[i];
+            if (first_row == -1) first_row = i;
+            last_row = i;
+        }
+
+        box.left = std::min(box.left, tile_x * TILE_SIZE + countTrailingZeros64(columns));
+        box.right = std::max(box.right, tile_x * TILE_SIZE + TILE_SIZE - 1 - countLeadingZeros64(columns));
+        box.top = std::min(box.top, tile_y * TILE_SIZE + first_row);
+        box.bottom = std::max(box.bottom, tile_y * TILE_SIZE + last_row);
+    }
+
+    return box;
+}
+
+void TiledEngine::forEachTile(const std::function<void(const BitmapTile&)>& func) const{
+    BitmapTile tile;
+    for (const auto& key_and_tile : tiles){
+        if (key_and_tile.second.population == 0) continue; // Emptied by 'erase()', and not dropped yet
+
+        tile.tile_x = (int32_t)(key_and_tile.first >> 32);
+        tile.tile_y = (int32_t)(uint32_t)key_and_tile.first;
+        std::copy(key_and_tile.second.cells.rows, key_and_tile.second.cells.rows + TILE_SIZE, tile.rows);
+        func(tile);
+    }
+}
+
+// The powers of the hash bases inside a tile, so that the signatures of the tiles don't go through 'hashPowerX()' for every cell.
+struct TilePowers{
+    uint64_t x[TILE_SIZE], y[TILE_SIZE];
+
+    TilePowers(){
+        x[0] = y[0] = 1;
+        for (int i = 1; i < TILE_SIZE; i++){
+            x[i] = hashMultiply(x[i - 1], STATE_HASH_BASE_X);
+            y[i] = hashMultiply(y[i - 1], STATE_HASH_BASE_Y);
+        }
+    }
+};
+static const TilePowers tile_powers;
+
+/* Updates the signature of a tile from the cells that are born and the cells that die between 'cells' and 'next'.
+In a settled region that's a lot fewer cells than the live ones (and in a still one, none at all). */
+static void addChangesToSignature(StateSignature& signature, const Tile& cells, const Tile& next){
+    for (int i = 0; i < TILE_SIZE; i++){
+        uint64_t births = next.rows[i] & ~cells.rows[i], deaths = cells.rows[i] & ~next.rows[i];
+        if (!(births | deaths)) continue;
+
+        // The row's power of Y is the same for all of its cells, so we multiply by it once
+        int change = popcount64(births) - popcount64(deaths);
+        uint64_t row_hash = 0, row_sum_x = 0;
+        for (; births; births &= births - 1){
+            int x = countTrailingZeros64(births);
+            row_hash = hashAdd(row_hash, tile_powers.x[x]);
+            row_sum_x += x;
+        }
+        for (; deaths; deaths &= deaths - 1){
+            int x = countTrailingZeros64(deaths);
+            row_hash = hashSubtract(row_hash, tile_powers.x[x]);
+            row_sum_x -= x;
+        }
+
+        signature.hash = hashAdd(signature.hash, hashMultiply(row_hash, tile_powers.y[i]));
+        signature.population += change;
+        signature.sum_x += row_sum_x;
+        signature.sum_y += (long long int)change * i;
+    }
+}
+
+/* The first call computes the signatures of all the tiles (and of their previous cells, which flipped tiles swap in) from scratch.
+From then on 'step()' updates them from the births and deaths of the tiles it computes. */
+StateSignature TiledEngine::signature(){
+    if (!tracks_signature){
+        cells_signature = {};
+        for (auto& key_and_tile : tiles){
+            TrackedTile& tile = key_and_tile.second;
+            tile.signature = tile.previous_signature = {};
+            addChangesToSignature(tile.signature, empty_tile, tile.cells);
+            addChangesToSignature(tile.previous_signature, empty_tile, tile.previous);
+            addSignature(cells_signature, tile.signature, tileLeft(key_and_tile.first), tileTop(key_and_tile.first));
+        }
+        tracks_signature = true;
+    }
+
+    return cells_signature;
+}
+
+// Fills the 3x3 tiles around (and including) the given tile, with nullptr for the ones that aren't allocated.
+void TiledEngine::findNeighborhood(int tile_x, int tile_y, const TrackedTile* neighborhood[3][3]) const{
+    for (int dy = -1; dy <= 1; dy++){
+        for (int dx = -1; dx <= 1; dx++){
+            neighborhood[dy + 1][dx + 1] = findTile(tile_x + dx, tile_y + dy);
+        }
+    }
+}
+
+/* Computes the next generation of the middle tile of the neighborhood into 'next'.
+We build the 3 arrays the kernel expects, each holding the rows of the tile plus one row above and one row below (taken from the neighbor tiles):
+'center' is the rows themselves, 'left' is every row shifted so that bit 'i' holds the cell to the left of cell 'i',
+and 'right' is the same, only with the cell to the right. The missing bit at the edge of the shift comes from the neighbor tile. */
+void TiledEngine::stepTile(const TrackedTile* const neighborhood[3][3], Tile& next) const{
+    const Tile* neighbors[3][3];
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 3; j++) neighbors[i][j] = neighborhood[i][j] ? &neighborhood[i][j]->cells : &empty_tile;
+    }
+
+    alignas(64) uint64_t left[TILE_SIZE + 2], center[TILE_SIZE + 2], right[TILE_SIZE + 2];
+    for (int i = 0; i < TILE_SIZE + 2; i++){
+        // Index 0 is the last row of the tile above, and index 'TILE_SIZE + 1' is the first row of the tile below.
+        int tile_row = i == 0 ? 0 : (i == TILE_SIZE + 1 ? 2 : 1);
+        int row = (i - 1) & (TILE_SIZE - 1);
+
+        uint64_t west = neighbors[tile_row][0]->rows[row], east = neighbors[tile_row][2]->rows[row];
+        center[i] = neighbors[tile_row][1]->rows[row];
+        left[i] = center[i] << 1 | west >> (TILE_SIZE - 1);
+        right[i] = center[i] >> 1 | east << (TILE_SIZE - 1);
+    }
+
+    kernel(left, center, right, next.rows, rule.getBornMask(), rule.getSurviveMask());
+}
+
+// Adds the tile and the neighbor tiles that the set bits in 'rows' touch (bits on the top row touch the tile above, and so on).
+void TiledEngine::addBorderCandidates(int tile_x, int tile_y, const uint64_t* rows){
+    candidate_keys.insert({tile_x, tile_y});
+
+    uint64_t columns = 0; // Bit 'i' is on if column 'i' has a set bit
+    for (int i = 0; i < TILE_SIZE; i++) columns |= rows[i];
+    bool west = columns & 1, east = columns >> (TILE_SIZE - 1);
+    bool north = rows[0], south = rows[TILE_SIZE - 1];
+
+    if (north) candidate_keys.insert({tile_x, tile_y - 1});
+    if (south) candidate_keys.insert({tile_x, tile_y + 1});
+    if (west) candidate_keys.insert({tile_x - 1, tile_y});
+    if (east) candidate_keys.insert({tile_x + 1, tile_y});
+    if (rows[0] & 1) candidate_keys.insert({tile_x - 1, tile_y - 1});
+    if (rows[0] >> (TILE_SIZE - 1)) candidate_keys.insert({tile_x + 1, tile_y - 1});
+    if (rows[TILE_SIZE - 1] & 1) candidate_keys.insert({tile_x - 1, tile_y + 1});
+    if (rows[TILE_SIZE - 1] >> (TILE_SIZE - 1)) candidate_keys.insert({tile_x + 1, tile_y + 1});
+}
+
+// Writes the next generation of a tile, and updates its change flags. Tiles that have been empty for 3 generations are dropped.
+void TiledEngine::updateTile(uint64_t key, const Tile& next, const StateSignature& next_signature){
+    int next_population = 0;
+    for (const auto& row : next.rows) next_population += popcount64(row);
+
+    auto iter = tiles.find(key);
+    if (iter == tiles.end()){
+        // An unallocated tile was empty for the last 2 generations, so if it's still empty nothing happened.
+        if (next_population == 0) return;
+        iter = tiles.emplace(key, TrackedTile()).first;
+    }
+
+    TrackedTile& tile = iter->second;
+    tile.changed = std::memcmp(next.rows, tile.cells.rows, sizeof(Tile)) != 0;
+    tile.changed_since_two = std::memcmp(next.rows, tile.previous.rows, sizeof(Tile)) != 0;
+    tile.previous = tile.cells;
+    tile.cells = next;
+    tile.previous_population = tile.population;
+    tile.population = next_population;
+    live_cells += tile.population - tile.previous_population;
+    if (tracks_signature){
+        if (tile.changed){
+            subtractSignature(cells_signature, tile.signature, tileLeft(key), tileTop(key));
+            addSignature(cells_signature, next_signature, tileLeft(key), tileTop(key));
+        }
+        tile.previous_signature = tile.signature;
+        tile.signature = next_signature;
+    }
+
+    if (tile.changed || tile.changed_since_two) active_keys.push_back(key);
+    else if (next_population == 0) tiles.erase(iter);
+}
+
+/* The next generation of a period-2 tile is its previous one, so we just swap them. No need to compare anything either:
+it differs from the current cells exactly when the current cells differed from the previous ones, and it's equal to the cells 2 generations ago. */
+void TiledEngine::flipTile(uint64_t key){
+    auto iter = tiles.find(key);
+    if (iter == tiles.end()) return; // It was empty, so it stays empty
+
+    TrackedTile& tile = iter->second;
+    std::swap(tile.cells, tile.previous);
+    std::swap(tile.population, tile.previous_population);
+    live_cells += tile.population - tile.previous_population;
+    if (tracks_signature){
+        if (tile.changed){
+            subtractSignature(cells_signature, tile.signature, tileLeft(key), tileTop(key));
+            addSignature(cells_signature, tile.previous_signature, tileLeft(key), tileTop(key));
+        }
+        std::swap(tile.signature, tile.previous_signature);
+    }
+    tile.changed_since_two = false;
+
+    if (tile.changed) active_keys.push_back(key);
+    else if (tile.population == 0) tiles.erase(iter);
+}
+
+/* A tile can change only if it has live cells, or if it's adjacent to a tile with live cells on their common border.
+Moreover, a tile is a function of its 3x3 neighborhood in the previous generation, so:
+-If none of the 9 tiles changed in the last generation, the tile won't change either - we don't even look at it.
+-If none of the 9 tiles changed compared to 2 generations ago, the tile will be what it was 2 generations ago (period 2, like blinkers)
+- we swap in its previous cells instead of computing them (see 'flipTile()').
+So we take the tiles that changed in the last generation, plus the neighbor tiles that the changes on their borders touch,
+and only those are stepped. In a settled soup that's a small fraction of the tiles.
+After an edit there's nothing to trust, so we take every allocated tile (plus the neighbor tiles that live cells on its borders can spill into).
+
+The candidate tiles are split into chunks, which the thread pool computes in parallel (they only read 'tiles', so there's no locking).
+Every tile has its own output slot, and we apply the outputs in order, so the result doesn't depend on the thread timing. */
+void TiledEngine::step(){
+    PROFILE_SCOPE("TiledEngine::step");
+    bool is_full_step = 0 < full_steps;
+    candidate_keys.clear();
+
+    if (is_full_step){
+        for (const auto& key_and_tile : tiles){
+            addBorderCandidates((int32_t)(key_and_tile.first >> 32), (int32_t)(uint32_t)key_and_tile.first, key_and_tile.second.cells.rows);
+        }
+    }
+    else{
+        for (uint64_t key : active_keys){
+            const TrackedTile& tile = tiles.at(key);
+            if (!tile.changed) continue;
+
+            uint64_t changes[TILE_SIZE];
+            for (int i = 0; i < TILE_SIZE; i++) changes[i] = tile.cells.rows[i] ^ tile.previous.rows[i];
+            addBorderCandidates((int32_t)(key >> 32), (int32_t)(uint32_t)key, changes);
+        }
+    }
+
+    keys.clear();
+    candidate_keys.forEach([this](const Cell& tile_coordinate){
+        keys.push_back(tileKey(tile_coordinate.x, tile_coordinate.y));
+    });
+    next_tiles.resize(keys.size());
+    if (tracks_signature) next_signatures.resize(keys.size());
+    flips.resize(keys.size());
+    size_t chunk_count = (keys.size() + TILES_PER_TASK - 1) / TILES_PER_TASK;
+
+    auto stepChunk = [&](size_t chunk, int /*worker*/){
+        size_t last = std::min(keys.size(), (chunk + 1) * TILES_PER_TASK);
+        for (size_t i = chunk * TILES_PER_TASK; i < last; i++){
+            const TrackedTile* neighborhood[3][3];
+            findNeighborhood((int32_t)(keys[i] >> 32), (int32_t)(uint32_t)keys[i], neighborhood);
+
+            bool is_period_two = !is_full_step;
+            for (int j = 0; j < 9 && is_period_two; j++){
+                const TrackedTile* tile = neighborhood[j / 3][j % 3];
+                if (tile && tile->changed_since_two) is_period_two = false;
+            }
+
+            flips[i] = is_period_two;
+            if (is_period_two) continue;
+
+            stepTile(neighborhood, next_tiles[i]);
+            if (tracks_signature){
+                const TrackedTile* current = neighborhood[1][1];
+                next_signatures[i] = current ? current->signature : StateSignature();
+                addChangesToSignature(next_signatures[i], current ? current->cells : empty_tile, next_tiles[i]);
+            }
+        }
+    };
+    if (thread_pool) thread_pool->parallelFor(chunk_count, stepChunk);
+    else for (size_t chunk = 0; chunk < chunk_count; chunk++) stepChunk(chunk, 0);
+
+    /* The tiles that were active but aren't candidates didn't change in the last generation, and won't change in this one -
+    so they haven't changed for 2 generations. We clear their flags before updating the candidates, which rebuilds 'active_keys'. */
+    for (uint64_t key : active_keys){
+        if (candidate_keys.count({(int32_t)(key >> 32), (int32_t)(uint32_t)key})) continue;
+
+        auto iter = tiles.find(key);
+        iter->second.changed_since_two = false;
+        if (iter->second.population == 0) tiles.erase(iter);
+    }
+    active_keys.clear();
+
+    for (size_t i = 0; i < keys.size(); i++){
+        if (flips[i]) flipTile(keys[i]);
+        else updateTile(keys[i], next_tiles[i], tracks_signature ? next_signatures[i] : StateSignature());
+    }
+
+    if (is_full_step) full_steps--;
+    generation++;
+}
@@ -0,0 +1,92 @@
+#ifndef GAME_OF_LIFE_TILED_ENGINE_H
+#define GAME_OF_LIFE_TILED_ENGINE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "engine.h"
+#include "flat_cell_table.h"
+#include "step_kernel.h"
+#include "thread_pool.h"
+
+#define TILE_SIZE BITMAP_TILE_SIZE // Must be equal to the amount of bits in a row word
+#define TILES_PER_TASK 16 // How many tiles a worker thread computes in one go
+#define FULL_STEPS_AFTER_EDIT 2 // See 'invalidateTracking()'
+
+// 64x64 block of cells. Bit 'i' of 'rows[j]' is the cell in column 'i' and row 'j' of the tile.
+struct Tile{
+    uint64_t rows[TILE_SIZE];
+};
+
+// A tile, together with what 'step()' needs to know to skip it.
+struct TrackedTile{
+    Tile cells;
+    Tile previous; // The cells one generation ago
+    int population, previous_population;
+    // The signatures of 'cells' and 'previous', relative to the top-left corner of the tile. Kept up to date only while the engine tracks its signature.
+    StateSignature signature, previous_signature;
+    bool changed; // 'cells' differs from the cells one generation ago
+    bool changed_since_two; // 'cells' differs from the cells two generations ago
+};
+
+/* Stores the universe as 64x64 tiles, where every row of a tile is a single 64-bit word.
+Only tiles that contain live cells are allocated, so the space complexity is O(num of tiles with live cells).
+On a step, we compute the neighbor counts of an entire row at once with bit-parallel adders (see 'step_kernel_impl.h'),
+so instead of hashing every cell (and its 8 neighbors), we do a few dozens of word operations per 64 cells
+(and with SIMD, per 128-512 cells).
+On top of that, every tile remembers whether it changed in the last 2 generations, so that still regions (and period-2 oscillators)
+are carried over without computing them at all - see 'step()'. */
+class TiledEngine: public Engine{
+private:
+    std::unordered_map<uint64_t, TrackedTile> tiles; // Maps a packed tile coordinate (see 'tileKey()') to the tile
+    unsigned long long int live_cells;
+    bool tracks_signature; // Whether 'signature()' has been called, and so the signatures are updated whenever a tile changes
+    StateSignature cells_signature; // Of all the tiles, in absolute coordinates
+    step_kernel kernel; // The row logic, for the best instruction set of the CPU and (for built-in automata) the current rule
+    std::unique_ptr<ThreadPool> thread_pool; // nullptr when we step on a single thread
+
+    std::vector<uint64_t> active_keys; // The tiles that changed in one of the last 2 generations
+    int full_steps; // How many of the next steps must compute every tile, without trusting the change tracking
+
+    // Scratch space of 'step()'. They're members, so that their storage is reused by every generation.
+    CellSet candidate_keys; // Keyed by tile coordinates
+    std::vector<uint64_t> keys;
+    std::vector<Tile> next_tiles; // The next generation of 'keys[i]'
+    std::vector<StateSignature> next_signatures; // The signature of 'next_tiles[i]', when the signature is tracked
+    std::vector<uint8_t> flips; // Whether 'keys[i]' is in a period-2 region, so its next generation is its previous one (and 'next_tiles[i]' is unused)
+
+    static uint64_t tileKey(int tile_x, int tile_y);
+    static long long int tileLeft(uint64_t key);
+    static long long int tileTop(uint64_t key);
+    const TrackedTile* findTile(int tile_x, int tile_y) const;
+    void invalidateTracking();
+    void findNeighborhood(int tile_x, int tile_y, const TrackedTile* neighborhood[3][3]) const;
+    void stepTile(const TrackedTile* const neighborhood[3][3], Tile& next) const;
+    void addBorderCandidates(int tile_x, int tile_y, const uint64_t* rows);
+    void updateTile(uint64_t key, const Tile& next, const StateSignature& next_signature);
+    void flipTile(uint64_t key);
+
+public:
+    TiledEngine();
+
+    void setRule(const Rule& new_rule) override;
+    void setThreadCount(int thread_count) override;
+
+    void insert(const Cell& cell) override;
+    void erase(const Cell& cell) override;
+    void insertCells(const std::vector<Cell>& cells) override;
+    void insertTiles(const BitmapTile* tiles, size_t count) override;
+    bool count(const Cell& cell) const override;
+    void clear() override;
+    unsigned long long int population() const override;
+    void forEachCell(const std::function<void(const Cell&)>& func) const override;
+    void forEachCellInRect(const BoundingBox& rect, const std::function<void(const Cell&)>& func) const override;
+    BoundingBox boundingBox() const override;
+    void forEachTile(const std::function<void(const BitmapTile&)>& func) const override;
+    StateSignature signature() override;
+
+    void step() override;
+};
+
+#endif